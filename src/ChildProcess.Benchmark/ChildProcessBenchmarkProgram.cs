@@ -0,0 +1,20 @@
+// Copyright (c) @asmichi (https://github.com/asmichi). Licensed under the MIT License. See LICENCE in the project root for details.
+
+using BenchmarkDotNet.Running;
+
+namespace Asmichi
+{
+    internal static class ChildProcessBenchmarkProgram
+    {
+        public static void Main(string[] args)
+        {
+            if (args.Length >= 1 && args[0] == "stdio-buffer")
+            {
+                StdioBufferSizeHarness.Run(args);
+                return;
+            }
+
+            BenchmarkSwitcher.FromAssembly(typeof(ChildProcessBenchmarkProgram).Assembly).Run(args);
+        }
+    }
+}
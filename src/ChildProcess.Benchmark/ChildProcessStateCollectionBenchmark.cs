@@ -0,0 +1,149 @@
+// Copyright (c) @asmichi (https://github.com/asmichi). Licensed under the MIT License. See LICENCE in the project root for details.
+
+using System.Collections.Concurrent;
+using System.Collections.Generic;
+using System.Threading;
+using BenchmarkDotNet.Attributes;
+
+namespace Asmichi
+{
+    /// <summary>
+    /// Contention on the registry of child process states (UnixChildProcessState.ChildProcessStateCollection):
+    /// spawning threads allocate, look up and remove states while the thread processing exit notifications keeps looking them up.
+    /// </summary>
+    /// <remarks>
+    /// The registry is private to the library; both implementations are replicated here.
+    /// </remarks>
+    public class ChildProcessStateCollectionBenchmark
+    {
+        private const int OperationsPerThread = 20000;
+
+        [Params(1, 4, 16)]
+        public int ThreadCount { get; set; }
+
+        [Benchmark(Baseline = true)]
+        public void LockedDictionary() => Run(new LockedDictionaryCollection());
+
+        [Benchmark]
+        public void ConcurrentDictionary() => Run(new ConcurrentDictionaryCollection());
+
+        private void Run(IStateCollection collection)
+        {
+            var spawners = new Thread[ThreadCount];
+            for (int i = 0; i < spawners.Length; i++)
+            {
+                spawners[i] = new Thread(() => RunSpawner(collection));
+            }
+
+            var isDone = false;
+            var notificationThread = new Thread(() => RunNotificationThread(collection, ref isDone));
+
+            notificationThread.Start();
+            foreach (var t in spawners)
+            {
+                t.Start();
+            }
+
+            foreach (var t in spawners)
+            {
+                t.Join();
+            }
+
+            Volatile.Write(ref isDone, true);
+            notificationThread.Join();
+        }
+
+        // Models ChildProcess.Start and ChildProcessImpl.Dispose.
+        private static void RunSpawner(IStateCollection collection)
+        {
+            for (int i = 0; i < OperationsPerThread; i++)
+            {
+                var state = collection.Create();
+                collection.TryGet(state.Token, out _);
+                collection.Remove(state);
+            }
+        }
+
+        // Models the thread processing exit notifications: it looks up the latest processes.
+        private static void RunNotificationThread(IStateCollection collection, ref bool isDone)
+        {
+            while (!Volatile.Read(ref isDone))
+            {
+                var latestToken = collection.LatestToken;
+                for (long token = latestToken; token > latestToken - 16 && token > 0; token--)
+                {
+                    collection.TryGet(token, out _);
+                }
+            }
+        }
+
+        private interface IStateCollection
+        {
+            long LatestToken { get; }
+            State Create();
+            bool TryGet(long token, out State? state);
+            void Remove(State state);
+        }
+
+        private sealed class State
+        {
+            public State(long token) => Token = token;
+            public long Token { get; }
+        }
+
+        // Before: every operation takes the lock.
+        private sealed class LockedDictionaryCollection : IStateCollection
+        {
+            private readonly Dictionary<long, State> _states = new Dictionary<long, State>();
+            private long _prevToken;
+
+            public long LatestToken => Volatile.Read(ref _prevToken);
+
+            public State Create()
+            {
+                var state = new State(Interlocked.Increment(ref _prevToken));
+                lock (_states)
+                {
+                    _states.Add(state.Token, state);
+                }
+                return state;
+            }
+
+            public bool TryGet(long token, out State? state)
+            {
+                lock (_states)
+                {
+                    return _states.TryGetValue(token, out state);
+                }
+            }
+
+            public void Remove(State state)
+            {
+                lock (_states)
+                {
+                    _states.Remove(state.Token);
+                }
+            }
+        }
+
+        // After: lock-free reads.
+        private sealed class ConcurrentDictionaryCollection : IStateCollection
+        {
+            private readonly ConcurrentDictionary<long, State> _states = new ConcurrentDictionary<long, State>();
+            private long _prevToken;
+
+            public long LatestToken => Volatile.Read(ref _prevToken);
+
+            public State Create()
+            {
+                var state = new State(Interlocked.Increment(ref _prevToken));
+                _states.TryAdd(state.Token, state);
+                return state;
+            }
+
+            public bool TryGet(long token, out State? state) => _states.TryGetValue(token, out state);
+
+            public void Remove(State state) => _states.TryRemove(state.Token, out _);
+        }
+    }
+}
@@ -0,0 +1,95 @@
+// Copyright (c) @asmichi (https://github.com/asmichi). Licensed under the MIT License. See LICENCE in the project root for details.
+
+using System;
+using System.Diagnostics;
+using System.Globalization;
+using System.IO;
+using System.Runtime.InteropServices;
+using Asmichi.ProcessManagement;
+
+namespace Asmichi
+{
+    /// <summary>
+    /// Measures the effect of <see cref="ChildProcessStartInfo.StdioBufferSize"/>: a child streams zeros to stdout (OutputPipe or Tee)
+    /// while the current process reads them. Reports the throughput and the context switches of the child.
+    /// Not a BenchmarkDotNet benchmark because the context switches are counted in the child.
+    /// </summary>
+    internal static class StdioBufferSizeHarness
+    {
+        private const int Repetitions = 3;
+
+        // stdio-buffer testChildNativePath [megabytes]
+        public static void Run(string[] args)
+        {
+            if (args.Length < 2 || RuntimeInformation.IsOSPlatform(OSPlatform.Windows))
+            {
+                Console.Error.WriteLine("Usage (Unix only): stdio-buffer path/to/TestChildNative [megabytes]");
+                return;
+            }
+
+            var testChildNativePath = args[1];
+            var megabytes = args.Length >= 3 ? int.Parse(args[2], CultureInfo.InvariantCulture) : 400;
+            var bytes = (long)megabytes * 1000 * 1000;
+
+            Console.WriteLine("| Redirection | StdioBufferSize | MB/s | Voluntary CS | Involuntary CS |");
+            Console.WriteLine("|-------------|-----------------|-----:|-------------:|---------------:|");
+
+            foreach (var redirection in new[] { OutputRedirection.OutputPipe, OutputRedirection.Tee })
+            {
+                foreach (var bufferSize in new int?[] { null, 64 * 1024, 256 * 1024, 1024 * 1024 })
+                {
+                    for (int i = 0; i < Repetitions; i++)
+                    {
+                        var (megabytesPerSecond, contextSwitches) = Measure(testChildNativePath, bytes, redirection, bufferSize);
+                        var volInv = contextSwitches.Split(' ');
+                        Console.WriteLine(FormattableString.Invariant(
+                            $"| {redirection} | {bufferSize?.ToString(CultureInfo.InvariantCulture) ?? "default"} | {megabytesPerSecond:F0} | {volInv[0]} | {volInv[1]} |"));
+                    }
+                }
+            }
+        }
+
+        private static (double MegabytesPerSecond, string ContextSwitches) Measure(
+            string testChildNativePath,
+            long bytes,
+            OutputRedirection redirection,
+            int? bufferSize)
+        {
+            using var nullDevice = File.OpenWrite("/dev/null");
+            var si = new ChildProcessStartInfo(testChildNativePath, "WriteZeros", bytes.ToString(CultureInfo.InvariantCulture))
+            {
+                StdOutputRedirection = redirection,
+                StdErrorRedirection = OutputRedirection.ErrorPipe,
+                StdioBufferSize = bufferSize,
+            };
+            if (redirection == OutputRedirection.Tee)
+            {
+                // The child is read by the current process (through the helper) and the helper also copies the output to /dev/null.
+                si.StdOutputTeeSinks = new[] { new ChildProcessTeeSink(nullDevice.SafeFileHandle) };
+            }
+
+            var buffer = new byte[1024 * 1024];
+            var sw = Stopwatch.StartNew();
+            using var sut = ChildProcess.Start(si);
+
+            long total = 0;
+            int n;
+            while ((n = sut.StandardOutput.Read(buffer, 0, buffer.Length)) > 0)
+            {
+                total += n;
+            }
+
+            var elapsed = sw.Elapsed;
+            using var errorReader = new StreamReader(sut.StandardError);
+            var contextSwitches = errorReader.ReadToEnd();
+            sut.WaitForExit();
+
+            if (sut.ExitCode != 0 || total != bytes)
+            {
+                throw new InvalidOperationException($"The child failed: exit code {sut.ExitCode}, {total} bytes read, {contextSwitches}");
+            }
+
+            return (total / elapsed.TotalSeconds / 1e6, contextSwitches);
+        }
+    }
+}
@@ -6,10 +6,13 @@
 #include <memory>
 #include <mutex>
 #include <signal.h>
+#include <sys/resource.h>
+#include <sys/time.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <unistd.h>
 #include <unordered_map>
+#include <vector>
 
 void ChildProcessState::Reap()
 {
@@ -20,11 +23,24 @@ void ChildProcessState::Reap()
         return;
     }
 
-    siginfo_t siginfo;
-    int ret = waitid(P_PID, pid_, &siginfo, WEXITED | WNOHANG);
+    // Reaping a member frees the process group ID of its job (if last); keep the job from signaling the group meanwhile.
+    std::unique_lock<std::mutex> jobLock;
+    if (job_)
+    {
+        jobLock = std::unique_lock<std::mutex>(job_->GetMutex());
+    }
+
+    int status;
+    struct rusage ru;
+    int ret = wait4(pid_, &status, WNOHANG, &ru);
     if (ret < 0)
     {
-        FatalErrorAbort(errno, "waitpid");
+        FatalErrorAbort(errno, "wait4");
+    }
+
+    if (job_)
+    {
+        job_->RemoveMemberLocked(ru);
     }
 
     isReaped_ = true;
@@ -49,9 +65,9 @@ bool ChildProcessState::SendSignal(int sig, bool alsoSendSigCont) const
     return ret == 0;
 }
 
-void ChildProcessStateMap::Allocate(int pid, std::uint64_t token, bool isNewProcessGroup, bool shouldAutoTerminate)
+void ChildProcessStateMap::Allocate(int pid, std::uint64_t token, bool isNewProcessGroup, bool shouldAutoTerminate, std::shared_ptr<JobState> job)
 {
-    const auto pState = std::make_shared<ChildProcessState>(pid, token, isNewProcessGroup, shouldAutoTerminate);
+    const auto pState = std::make_shared<ChildProcessState>(pid, token, isNewProcessGroup, shouldAutoTerminate, std::move(job));
 
     const std::lock_guard<std::mutex> guard(mapMutex_);
 
@@ -93,6 +109,19 @@ std::shared_ptr<ChildProcessState> ChildProcessStateMap::GetByToken(std::uint64_
     }
 }
 
+void ChildProcessStateMap::GetByTokens(const std::vector<std::uint64_t>& tokens, std::vector<std::shared_ptr<ChildProcessState>>* states) const
+{
+    states->clear();
+    states->reserve(tokens.size());
+
+    const std::lock_guard<std::mutex> guard(mapMutex_);
+    for (const auto token : tokens)
+    {
+        const auto it = byToken_.find(token);
+        states->push_back(it == byToken_.end() ? nullptr : it->second);
+    }
+}
+
 void ChildProcessStateMap::Delete(ChildProcessState* pState)
 {
     const auto pid = pState->GetPid();
@@ -110,6 +139,12 @@ void ChildProcessStateMap::Delete(ChildProcessState* pState)
     byToken_.erase(tokenIt);
 }
 
+std::size_t ChildProcessStateMap::Size() const
+{
+    const std::lock_guard<std::mutex> guard(mapMutex_);
+    return byToken_.size();
+}
+
 void ChildProcessStateMap::AutoTerminateAll()
 {
     const std::lock_guard<std::mutex> guard(mapMutex_);
@@ -0,0 +1,261 @@
+// Copyright (c) @asmichi (https://github.com/asmichi). Licensed under the MIT License. See LICENCE in the project root for details.
+
+#include "EventTrace.hpp"
+#include "MiscHelpers.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace
+{
+    struct TraceEvent final
+    {
+        std::uint64_t TimestampNanoseconds;
+        std::uint64_t Token;
+        TraceEventType Type;
+        std::int32_t Arg;
+    };
+    static_assert(sizeof(TraceEvent) == 24);
+
+    // Single writer (the owning thread), multiple readers (dumps).
+    class TraceRing final
+    {
+    public:
+        static constexpr std::size_t Capacity = 4096;
+
+        explicit TraceRing(int id) noexcept : id_(id) {}
+
+        int GetId() const noexcept { return id_; }
+        const char* GetName() const noexcept { return name_.load(std::memory_order_relaxed); }
+        void SetName(const char* name) noexcept { name_.store(name, std::memory_order_relaxed); }
+
+        [[nodiscard]] bool TryAcquire() noexcept { return !inUse_.exchange(true, std::memory_order_acquire); }
+        void Release() noexcept { inUse_.store(false, std::memory_order_release); }
+
+        void Record(const TraceEvent& e) noexcept
+        {
+            const auto index = writeIndex_.load(std::memory_order_relaxed);
+            events_[index % Capacity] = e;
+            writeIndex_.store(index + 1, std::memory_order_release);
+        }
+
+        // Copies the events that were not overwritten during the copy.
+        void CopyTo(std::vector<TraceEvent>* events) const
+        {
+            const auto end = writeIndex_.load(std::memory_order_acquire);
+            const auto start = end > Capacity ? end - Capacity : 0;
+
+            std::vector<TraceEvent> copied;
+            copied.reserve(end - start);
+            for (auto i = start; i < end; i++)
+            {
+                copied.push_back(events_[i % Capacity]);
+            }
+
+            // Discard the events the writer may have overwritten meanwhile (seqlock-style validation).
+            std::atomic_thread_fence(std::memory_order_acquire);
+            const auto endAfterCopy = writeIndex_.load(std::memory_order_relaxed);
+            const auto validStart = endAfterCopy > Capacity ? std::max(start, endAfterCopy - Capacity) : start;
+            events->insert(events->end(), copied.begin() + (validStart - start), copied.end());
+        }
+
+    private:
+        const int id_;
+        std::atomic<const char*> name_{"thread"};
+        std::atomic<bool> inUse_{false};
+        std::atomic<std::uint64_t> writeIndex_{0};
+        TraceEvent events_[Capacity]{};
+    };
+
+    class TraceRingRegistry final
+    {
+    public:
+        // Returns nullptr on allocation failure.
+        TraceRing* Acquire() noexcept
+        {
+            const std::lock_guard<std::mutex> guard(mutex_);
+
+            for (const auto& pRing : rings_)
+            {
+                if (pRing->TryAcquire())
+                {
+                    return pRing.get();
+                }
+            }
+
+            try
+            {
+                auto pRing = std::make_unique<TraceRing>(static_cast<int>(rings_.size()) + 1);
+                static_cast<void>(pRing->TryAcquire());
+                rings_.push_back(std::move(pRing));
+                return rings_.back().get();
+            }
+            catch (const std::bad_alloc&)
+            {
+                return nullptr;
+            }
+        }
+
+        template<typename Func>
+        void ForEach(Func f) const
+        {
+            const std::lock_guard<std::mutex> guard(mutex_);
+            for (const auto& pRing : rings_)
+            {
+                f(*pRing);
+            }
+        }
+
+    private:
+        mutable std::mutex mutex_;
+        std::vector<std::unique_ptr<TraceRing>> rings_;
+    };
+
+    TraceRingRegistry g_TraceRingRegistry;
+
+    // Returns the ring to the registry when the thread exits.
+    struct ThreadTraceRing final
+    {
+        ~ThreadTraceRing()
+        {
+            if (pRing != nullptr)
+            {
+                pRing->Release();
+            }
+        }
+
+        TraceRing* Get() noexcept
+        {
+            if (pRing == nullptr && !acquisitionFailed)
+            {
+                pRing = g_TraceRingRegistry.Acquire();
+                acquisitionFailed = pRing == nullptr;
+            }
+            return pRing;
+        }
+
+        TraceRing* pRing = nullptr;
+        bool acquisitionFailed = false;
+    };
+
+    thread_local ThreadTraceRing t_TraceRing;
+
+    void AppendChromeEvent(std::string* json, const TraceEvent& e, int pid, int tid)
+    {
+        const char* name;
+        const char* phase = "i";
+        switch (e.Type)
+        {
+        case TraceEventType::RequestReceived:
+            name = "request";
+            break;
+        case TraceEventType::Fork:
+            name = "spawn";
+            phase = "B";
+            break;
+        case TraceEventType::ExecReleased:
+            name = "exec released";
+            break;
+        case TraceEventType::ExecResult:
+            name = "spawn";
+            phase = "E";
+            break;
+        case TraceEventType::ChildSignal:
+            name = "SIGCHLD";
+            break;
+        case TraceEventType::Reap:
+            name = "reap";
+            break;
+        case TraceEventType::NotificationFlushed:
+            name = "notification flushed";
+            break;
+        default:
+            name = "unknown";
+            break;
+        }
+
+        char buf[256];
+        std::snprintf(
+            buf,
+            sizeof(buf),
+            "{\"name\":\"%s\",\"ph\":\"%s\",%s\"ts\":%" PRIu64 ".%03u,\"pid\":%d,\"tid\":%d,\"args\":{\"token\":%" PRIu64 ",\"arg\":%" PRId32 "}},\n",
+            name,
+            phase,
+            phase[0] == 'i' ? "\"s\":\"t\"," : "",
+            e.TimestampNanoseconds / 1000,
+            static_cast<unsigned int>(e.TimestampNanoseconds % 1000),
+            pid,
+            tid,
+            e.Token,
+            e.Arg);
+        json->append(buf);
+    }
+} // namespace
+
+void RecordTraceEvent(TraceEventType type, std::uint64_t token, std::int32_t arg) noexcept
+{
+    auto* const pRing = t_TraceRing.Get();
+    if (pRing == nullptr)
+    {
+        return;
+    }
+
+    TraceEvent e;
+    e.TimestampNanoseconds = GetMonotonicNanoseconds();
+    e.Token = token;
+    e.Type = type;
+    e.Arg = arg;
+    pRing->Record(e);
+}
+
+void SetTraceThreadName(const char* name) noexcept
+{
+    auto* const pRing = t_TraceRing.Get();
+    if (pRing != nullptr)
+    {
+        pRing->SetName(name);
+    }
+}
+
+std::string SerializeTraceAsChromeJson()
+{
+    const int pid = getpid();
+    std::string json = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    std::vector<TraceEvent> events;
+
+    g_TraceRingRegistry.ForEach([&](const TraceRing& ring) {
+        char buf[128];
+        std::snprintf(
+            buf,
+            sizeof(buf),
+            "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s %d\"}},\n",
+            pid,
+            ring.GetId(),
+            ring.GetName(),
+            ring.GetId());
+        json.append(buf);
+
+        events.clear();
+        ring.CopyTo(&events);
+        for (const auto& e : events)
+        {
+            AppendChromeEvent(&json, e, pid, ring.GetId());
+        }
+    });
+
+    // Trailing commas are not allowed.
+    if (json.size() >= 2 && json[json.size() - 2] == ',')
+    {
+        json.erase(json.size() - 2, 1);
+    }
+    json.append("]}\n");
+    return json;
+}
@@ -16,7 +16,9 @@
 #include <fcntl.h>
 #include <memory>
 #include <stdexcept>
+#include <sys/mman.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 #include <unistd.h>
 
@@ -78,6 +80,19 @@ extern "C" bool CreatePipe(intptr_t* readEnd, intptr_t* writeEnd)
     return true;
 }
 
+// Sets the buffer capacity of a pipe or a socket (see SetChannelBufferSize).
+// On error, sets errno and returns false.
+extern "C" bool SetChannelBufferSize(std::intptr_t fd, std::int32_t size)
+{
+    if (!IsWithinFdRange(fd))
+    {
+        errno = EINVAL;
+        return false;
+    }
+
+    return SetChannelBufferSize(static_cast<int>(fd), size);
+}
+
 extern "C" bool CreateUnixStreamSocketPair(intptr_t* sock1, intptr_t* sock2)
 {
     auto maybeSockerPair = CreateUnixStreamSocketPair();
@@ -206,6 +221,66 @@ extern "C" std::intptr_t OpenNullDevice(int fileAccess)
     return open("/dev/null", O_CLOEXEC | nativeAccess);
 }
 
+// Creates an empty read-write temporary file on disk that vanishes when closed (see CreateUnlinkedTemporaryFile).
+// On success, returns the fd.
+// On error, sets errno and returns -1.
+extern "C" std::intptr_t CreateSpillFile()
+{
+    auto maybeFd = CreateUnlinkedTemporaryFile();
+    if (!maybeFd)
+    {
+        return -1;
+    }
+
+    return maybeFd->Release();
+}
+
+// Creates a file to capture output into (see CreateCaptureMemoryFile).
+// On success, returns the fd.
+// On error, sets errno and returns -1.
+extern "C" std::intptr_t CreateCaptureFile(std::int64_t maxLength)
+{
+    auto maybeFd = CreateCaptureMemoryFile(maxLength);
+    if (!maybeFd)
+    {
+        return -1;
+    }
+
+    return maybeFd->Release();
+}
+
+// Maps the captured content of a file created by CreateCaptureFile read-only.
+// The mapping must be released with UnmapCapturedFile.
+extern "C" bool MapCapturedFile(std::intptr_t fd, std::int64_t maxLength, void** outAddr, std::size_t* outLen)
+{
+    if (!IsWithinFdRange(fd))
+    {
+        errno = EINVAL;
+        return false;
+    }
+
+    return MapCapturedMemoryFile(static_cast<int>(fd), maxLength, outAddr, outLen);
+}
+
+extern "C" bool UnmapCapturedFile(void* addr, std::size_t len)
+{
+    return addr == nullptr || munmap(addr, len) == 0;
+}
+
+// Creates a read-only file that has the specified content (see CreateReadOnlyMemoryFile).
+// On success, returns the fd.
+// On error, sets errno and returns -1.
+extern "C" std::intptr_t CreateReadOnlyFile(const void* data, std::size_t len)
+{
+    auto maybeFd = CreateReadOnlyMemoryFile(data, len);
+    if (!maybeFd)
+    {
+        return -1;
+    }
+
+    return maybeFd->Release();
+}
+
 // Creates a subchannel.
 // On success, returns the subchannel fd.
 // On error, sets errno and returns -1.
@@ -295,8 +370,9 @@ extern "C" bool SubchannelSendExactBytes(std::intptr_t subchannelFd, const void*
     return SendExactBytes(static_cast<int>(subchannelFd), buf, len);
 }
 
-// Sends entire data along with fds.
-extern "C" bool SubchannelSendExactBytesAndFds(std::intptr_t subchannelFd, const void* buf, std::size_t len, const int* fds, std::size_t fdCount) noexcept
+// Sends a request (header and body) along with fds with as few sendmsg calls as possible.
+extern "C" bool SubchannelSendRequest(
+    std::intptr_t subchannelFd, const void* header, std::size_t headerLen, const void* body, std::size_t bodyLen, const int* fds, std::size_t fdCount) noexcept
 {
     if (!IsWithinFdRange(subchannelFd))
     {
@@ -304,5 +380,17 @@ extern "C" bool SubchannelSendExactBytesAndFds(std::intptr_t subchannelFd, const
         return false;
     }
 
-    return SendExactBytesWithFd(static_cast<int>(subchannelFd), buf, len, fds, fdCount);
+    // Larger requests are sent in two parts so that the helper can receive the fds with one recvmsg call (see SingleMessageRequestLength).
+    if (fdCount != 0 && headerLen + bodyLen > SingleMessageRequestLength)
+    {
+        return SendExactBytesWithFd(static_cast<int>(subchannelFd), header, headerLen, fds, fdCount)
+            && SendExactBytes(static_cast<int>(subchannelFd), body, bodyLen);
+    }
+
+    iovec iov[2];
+    iov[0].iov_base = const_cast<void*>(header);
+    iov[0].iov_len = headerLen;
+    iov[1].iov_base = const_cast<void*>(body);
+    iov[1].iov_len = bodyLen;
+    return SendExactIovecsWithFd(static_cast<int>(subchannelFd), iov, 2, fds, fdCount);
 }
@@ -2,7 +2,13 @@
 
 #include "Globals.hpp"
 #include "ChildProcessState.hpp"
+#include "JobState.hpp"
+#include "OutputMultiplexer.hpp"
 #include "Service.hpp"
+#include "Statistics.hpp"
 
 ChildProcessStateMap g_ChildProcessStateMap;
+JobStateMap g_JobStateMap;
+OutputMultiplexerMap g_OutputMultiplexerMap;
 Service g_Service;
+Statistics g_Statistics;
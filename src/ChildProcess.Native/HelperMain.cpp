@@ -24,8 +24,8 @@ static_assert(sizeof(HelperHello) == HelperHelloBytes);
 // this process inherit fds from the parent process.
 extern "C" int HelperMain(int argc, const char** argv)
 {
-    // Usage: AsmichiChildProcessHelper socket_path
-    if (argc != 2)
+    // Usage: AsmichiChildProcessHelper socket_path [--subreaper]
+    if (argc != 2 && argc != 3)
     {
         PutFatalError("Invalid argc.");
         return 1;
@@ -33,6 +33,17 @@ extern "C" int HelperMain(int argc, const char** argv)
 
     const auto* path = argv[1];
 
+    bool enableSubreaper = false;
+    if (argc == 3)
+    {
+        if (strcmp(argv[2], "--subreaper") != 0)
+        {
+            PutFatalError("Invalid option.");
+            return 1;
+        }
+        enableSubreaper = true;
+    }
+
     struct sockaddr_un addr;
     if (strlen(path) > sizeof(addr.sun_path) - 1)
     {
@@ -67,7 +78,7 @@ extern "C" int HelperMain(int argc, const char** argv)
 
     close(STDIN_FILENO);
 
-    g_Service.Initialize(std::move(*maybeSock));
+    g_Service.Initialize(std::move(*maybeSock), enableSubreaper);
     const int exitCode = g_Service.Run();
     TRACE_INFO("Helper exiting: %d\n", exitCode);
     return exitCode;
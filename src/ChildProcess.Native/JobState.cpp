@@ -0,0 +1,145 @@
+// Copyright (c) @asmichi (https://github.com/asmichi). Licensed under the MIT License. See LICENCE in the project root for details.
+
+#include "JobState.hpp"
+#include "Base.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <unordered_map>
+
+namespace
+{
+    std::uint64_t ToMicroseconds(const struct timeval& tv) noexcept
+    {
+        return static_cast<std::uint64_t>(tv.tv_sec) * 1000000 + static_cast<std::uint64_t>(tv.tv_usec);
+    }
+} // namespace
+
+int JobState::GetProcessGroupForNewMemberLocked() const noexcept
+{
+    if (liveMemberCount_ == 0)
+    {
+        return 0;
+    }
+
+    // The first member may have failed before creating the group. If so, create a new one.
+    // (The ID cannot have been recycled since the member has not been reaped.)
+    if (kill(-processGroup_, 0) == -1 && errno == ESRCH)
+    {
+        return 0;
+    }
+
+    return processGroup_;
+}
+
+void JobState::AddMemberLocked(int pid, int processGroup) noexcept
+{
+    if (processGroup == 0)
+    {
+        processGroup_ = pid;
+    }
+
+    liveMemberCount_++;
+    totalMemberCount_++;
+}
+
+void JobState::RemoveMemberLocked(const struct rusage& ru) noexcept
+{
+    liveMemberCount_--;
+    userTimeMicroseconds_ += ToMicroseconds(ru.ru_utime);
+    systemTimeMicroseconds_ += ToMicroseconds(ru.ru_stime);
+
+#if defined(__APPLE__)
+    const std::uint64_t maxrssBytes = static_cast<std::uint64_t>(ru.ru_maxrss);
+#else
+    // In KiB.
+    const std::uint64_t maxrssBytes = static_cast<std::uint64_t>(ru.ru_maxrss) * 1024;
+#endif
+    maxResidentSetBytes_ = std::max(maxResidentSetBytes_, maxrssBytes);
+}
+
+bool JobState::SendSignal(int sig, bool alsoSendSigCont) const
+{
+    const std::lock_guard<std::mutex> guard(mutex_);
+    if (liveMemberCount_ == 0)
+    {
+        return true;
+    }
+
+    const int ret = kill(-processGroup_, sig);
+    if (ret == 0 && alsoSendSigCont)
+    {
+        int err = errno;
+        kill(-processGroup_, SIGCONT);
+        errno = err;
+    }
+    return ret == 0 || errno == ESRCH;
+}
+
+JobStatistics JobState::GetStatistics() const
+{
+    const std::lock_guard<std::mutex> guard(mutex_);
+    JobStatistics s{};
+    s.LiveMemberCount = liveMemberCount_;
+    s.TotalMemberCount = totalMemberCount_;
+    s.UserTimeMicroseconds = userTimeMicroseconds_;
+    s.SystemTimeMicroseconds = systemTimeMicroseconds_;
+    s.MaxResidentSetBytes = maxResidentSetBytes_;
+    return s;
+}
+
+bool JobStateMap::Create(std::uint64_t token, bool killOnClose)
+{
+    const auto pJob = std::make_shared<JobState>(token, killOnClose);
+
+    const std::lock_guard<std::mutex> guard(mapMutex_);
+    const auto [it, inserted] = byToken_.insert(std::pair{token, pJob});
+    return inserted;
+}
+
+std::shared_ptr<JobState> JobStateMap::GetByToken(std::uint64_t token) const
+{
+    const std::lock_guard<std::mutex> guard(mapMutex_);
+    const auto it = byToken_.find(token);
+    if (it == byToken_.end())
+    {
+        return {};
+    }
+    else
+    {
+        return it->second;
+    }
+}
+
+std::shared_ptr<JobState> JobStateMap::Remove(std::uint64_t token)
+{
+    const std::lock_guard<std::mutex> guard(mapMutex_);
+    const auto it = byToken_.find(token);
+    if (it == byToken_.end())
+    {
+        return {};
+    }
+
+    auto pJob = std::move(it->second);
+    byToken_.erase(it);
+    return pJob;
+}
+
+void JobStateMap::KillAllOnClose()
+{
+    const std::lock_guard<std::mutex> guard(mapMutex_);
+
+    for (const auto& it : byToken_)
+    {
+        const auto& job = it.second;
+        if (job->ShouldKillOnClose() && !job->SendSignal(SIGKILL))
+        {
+            TRACE_ERROR("Failed to kill job %llu (%d).", static_cast<unsigned long long>(job->GetToken()), errno);
+        }
+    }
+}
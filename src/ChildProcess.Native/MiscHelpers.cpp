@@ -5,15 +5,35 @@
 #include "ExactBytesIO.hpp"
 #include "UniqueResource.hpp"
 #include "config.h"
+#include <algorithm>
 #include <array>
 #include <cerrno>
+#include <climits>
 #include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <fcntl.h>
+#include <limits>
 #include <optional>
 #include <poll.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
+#include <time.h>
 #include <unistd.h>
 
+#if defined(__linux__)
+#include <sys/syscall.h>
+
+// Binaries may be built with old kernel headers and run on newer kernels. close_range has the same number on all architectures.
+#if !defined(SYS_close_range)
+#define SYS_close_range 436
+#endif
+#endif
+
 namespace
 {
     template<typename Func>
@@ -26,6 +46,59 @@ namespace
         } while (ret < 0 && errno == EINTR);
         return ret;
     }
+
+#if defined(__linux__)
+    // Closes all fds in [first, last] by enumerating /proc/self/fd.
+    // Uses getdents64 directly since opendir allocates memory, which is not async-signal-safe.
+    bool CloseFdRangeByProcFs(int first, int last) noexcept
+    {
+        const int dirFd = open("/proc/self/fd", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (dirFd == -1)
+        {
+            return false;
+        }
+
+        alignas(std::uint64_t) char buf[2048];
+        while (true)
+        {
+            const long bytes = syscall(SYS_getdents64, dirFd, buf, sizeof(buf));
+            if (bytes <= 0)
+            {
+                break;
+            }
+
+            for (long offset = 0; offset < bytes;)
+            {
+                // struct linux_dirent64 { ino64_t d_ino; off64_t d_off; unsigned short d_reclen; unsigned char d_type; char d_name[]; }
+                const char* const entry = buf + offset;
+                unsigned short reclen;
+                std::memcpy(&reclen, entry + 16, sizeof(reclen));
+                const char* const name = entry + 19;
+                offset += reclen;
+
+                int fd = 0;
+                bool isNumber = *name != '\0';
+                for (const char* p = name; *p != '\0'; p++)
+                {
+                    if (*p < '0' || *p > '9' || fd > (INT_MAX - 9) / 10)
+                    {
+                        isNumber = false;
+                        break;
+                    }
+                    fd = fd * 10 + (*p - '0');
+                }
+
+                if (isNumber && fd != dirFd && fd >= first && fd <= last)
+                {
+                    close(fd);
+                }
+            }
+        }
+
+        close(dirFd);
+        return true;
+    }
+#endif
 } // namespace
 
 ssize_t recv_restarting(int fd, void* buf, size_t len, int flags) noexcept
@@ -96,6 +169,61 @@ int chdir_restarting(const char* path) noexcept
     return ret;
 }
 
+std::uint64_t GetMonotonicMicroseconds() noexcept
+{
+    struct timespec ts;
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) == -1)
+    {
+        return 0;
+    }
+    return static_cast<std::uint64_t>(ts.tv_sec) * 1000000 + static_cast<std::uint64_t>(ts.tv_nsec) / 1000;
+}
+
+std::uint64_t GetMonotonicNanoseconds() noexcept
+{
+    struct timespec ts;
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) == -1)
+    {
+        return 0;
+    }
+    return static_cast<std::uint64_t>(ts.tv_sec) * 1000000000 + static_cast<std::uint64_t>(ts.tv_nsec);
+}
+
+void CloseFdRange(int first, int last) noexcept
+{
+    if (first > last)
+    {
+        return;
+    }
+
+#if defined(__linux__)
+    // close_range takes time proportional to the number of open fds.
+    if (syscall(SYS_close_range, static_cast<unsigned int>(first), static_cast<unsigned int>(last), 0U) == 0)
+    {
+        return;
+    }
+
+    // Linux < 5.9
+    if (CloseFdRangeByProcFs(first, last))
+    {
+        return;
+    }
+#endif
+
+    // Last resort: try every fd number below the limit.
+    rlimit limit;
+    int maxFd = 64 * 1024 - 1;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY && limit.rlim_cur <= static_cast<rlim_t>(INT_MAX))
+    {
+        maxFd = static_cast<int>(limit.rlim_cur) - 1;
+    }
+    last = std::min(last, maxFd);
+    for (int fd = first; fd <= last; fd++)
+    {
+        close(fd);
+    }
+}
+
 std::optional<PipeEnds> CreatePipe() noexcept
 {
     int pipes[2];
@@ -125,6 +253,67 @@ std::optional<PipeEnds> CreatePipe() noexcept
     return pipeEnds;
 }
 
+namespace
+{
+#if defined(F_SETPIPE_SZ)
+    // An unprivileged process cannot make a pipe larger than /proc/sys/fs/pipe-max-size.
+    int GetPipeMaxSize() noexcept
+    {
+        static const int pipeMaxSize = [] {
+            // The default on Linux.
+            int value = 1024 * 1024;
+            if (FILE* f = std::fopen("/proc/sys/fs/pipe-max-size", "re"))
+            {
+                if (std::fscanf(f, "%d", &value) != 1 || value <= 0)
+                {
+                    value = 1024 * 1024;
+                }
+                std::fclose(f);
+            }
+            return value;
+        }();
+        return pipeMaxSize;
+    }
+#endif
+} // namespace
+
+bool SetChannelBufferSize(int fd, int size) noexcept
+{
+    if (size <= 0)
+    {
+        errno = EINVAL;
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == -1)
+    {
+        return false;
+    }
+
+    if (S_ISFIFO(st.st_mode))
+    {
+#if defined(F_SETPIPE_SZ)
+        // The kernel rounds the capacity up to a power-of-two number of pages.
+        return fcntl(fd, F_SETPIPE_SZ, std::min(size, GetPipeMaxSize())) != -1;
+#else
+        // The capacity of a pipe is fixed.
+        return true;
+#endif
+    }
+    else if (S_ISSOCK(st.st_mode))
+    {
+        // The kernel bounds these by net.core.wmem_max/rmem_max (on Linux).
+        return setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size)) == 0
+            && setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size)) == 0;
+    }
+    else
+    {
+        errno = EINVAL;
+        return false;
+    }
+}
+
 std::optional<UniqueFd> CreateUnixStreamSocket() noexcept
 {
 #if HAVE_SOCK_CLOEXEC
@@ -191,6 +380,176 @@ std::optional<UniqueFd> DuplicateFd(int fd) noexcept
     return UniqueFd(newFd);
 }
 
+namespace
+{
+#if HAVE_MEMFD_CREATE
+    // return: std::nullopt with errno == ENOSYS if memfd is not supported.
+    std::optional<UniqueFd> CreateSealableMemfd() noexcept
+    {
+        UniqueFd fd(memfd_create("AsmichiChildProcess", MFD_CLOEXEC | MFD_ALLOW_SEALING));
+        if (!fd.IsValid())
+        {
+            return std::nullopt;
+        }
+
+        return fd;
+    }
+#endif
+
+    // Creates a temporary file opened for read and write. The caller must unlink path.
+    std::optional<UniqueFd> CreateTemporaryFile(char (&path)[PATH_MAX]) noexcept
+    {
+        const char* const tmpDir = getenv("TMPDIR");
+        const int pathLen = std::snprintf(
+            path, sizeof(path), "%s/AsmichiChildProcess.XXXXXX", tmpDir != nullptr && tmpDir[0] != '\0' ? tmpDir : "/tmp");
+        if (pathLen < 0 || static_cast<std::size_t>(pathLen) >= sizeof(path))
+        {
+            errno = ENAMETOOLONG;
+            return std::nullopt;
+        }
+
+#if HAVE_MKOSTEMP
+        UniqueFd fd(mkostemp(path, O_CLOEXEC));
+        if (!fd.IsValid())
+        {
+            return std::nullopt;
+        }
+#else
+        UniqueFd fd(mkstemp(path));
+        if (!fd.IsValid())
+        {
+            return std::nullopt;
+        }
+
+        if (fcntl(fd.Get(), F_SETFD, FD_CLOEXEC) == -1)
+        {
+            ErrnoRestorer er;
+            unlink(path);
+            return std::nullopt;
+        }
+#endif
+
+        return fd;
+    }
+} // namespace
+
+std::optional<UniqueFd> CreateReadOnlyMemoryFile(const void* data, std::size_t len) noexcept
+{
+#if HAVE_MEMFD_CREATE
+    if (auto maybeFd = CreateSealableMemfd())
+    {
+        if (!WriteExactBytes(maybeFd->Get(), data, len)
+            || fcntl(maybeFd->Get(), F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) == -1
+            || lseek(maybeFd->Get(), 0, SEEK_SET) == -1)
+        {
+            return std::nullopt;
+        }
+
+        return maybeFd;
+    }
+    else if (errno != ENOSYS)
+    {
+        return std::nullopt;
+    }
+#endif
+
+    char path[PATH_MAX];
+    auto maybeWriteFd = CreateTemporaryFile(path);
+    if (!maybeWriteFd)
+    {
+        return std::nullopt;
+    }
+
+    // Reopen read-only so that the child process cannot modify the content; then nobody needs the name.
+    const bool written = WriteExactBytes(maybeWriteFd->Get(), data, len);
+    UniqueFd readFd(written ? open(path, O_RDONLY | O_CLOEXEC) : -1);
+    {
+        ErrnoRestorer er;
+        unlink(path);
+    }
+    if (!readFd.IsValid())
+    {
+        return std::nullopt;
+    }
+
+    return readFd;
+}
+
+std::optional<UniqueFd> CreateUnlinkedTemporaryFile() noexcept
+{
+    char path[PATH_MAX];
+    auto maybeFd = CreateTemporaryFile(path);
+    if (maybeFd)
+    {
+        unlink(path);
+    }
+    return maybeFd;
+}
+
+std::optional<UniqueFd> CreateCaptureMemoryFile(std::int64_t maxLength) noexcept
+{
+#if HAVE_MEMFD_CREATE
+    if (auto maybeFd = CreateSealableMemfd())
+    {
+        // Writes beyond maxLength fail with EPERM. The file is sparse; untouched pages consume no memory.
+        if (maxLength >= 0
+            && (ftruncate(maybeFd->Get(), maxLength) == -1
+                || fcntl(maybeFd->Get(), F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) == -1))
+        {
+            return std::nullopt;
+        }
+
+        return maybeFd;
+    }
+    else if (errno != ENOSYS)
+    {
+        return std::nullopt;
+    }
+#endif
+
+    // Without sealing, the length is not enforced here; the content is truncated to maxLength when mapped.
+    return CreateUnlinkedTemporaryFile();
+}
+
+bool MapCapturedMemoryFile(int fd, std::int64_t maxLength, void** outAddr, std::size_t* outLen) noexcept
+{
+    // The child process shares the file description; its offset is the length written.
+    const off_t offset = lseek(fd, 0, SEEK_CUR);
+    struct stat st;
+    if (offset == -1 || fstat(fd, &st) == -1)
+    {
+        return false;
+    }
+
+    std::uint64_t len = static_cast<std::uint64_t>(std::min<off_t>(offset, st.st_size));
+    if (maxLength >= 0)
+    {
+        len = std::min(len, static_cast<std::uint64_t>(maxLength));
+    }
+    if (len > std::numeric_limits<std::size_t>::max())
+    {
+        errno = EFBIG;
+        return false;
+    }
+
+    if (len == 0)
+    {
+        *outAddr = nullptr;
+        *outLen = 0;
+        return true;
+    }
+
+    void* const addr = mmap(nullptr, static_cast<std::size_t>(len), PROT_READ, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED)
+    {
+        return false;
+    }
+
+    *outAddr = addr;
+    *outLen = static_cast<std::size_t>(len);
+    return true;
+}
+
 std::optional<pthread_t> CreateThreadWithMyDefault(void* (*startRoutine)(void*), void* arg, int flags) noexcept
 {
     // glibc default
@@ -0,0 +1,250 @@
+// Copyright (c) @asmichi (https://github.com/asmichi). Licensed under the MIT License. See LICENCE in the project root for details.
+
+#include "OutputMultiplexer.hpp"
+#include "Base.hpp"
+#include "MiscHelpers.hpp"
+#include "UniqueResource.hpp"
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <mutex>
+#include <poll.h>
+#include <unistd.h>
+#include <vector>
+
+bool OutputMultiplexer::StartThread()
+{
+    // The thread keeps the multiplexer alive until it finishes.
+    auto pSelf = std::make_unique<std::shared_ptr<OutputMultiplexer>>(shared_from_this());
+    auto maybeThread = CreateThreadWithMyDefault(OutputMultiplexer::ThreadFunc, pSelf.get(), CreateThreadFlagsDetached);
+    if (!maybeThread)
+    {
+        return false;
+    }
+
+    static_cast<void>(pSelf.release());
+    return true;
+}
+
+bool OutputMultiplexer::AddSource(std::uint64_t tag, CapturedStream stream, UniqueFd fd)
+{
+    {
+        const std::lock_guard<std::mutex> guard(mutex_);
+        if (finished_)
+        {
+            return false;
+        }
+
+        pendingSources_.push_back({tag, stream, std::move(fd)});
+    }
+
+    Wakeup();
+    return true;
+}
+
+void OutputMultiplexer::Complete() noexcept
+{
+    {
+        const std::lock_guard<std::mutex> guard(mutex_);
+        completed_ = true;
+    }
+
+    Wakeup();
+}
+
+void* OutputMultiplexer::ThreadFunc(void* arg)
+{
+    const std::unique_ptr<std::shared_ptr<OutputMultiplexer>> pSelf{static_cast<std::shared_ptr<OutputMultiplexer>*>(arg)};
+    (*pSelf)->Run();
+    return nullptr;
+}
+
+void OutputMultiplexer::Run()
+{
+    readBuffer_.reset(new std::byte[MaxOutputFrameDataLength]);
+
+    std::vector<pollfd> fds;
+    while (true)
+    {
+        {
+            const std::lock_guard<std::mutex> guard(mutex_);
+            for (auto& source : pendingSources_)
+            {
+                sources_.push_back(std::move(source));
+            }
+            pendingSources_.clear();
+
+            if (completed_ && sources_.empty())
+            {
+                finished_ = true;
+                break;
+            }
+        }
+
+        fds.resize(sources_.size() + 1);
+        fds[0].fd = wakeupReadEnd_.Get();
+        fds[0].events = POLLIN;
+        for (std::size_t i = 0; i < sources_.size(); i++)
+        {
+            fds[i + 1].fd = sources_[i].Fd.Get();
+            fds[i + 1].events = POLLIN;
+        }
+
+        if (poll_restarting(fds.data(), static_cast<unsigned int>(fds.size()), -1) == -1)
+        {
+            FatalErrorAbort(errno, "poll");
+        }
+
+        if (fds[0].revents & POLLIN)
+        {
+            char buf[64];
+            static_cast<void>(read_restarting(wakeupReadEnd_.Get(), buf, sizeof(buf)));
+        }
+
+        // Read at most one chunk from each ready source per round so that a chatty child does not starve the others.
+        std::size_t liveCount = 0;
+        for (std::size_t i = 0; i < sources_.size(); i++)
+        {
+            const bool isLive = (fds[i + 1].revents == 0) || ReadSource(sources_[i]);
+            if (isLive)
+            {
+                if (liveCount != i)
+                {
+                    sources_[liveCount] = std::move(sources_[i]);
+                }
+                liveCount++;
+            }
+        }
+        sources_.resize(liveCount);
+
+        // Write all chunks read in this round at once.
+        FlushFrames();
+    }
+
+    // Signal EOF to the client.
+    sinkFd_.Reset();
+    TRACE_INFO("Output multiplexer %llu finished.\n", static_cast<unsigned long long>(token_));
+}
+
+bool OutputMultiplexer::ReadSource(const Source& source)
+{
+    const ssize_t bytesRead = read_restarting(source.Fd.Get(), readBuffer_.get(), MaxOutputFrameDataLength);
+    if (bytesRead > 0)
+    {
+        AppendFrame(source, readBuffer_.get(), static_cast<std::size_t>(bytesRead));
+        return true;
+    }
+    else if (bytesRead == -1 && IsWouldBlockError(errno))
+    {
+        return true;
+    }
+    else
+    {
+        // EOF (or an error, which we cannot report anyway).
+        AppendFrame(source, nullptr, 0);
+        return false;
+    }
+}
+
+void OutputMultiplexer::AppendFrame(const Source& source, const std::byte* data, std::size_t length)
+{
+    if (sinkBroken_)
+    {
+        return;
+    }
+
+    OutputFrameHeader header;
+    header.Tag = source.Tag;
+    header.Timestamp = GetMonotonicNanoseconds();
+    header.Length = static_cast<std::uint32_t>(length);
+    header.Stream = source.Stream;
+
+    const auto offset = frames_.size();
+    frames_.resize(offset + sizeof(header) + length);
+    std::memcpy(frames_.data() + offset, &header, sizeof(header));
+    if (length != 0)
+    {
+        std::memcpy(frames_.data() + offset + sizeof(header), data, length);
+    }
+}
+
+void OutputMultiplexer::FlushFrames() noexcept
+{
+    if (!frames_.empty() && !sinkBroken_ && !WriteExactBytes(sinkFd_.Get(), frames_.data(), frames_.size()))
+    {
+        // The client has gone away. Keep draining the sources so that the children will not block.
+        TRACE_ERROR("Output multiplexer %llu: failed to write to the sink (%d).\n", static_cast<unsigned long long>(token_), errno);
+        sinkBroken_ = true;
+    }
+
+    // Keeps the capacity.
+    frames_.clear();
+}
+
+void OutputMultiplexer::Wakeup() noexcept
+{
+    // The pipe is nonblocking; if it is full, the thread is going to wake up anyway.
+    static_cast<void>(write_restarting(wakeupWriteEnd_.Get(), "", 1));
+}
+
+int OutputMultiplexerMap::Create(std::uint64_t token, UniqueFd sinkFd)
+{
+    auto maybeWakeupPipe = CreatePipe();
+    if (!maybeWakeupPipe)
+    {
+        return errno;
+    }
+
+    auto wakeupPipe = std::move(*maybeWakeupPipe);
+    const int writeEndFlags = fcntl(wakeupPipe.WriteEnd.Get(), F_GETFL);
+    if (writeEndFlags == -1 || fcntl(wakeupPipe.WriteEnd.Get(), F_SETFL, writeEndFlags | O_NONBLOCK) == -1)
+    {
+        return errno;
+    }
+
+    const auto pMultiplexer = std::make_shared<OutputMultiplexer>(
+        token, std::move(sinkFd), std::move(wakeupPipe.ReadEnd), std::move(wakeupPipe.WriteEnd));
+
+    const std::lock_guard<std::mutex> guard(mapMutex_);
+    if (byToken_.find(token) != byToken_.end())
+    {
+        return EEXIST;
+    }
+    if (!pMultiplexer->StartThread())
+    {
+        return errno;
+    }
+
+    byToken_.insert(std::pair{token, pMultiplexer});
+    return 0;
+}
+
+std::shared_ptr<OutputMultiplexer> OutputMultiplexerMap::GetByToken(std::uint64_t token) const
+{
+    const std::lock_guard<std::mutex> guard(mapMutex_);
+    const auto it = byToken_.find(token);
+    if (it == byToken_.end())
+    {
+        return {};
+    }
+    else
+    {
+        return it->second;
+    }
+}
+
+std::shared_ptr<OutputMultiplexer> OutputMultiplexerMap::Remove(std::uint64_t token)
+{
+    const std::lock_guard<std::mutex> guard(mapMutex_);
+    const auto it = byToken_.find(token);
+    if (it == byToken_.end())
+    {
+        return {};
+    }
+
+    auto pMultiplexer = std::move(it->second);
+    byToken_.erase(it);
+    return pMultiplexer;
+}
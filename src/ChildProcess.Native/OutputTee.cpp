@@ -0,0 +1,302 @@
+// Copyright (c) @asmichi (https://github.com/asmichi). Licensed under the MIT License. See LICENCE in the project root for details.
+
+#include "OutputTee.hpp"
+#include "Base.hpp"
+#include "MiscHelpers.hpp"
+#include "UniqueResource.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <fcntl.h>
+#include <memory>
+#include <poll.h>
+#include <unistd.h>
+#include <vector>
+
+namespace
+{
+    // The maximum number of bytes moved from the source at once (the default capacity of a pipe on Linux).
+    const std::size_t MaxTeeChunkLength = 64 * 1024;
+} // namespace
+
+bool OutputTee::Start(std::unique_ptr<OutputTee> tee) noexcept
+{
+    auto maybeThread = CreateThreadWithMyDefault(OutputTee::ThreadFunc, tee.get(), CreateThreadFlagsDetached);
+    if (!maybeThread)
+    {
+        return false;
+    }
+
+    static_cast<void>(tee.release());
+    return true;
+}
+
+void* OutputTee::ThreadFunc(void* arg)
+{
+    const std::unique_ptr<OutputTee> pSelf{static_cast<OutputTee*>(arg)};
+    pSelf->Run();
+    return nullptr;
+}
+
+void OutputTee::Run() noexcept
+{
+    buffer_.reset(new std::byte[MaxTeeChunkLength]);
+
+#if defined(__linux__)
+    if (RunWithSplice())
+    {
+        return;
+    }
+#endif
+
+    RunWithBuffer();
+}
+
+#if defined(__linux__)
+bool OutputTee::RunWithSplice() noexcept
+{
+    // source --splice--> scratch --tee--> stage --splice--> sink (for each sink but the last)
+    //                            --splice--> sink (for the last sink)
+    auto maybeScratch = CreatePipe();
+    auto maybeStage = CreatePipe();
+    if (!maybeScratch || !maybeStage)
+    {
+        return false;
+    }
+
+    const int scratchReadFd = maybeScratch->ReadEnd.Get();
+    const int scratchWriteFd = maybeScratch->WriteEnd.Get();
+    const int stageReadFd = maybeStage->ReadEnd.Get();
+    const int stageWriteFd = maybeStage->WriteEnd.Get();
+
+    while (true)
+    {
+        const ssize_t bytesMoved = splice(sourceFd_.Get(), nullptr, scratchWriteFd, nullptr, MaxTeeChunkLength, SPLICE_F_MOVE);
+        if (bytesMoved == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            // Treat as EOF. (The source is always a pipe we created, so splice is always supported.)
+            break;
+        }
+        else if (bytesMoved == 0)
+        {
+            break;
+        }
+
+        const std::size_t length = static_cast<std::size_t>(bytesMoved);
+        TeeSink* pLastSink = nullptr;
+        for (auto& sink : sinks_)
+        {
+            if (sink.Fd.IsValid())
+            {
+                pLastSink = &sink;
+            }
+        }
+
+        if (pLastSink == nullptr)
+        {
+            // All sinks are gone. Keep draining the source so that the child will not block.
+            Discard(scratchReadFd, length);
+            continue;
+        }
+
+        for (auto& sink : sinks_)
+        {
+            if (!sink.Fd.IsValid() || &sink == pLastSink)
+            {
+                continue;
+            }
+
+            // The stage is empty and as large as the scratch, so tee duplicates the whole content at once.
+            ssize_t bytesTeed;
+            do
+            {
+                bytesTeed = tee(scratchReadFd, stageWriteFd, length, 0);
+            } while (bytesTeed == -1 && errno == EINTR);
+
+            if (bytesTeed == -1)
+            {
+                MarkBroken(sink);
+                continue;
+            }
+
+            DeliverStaged(sink, stageReadFd, static_cast<std::size_t>(bytesTeed));
+        }
+
+        DeliverStaged(*pLastSink, scratchReadFd, length);
+    }
+
+    return true;
+}
+
+// Moves exactly length bytes out of stageFd, either to the sink, to the spill fd or to nowhere.
+void OutputTee::DeliverStaged(TeeSink& sink, int stageFd, std::size_t length) noexcept
+{
+    const bool mayBlock = sink.Backpressure == TeeBackpressure::Block;
+    while (length > 0 && sink.Fd.IsValid())
+    {
+        if (!mayBlock && !IsSinkReady(sink))
+        {
+            break;
+        }
+
+        const ssize_t bytesSpliced = splice(stageFd, nullptr, sink.Fd.Get(), nullptr, length, SPLICE_F_MOVE | (mayBlock ? 0 : SPLICE_F_NONBLOCK));
+        if (bytesSpliced == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            else if (errno == EAGAIN)
+            {
+                // A non-blocking sink is full.
+                if (mayBlock)
+                {
+                    pollfd pfd{sink.Fd.Get(), POLLOUT, 0};
+                    static_cast<void>(poll_restarting(&pfd, 1, -1));
+                    continue;
+                }
+
+                break;
+            }
+            else if (errno == EINVAL)
+            {
+                // The sink does not support splice. Copy one buffer through userspace.
+                const ssize_t bytesRead = read_restarting(stageFd, buffer_.get(), std::min(length, MaxTeeChunkLength));
+                if (bytesRead <= 0)
+                {
+                    break;
+                }
+
+                length -= static_cast<std::size_t>(bytesRead);
+                Deliver(sink, buffer_.get(), static_cast<std::size_t>(bytesRead));
+                continue;
+            }
+
+            MarkBroken(sink);
+            break;
+        }
+
+        length -= static_cast<std::size_t>(bytesSpliced);
+    }
+
+    if (length == 0)
+    {
+        return;
+    }
+
+    if (sink.Backpressure == TeeBackpressure::Spill && sink.SpillFd.IsValid())
+    {
+        while (length > 0)
+        {
+            const ssize_t bytesRead = read_restarting(stageFd, buffer_.get(), std::min(length, MaxTeeChunkLength));
+            if (bytesRead <= 0)
+            {
+                return;
+            }
+
+            length -= static_cast<std::size_t>(bytesRead);
+            if (!WriteExactBytes(sink.SpillFd.Get(), buffer_.get(), static_cast<std::size_t>(bytesRead)))
+            {
+                // Drop from now on.
+                sink.SpillFd.Reset();
+                break;
+            }
+        }
+    }
+
+    Discard(stageFd, length);
+}
+#endif
+
+void OutputTee::RunWithBuffer() noexcept
+{
+    while (true)
+    {
+        const ssize_t bytesRead = read_restarting(sourceFd_.Get(), buffer_.get(), MaxTeeChunkLength);
+        if (bytesRead <= 0)
+        {
+            break;
+        }
+
+        for (auto& sink : sinks_)
+        {
+            Deliver(sink, buffer_.get(), static_cast<std::size_t>(bytesRead));
+        }
+    }
+}
+
+void OutputTee::Deliver(TeeSink& sink, const std::byte* data, std::size_t length) noexcept
+{
+    if (!sink.Fd.IsValid())
+    {
+        return;
+    }
+
+    if (sink.Backpressure == TeeBackpressure::Block)
+    {
+        if (!WriteExactBytes(sink.Fd.Get(), data, length))
+        {
+            MarkBroken(sink);
+        }
+
+        return;
+    }
+
+    // Write as much as the sink accepts immediately (best effort; a write to a blocking fd may still wait for part of the data).
+    while (length > 0 && IsSinkReady(sink))
+    {
+        const ssize_t bytesWritten = write_restarting(sink.Fd.Get(), data, length);
+        if (bytesWritten == -1)
+        {
+            if (errno != EAGAIN)
+            {
+                MarkBroken(sink);
+            }
+
+            break;
+        }
+
+        data += bytesWritten;
+        length -= static_cast<std::size_t>(bytesWritten);
+    }
+
+    if (length > 0 && sink.Backpressure == TeeBackpressure::Spill && sink.SpillFd.IsValid())
+    {
+        if (!WriteExactBytes(sink.SpillFd.Get(), data, length))
+        {
+            sink.SpillFd.Reset();
+        }
+    }
+}
+
+void OutputTee::Discard(int stageFd, std::size_t length) noexcept
+{
+    while (length > 0)
+    {
+        const ssize_t bytesRead = read_restarting(stageFd, buffer_.get(), std::min(length, MaxTeeChunkLength));
+        if (bytesRead <= 0)
+        {
+            return;
+        }
+
+        length -= static_cast<std::size_t>(bytesRead);
+    }
+}
+
+bool OutputTee::IsSinkReady(const TeeSink& sink) noexcept
+{
+    // Report an error as ready so that the following write will detect it.
+    pollfd pfd{sink.Fd.Get(), POLLOUT, 0};
+    return poll_restarting(&pfd, 1, 0) == 1 && (pfd.revents & (POLLOUT | POLLERR | POLLHUP)) != 0;
+}
+
+void OutputTee::MarkBroken(TeeSink& sink) noexcept
+{
+    TRACE_DEBUG("Tee sink %d failed (errno=%d); closing it.\n", sink.Fd.Get(), errno);
+    sink.Fd.Reset();
+}
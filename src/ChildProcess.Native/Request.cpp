@@ -6,7 +6,7 @@
 #include <cassert>
 #include <cstdint>
 #include <cstring>
-#include <memory>
+#include <unistd.h>
 #include <vector>
 
 namespace
@@ -20,28 +20,91 @@ namespace
             throw BadRequestError(E2BIG);
         }
 
+        // Reserve room for the terminating nullptr, too.
+        buf->reserve(count + 1);
         for (std::uint32_t i = 0; i < count; i++)
         {
             buf->push_back(br.GetStringAndAdvance());
         }
+        buf->push_back(nullptr);
+    }
+
+    void GetFdMapAndAdvance(BinaryReader& br, std::vector<FdMapEntry>* buf)
+    {
+        const auto count = br.Read<std::uint32_t>();
+        if (count > MaxFdMapCount)
+        {
+            TRACE_ERROR("count > MaxFdMapCount: %u\n", static_cast<unsigned int>(count));
+            throw BadRequestError(E2BIG);
+        }
+
+        buf->resize(count);
+        for (std::uint32_t i = 0; i < count; i++)
+        {
+            const auto targetFd = br.Read<std::int32_t>();
+            if (targetFd <= STDERR_FILENO)
+            {
+                TRACE_ERROR("Invalid target fd: %d\n", static_cast<int>(targetFd));
+                throw BadRequestError(ErrorCode::InvalidRequest);
+            }
+
+            for (std::uint32_t j = 0; j < i; j++)
+            {
+                if ((*buf)[j].TargetFd == targetFd)
+                {
+                    TRACE_ERROR("Duplicate target fd: %d\n", static_cast<int>(targetFd));
+                    throw BadRequestError(ErrorCode::InvalidRequest);
+                }
+            }
+
+            (*buf)[i].TargetFd = targetFd;
+        }
+    }
+
+    void GetTeeSinksAndAdvance(BinaryReader& br, std::vector<TeeSink>* buf)
+    {
+        const auto count = br.Read<std::uint32_t>();
+        if (count > MaxTeeSinkCount)
+        {
+            TRACE_ERROR("count > MaxTeeSinkCount: %u\n", static_cast<unsigned int>(count));
+            throw BadRequestError(E2BIG);
+        }
+
+        buf->resize(count);
+        for (std::uint32_t i = 0; i < count; i++)
+        {
+            const auto backpressure = br.Read<std::uint32_t>();
+            if (backpressure > static_cast<std::uint32_t>(TeeBackpressure::Spill))
+            {
+                TRACE_ERROR("Invalid backpressure policy: %u\n", static_cast<unsigned int>(backpressure));
+                throw BadRequestError(ErrorCode::InvalidRequest);
+            }
+
+            (*buf)[i].Backpressure = static_cast<TeeBackpressure>(backpressure);
+        }
     }
 } // namespace
 
-void DeserializeSpawnProcessRequest(SpawnProcessRequest* r, std::unique_ptr<const std::byte[]> data, std::size_t length)
+void DeserializeSpawnProcessRequest(SpawnProcessRequest* r, const std::byte* data, std::size_t length)
 {
+    ResetSpawnProcessRequest(r);
+
     try
     {
-        BinaryReader br{data.get(), length};
-        r->Data = std::move(data);
+        BinaryReader br{data, length};
         r->Token = br.Read<std::uint64_t>();
         r->Flags = br.Read<std::uint32_t>();
         r->WorkingDirectory = br.GetStringAndAdvance();
         r->ExecutablePath = br.GetStringAndAdvance();
         GetStringArrayAndAdvance(br, &r->Argv);
         GetStringArrayAndAdvance(br, &r->Envp);
-
-        r->Argv.push_back(nullptr);
-        r->Envp.push_back(nullptr);
+        GetFdMapAndAdvance(br, &r->FdMap);
+        r->JobToken = br.Read<std::uint64_t>();
+        r->OutputMultiplexerToken = br.Read<std::uint64_t>();
+        r->OutputTag = br.Read<std::uint64_t>();
+        GetTeeSinksAndAdvance(br, &r->StdoutTeeSinks);
+        GetTeeSinksAndAdvance(br, &r->StderrTeeSinks);
+        r->PipeBufferSize = br.Read<std::uint32_t>();
 
         if (r->ExecutablePath == nullptr)
         {
@@ -56,11 +119,11 @@ void DeserializeSpawnProcessRequest(SpawnProcessRequest* r, std::unique_ptr<cons
     }
 }
 
-void DeserializeSendSignalRequest(SendSignalRequest* r, std::unique_ptr<const std::byte[]> data, std::size_t length)
+void DeserializeSendSignalRequest(SendSignalRequest* r, const std::byte* data, std::size_t length)
 {
     try
     {
-        BinaryReader br{data.get(), length};
+        BinaryReader br{data, length};
         r->Token = br.Read<std::uint64_t>();
         r->Signal = static_cast<AbstractSignal>(br.Read<std::uint32_t>());
     }
@@ -70,3 +133,113 @@ void DeserializeSendSignalRequest(SendSignalRequest* r, std::unique_ptr<const st
         throw BadRequestError(ErrorCode::InvalidRequest);
     }
 }
+
+void DeserializeSendSignalBulkRequest(SendSignalBulkRequest* r, const std::byte* data, std::size_t length)
+{
+    try
+    {
+        BinaryReader br{data, length};
+        r->Signal = static_cast<AbstractSignal>(br.Read<std::uint32_t>());
+
+        const auto count = br.Read<std::uint32_t>();
+        if (count > MaxSignalBulkTokenCount)
+        {
+            TRACE_ERROR("count > MaxSignalBulkTokenCount: %u\n", static_cast<unsigned int>(count));
+            throw BadRequestError(E2BIG);
+        }
+
+        r->Tokens.clear();
+        r->Tokens.reserve(count);
+        for (std::uint32_t i = 0; i < count; i++)
+        {
+            r->Tokens.push_back(br.Read<std::uint64_t>());
+        }
+    }
+    catch ([[maybe_unused]] const BadBinaryError& exn)
+    {
+        TRACE_ERROR("BadBinaryError: %s\n", exn.what());
+        throw BadRequestError(ErrorCode::InvalidRequest);
+    }
+}
+
+void DeserializeCreateJobRequest(CreateJobRequest* r, const std::byte* data, std::size_t length)
+{
+    try
+    {
+        BinaryReader br{data, length};
+        r->Token = br.Read<std::uint64_t>();
+        r->Flags = br.Read<std::uint32_t>();
+    }
+    catch ([[maybe_unused]] const BadBinaryError& exn)
+    {
+        TRACE_ERROR("BadBinaryError: %s\n", exn.what());
+        throw BadRequestError(ErrorCode::InvalidRequest);
+    }
+}
+
+void DeserializeSendSignalToJobRequest(SendSignalToJobRequest* r, const std::byte* data, std::size_t length)
+{
+    try
+    {
+        BinaryReader br{data, length};
+        r->Token = br.Read<std::uint64_t>();
+        r->Signal = static_cast<AbstractSignal>(br.Read<std::uint32_t>());
+    }
+    catch ([[maybe_unused]] const BadBinaryError& exn)
+    {
+        TRACE_ERROR("BadBinaryError: %s\n", exn.what());
+        throw BadRequestError(ErrorCode::InvalidRequest);
+    }
+}
+
+void DeserializeJobRequest(JobRequest* r, const std::byte* data, std::size_t length)
+{
+    try
+    {
+        BinaryReader br{data, length};
+        r->Token = br.Read<std::uint64_t>();
+    }
+    catch ([[maybe_unused]] const BadBinaryError& exn)
+    {
+        TRACE_ERROR("BadBinaryError: %s\n", exn.what());
+        throw BadRequestError(ErrorCode::InvalidRequest);
+    }
+}
+
+void DeserializeOutputMultiplexerRequest(OutputMultiplexerRequest* r, const std::byte* data, std::size_t length)
+{
+    try
+    {
+        BinaryReader br{data, length};
+        r->Token = br.Read<std::uint64_t>();
+    }
+    catch ([[maybe_unused]] const BadBinaryError& exn)
+    {
+        TRACE_ERROR("BadBinaryError: %s\n", exn.what());
+        throw BadRequestError(ErrorCode::InvalidRequest);
+    }
+}
+
+void ResetSpawnProcessRequest(SpawnProcessRequest* r) noexcept
+{
+    r->WorkingDirectory = nullptr;
+    r->ExecutablePath = nullptr;
+    r->Argv.clear();
+    r->Envp.clear();
+    r->StdinFd.Reset();
+    r->StdoutFd.Reset();
+    r->StderrFd.Reset();
+    r->FdMap.clear();
+    r->JobToken = 0;
+    r->Job.reset();
+    r->OutputMultiplexerToken = 0;
+    r->OutputTag = 0;
+    r->Multiplexer.reset();
+    r->CapturedStdoutFd.Reset();
+    r->CapturedStderrFd.Reset();
+    r->StdoutTeeSinks.clear();
+    r->StderrTeeSinks.clear();
+    r->PipeBufferSize = 0;
+    r->TeedStdoutFd.Reset();
+    r->TeedStderrFd.Reset();
+}
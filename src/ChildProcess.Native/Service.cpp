@@ -3,25 +3,39 @@
 #include "Service.hpp"
 #include "AncillaryDataSocket.hpp"
 #include "Base.hpp"
+#include "EventTrace.hpp"
 #include "ChildProcessState.hpp"
 #include "Globals.hpp"
+#include "JobState.hpp"
 #include "MiscHelpers.hpp"
+#include "Probes.hpp"
 #include "SignalHandler.hpp"
 #include "SocketHelpers.hpp"
+#include "Statistics.hpp"
 #include "Subchannel.hpp"
 #include "UniqueResource.hpp"
 #include "WriteBuffer.hpp"
+#include "config.h"
 #include <cassert>
+#include <climits>
 #include <cstdint>
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
 #include <memory>
 #include <poll.h>
 #include <signal.h>
+#include <sys/ioctl.h>
 #include <sys/wait.h>
 #include <unistd.h>
 #include <unordered_map>
 
+#if HAVE_PR_SET_CHILD_SUBREAPER
+#include <sys/prctl.h>
+#endif
+
 static_assert(sizeof(pid_t) == sizeof(int32_t));
 
 namespace
@@ -43,10 +57,56 @@ namespace
         PollIndexMainChannel = 1,
     };
     const int PollFdCount = 2;
+
+#if HAVE_PR_SET_CHILD_SUBREAPER
+    // Returns the parent pid of the process, or -1 if it has already gone.
+    int GetParentPid(const char* pidString) noexcept
+    {
+        char path[64];
+        snprintf(path, sizeof(path), "/proc/%s/stat", pidString);
+
+        const int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd == -1)
+        {
+            return -1;
+        }
+
+        char buf[512];
+        const ssize_t bytesRead = read_restarting(fd, buf, sizeof(buf) - 1);
+        close(fd);
+        if (bytesRead <= 0)
+        {
+            return -1;
+        }
+        buf[bytesRead] = '\0';
+
+        // "pid (comm) state ppid ..." where comm may contain anything including ')'.
+        const char* p = strrchr(buf, ')');
+        int ppid;
+        if (p == nullptr || sscanf(p + 1, " %*c %d", &ppid) != 1)
+        {
+            return -1;
+        }
+        return ppid;
+    }
+#endif
 } // namespace
 
-void Service::Initialize(UniqueFd mainChannelFd)
+void Service::Initialize(UniqueFd mainChannelFd, bool enableSubreaper)
 {
+    if (enableSubreaper)
+    {
+#if HAVE_PR_SET_CHILD_SUBREAPER
+        if (prctl(PR_SET_CHILD_SUBREAPER, 1) == -1)
+        {
+            FatalErrorAbort(errno, "prctl");
+        }
+        isSubreaper_ = true;
+#else
+        TRACE_INFO("The subreaper mode is not supported on this platform.\n");
+#endif
+    }
+
     {
         auto maybePipe = CreatePipe();
         if (!maybePipe)
@@ -88,6 +148,10 @@ void Service::NotifySignal(int signum)
         n = NotificationToService::ReapRequest;
         break;
 
+    case SIGUSR1:
+        n = NotificationToService::DumpTrace;
+        break;
+
     default:
         return;
     }
@@ -123,8 +187,22 @@ bool Service::WriteNotification(NotificationToService notification)
     return WriteExactBytes(notificationPipeWriteEnd_, &notification, sizeof(notification));
 }
 
+std::size_t Service::GetNotificationQueueDepth() const noexcept
+{
+    static_assert(sizeof(NotificationToService) == 1);
+
+    int bytes;
+    if (ioctl(notificationPipeReadEnd_, FIONREAD, &bytes) == -1)
+    {
+        return 0;
+    }
+    return static_cast<std::size_t>(bytes);
+}
+
 int Service::Run()
 {
+    SetTraceThreadName("service");
+
     // Main service loop
     pollfd fds[PollFdCount]{};
     fds[PollIndexNotification].fd = notificationPipeReadEnd_;
@@ -169,6 +247,11 @@ int Service::Run()
     }
 
     g_ChildProcessStateMap.AutoTerminateAll();
+    g_JobStateMap.KillAllOnClose();
+    if (isSubreaper_)
+    {
+        TerminateAdoptedOrphans();
+    }
 
     return 0;
 }
@@ -206,6 +289,8 @@ void Service::HandleNotificationPipeInput()
         FatalErrorAbort(errno, "read");
     }
 
+    g_Statistics.RecordNotificationBatch(static_cast<std::size_t>(readSize));
+
     bool hasReapRequest = false;
     for (ssize_t i = 0; i < readSize; i++)
     {
@@ -228,6 +313,10 @@ void Service::HandleNotificationPipeInput()
             // Just for waking up the main loop.
             break;
 
+        case NotificationToService::DumpTrace:
+            WriteTraceFile();
+            break;
+
         default:
             FatalErrorAbort("Internal error");
         }
@@ -235,6 +324,7 @@ void Service::HandleNotificationPipeInput()
 
     if (hasReapRequest)
     {
+        RecordTraceEvent(TraceEventType::ChildSignal);
         ReapAllExitedChildren();
     }
 }
@@ -244,6 +334,8 @@ void Service::ReapAllExitedChildren()
     // Because SIGCHLD is a standard signal, only one SIGCHLD signal can be queued.
     // If the queue already has an instance, further SIGCHLD signals will be "lost".
     // We need to reap all terminated children on every SIGCHLD signal.
+    std::uint32_t reapedCount = 0;
+    std::uint32_t orphanCount = 0;
     while (true)
     {
         siginfo_t siginfo{};
@@ -255,7 +347,7 @@ void Service::ReapAllExitedChildren()
         {
             if (errno == ECHILD)
             {
-                return;
+                break;
             }
             else
             {
@@ -267,24 +359,112 @@ void Service::ReapAllExitedChildren()
         if (pid == 0)
         {
             // No waitable child.
-            return;
+            break;
         }
 
+        // NOTE: Check this before the lookup. If no spawn was pending, every child forked so far has been allocated.
+        const bool hasPendingSpawn = g_ChildProcessStateMap.HasPendingSpawn();
         auto pState = g_ChildProcessStateMap.GetByPid(pid);
         if (!pState)
         {
-            // This child process was killed before we register it to the map.
-            // Delay the reaping process until we register it and send a reap request.
-            return;
+            if (hasPendingSpawn)
+            {
+                // This child process may have been killed before we register it to the map.
+                // Delay the reaping process until we register it and send a reap request.
+                break;
+            }
+
+            // An orphaned descendant adopted in the subreaper mode. No one is interested in its exit status.
+            siginfo_t orphanSiginfo;
+            if (waitid(P_PID, pid, &orphanSiginfo, WEXITED | WNOHANG) < 0)
+            {
+                FatalErrorAbort(errno, "waitid");
+            }
+            RecordTraceEvent(TraceEventType::Reap, 0, pid);
+            PROBE_REAP(0, pid, orphanSiginfo.si_status);
+            reapedCount++;
+            orphanCount++;
+            continue;
         }
 
+        RecordTraceEvent(TraceEventType::Reap, pState->GetToken(), pid);
+        PROBE_REAP(pState->GetToken(), pid, siginfo.si_status);
         NotifyClientOfExitedChild(pState.get(), siginfo);
 
         g_ChildProcessStateMap.Delete(pState.get());
 
         // We have updated our data and are ready for recycling of the PID. Reap the child.
         pState->Reap();
+        reapedCount++;
+    }
+
+    g_Statistics.RecordReapBatch(reapedCount, orphanCount);
+}
+
+// Send SIGTERM then SIGCONT to all orphaned descendants we have adopted (like AutoTerminateAll).
+// Otherwise they would be reparented to init when we exit.
+void Service::TerminateAdoptedOrphans()
+{
+#if HAVE_PR_SET_CHILD_SUBREAPER
+    DIR* dir = opendir("/proc");
+    if (dir == nullptr)
+    {
+        TRACE_ERROR("Failed to enumerate processes (%d).\n", errno);
+        return;
+    }
+
+    const int selfPid = getpid();
+    while (const struct dirent* entry = readdir(dir))
+    {
+        char* end;
+        const long pid = strtol(entry->d_name, &end, 10);
+        if (*end != '\0' || pid <= 0 || GetParentPid(entry->d_name) != selfPid)
+        {
+            continue;
+        }
+
+        if (g_ChildProcessStateMap.GetByPid(static_cast<int>(pid)))
+        {
+            // Our own child; AutoTerminateAll has taken care of it.
+            continue;
+        }
+
+        TRACE_INFO("Terminating adopted PID %ld.\n", pid);
+        if (kill(static_cast<pid_t>(pid), SIGTERM) == 0)
+        {
+            kill(static_cast<pid_t>(pid), SIGCONT);
+        }
+    }
+
+    closedir(dir);
+#endif
+}
+
+// Write the event trace to ${TMPDIR:-/tmp}/AsmichiChildProcessHelper.<pid>.<n>.trace.json.
+void Service::WriteTraceFile()
+{
+    const char* tmpdir = getenv("TMPDIR");
+    if (tmpdir == nullptr || tmpdir[0] == '\0')
+    {
+        tmpdir = "/tmp";
+    }
+
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/AsmichiChildProcessHelper.%d.%d.trace.json", tmpdir, static_cast<int>(getpid()), traceFileCount_++);
+
+    const int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd == -1)
+    {
+        TRACE_ERROR("Failed to create %s (%d).\n", path, errno);
+        return;
     }
+
+    const auto json = SerializeTraceAsChromeJson();
+    if (!WriteExactBytes(fd, json.data(), json.size()))
+    {
+        TRACE_ERROR("Failed to write %s (%d).\n", path, errno);
+    }
+    close(fd);
 }
 
 void Service::HandleMainChannelInput()
@@ -331,6 +511,10 @@ void Service::HandleMainChannelOutput()
         TRACE_INFO("Main channel disconnected: fflush %d\n", errno);
         InitiateShutdown();
     }
+
+    const auto pendingBytes = mainChannel_->GetPendingBytes();
+    g_Statistics.SetPendingMainChannelBytes(pendingBytes);
+    RecordTraceEvent(TraceEventType::NotificationFlushed, 0, static_cast<std::int32_t>(pendingBytes));
 }
 
 void Service::NotifyClientOfExitedChild(ChildProcessState* pState, siginfo_t siginfo)
@@ -360,4 +544,9 @@ void Service::NotifyClientOfExitedChild(ChildProcessState* pState, siginfo_t sig
         TRACE_INFO("Main channel disconnected: send %d\n", errno);
         InitiateShutdown();
     }
+
+    const auto pendingBytes = mainChannel_->GetPendingBytes();
+    g_Statistics.SetPendingMainChannelBytes(pendingBytes);
+    RecordTraceEvent(TraceEventType::NotificationFlushed, cen.Token, static_cast<std::int32_t>(pendingBytes));
+    PROBE_NOTIFY(cen.Token, cen.ProcessID, cen.Status, pendingBytes);
 }
@@ -30,6 +30,10 @@ void SetupSignalHandlers()
     {
         SetSignalAction(SIGQUIT, 0);
     }
+    if (!IsSignalIgnored(SIGUSR1))
+    {
+        SetSignalAction(SIGUSR1, 0);
+    }
     if (!IsSignalIgnored(SIGPIPE))
     {
         SetSignalAction(SIGPIPE, 0);
@@ -85,6 +89,7 @@ void SignalHandler(int signum, siginfo_t*, void*)
     {
     case SIGQUIT:
     case SIGCHLD:
+    case SIGUSR1:
     {
         const int err = errno;
         g_Service.NotifySignal(signum);
@@ -14,6 +14,7 @@
 #include <memory>
 #include <optional>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <unistd.h>
 #include <utility>
 
@@ -34,6 +35,34 @@ bool RecvExactBytes(int fd, void* buf, std::size_t len) noexcept
     return ReadExactBytes(f, buf, len);
 }
 
+namespace
+{
+    // Skips n bytes in iov.
+    void AdvanceIovecs(iovec*& iov, std::size_t& iovCount, std::size_t n) noexcept
+    {
+        while (iovCount > 0 && n >= iov->iov_len)
+        {
+            n -= iov->iov_len;
+            iov++;
+            iovCount--;
+        }
+
+        if (n > 0)
+        {
+            assert(iovCount > 0);
+            iov->iov_base = static_cast<std::byte*>(iov->iov_base) + n;
+            iov->iov_len -= n;
+        }
+
+        // Drop leading empty entries so that iov (if any) points to the next byte to send.
+        while (iovCount > 0 && iov->iov_len == 0)
+        {
+            iov++;
+            iovCount--;
+        }
+    }
+} // namespace
+
 bool SendExactBytesWithFd(int fd, const void* buf, std::size_t len, const int* fds, std::size_t fdCount) noexcept
 {
     if (fds == nullptr || fdCount == 0)
@@ -41,24 +70,58 @@ bool SendExactBytesWithFd(int fd, const void* buf, std::size_t len, const int* f
         return SendExactBytes(fd, buf, len);
     }
 
-    // Make sure to send fds only once.
-    ssize_t bytesSent = SendWithFd(fd, buf, len, fds, fdCount, BlockingFlag::Blocking);
-    if (!HandleSendResult(BlockingFlag::Blocking, "sendmsg", bytesSent, errno))
+    iovec iov;
+    iov.iov_base = const_cast<void*>(buf);
+    iov.iov_len = len;
+    return SendExactIovecsWithFd(fd, &iov, 1, fds, fdCount);
+}
+
+bool SendExactIovecsWithFd(int fd, iovec* iov, std::size_t iovCount, const int* fds, std::size_t fdCount) noexcept
+{
+    std::size_t len = 0;
+    for (std::size_t i = 0; i < iovCount; i++)
     {
+        len += iov[i].iov_len;
+    }
+
+    // Each sendmsg call can carry up to SocketMaxFdsPerCall fds.
+    // Attach each leading batch to a single byte so that the receiver will receive at most one batch per recvmsg call.
+    const std::size_t batchCount = (fdCount + SocketMaxFdsPerCall - 1) / SocketMaxFdsPerCall;
+    if (len < batchCount)
+    {
+        errno = EINVAL;
         return false;
     }
 
-    // Send out remaining bytes.
-    std::size_t positiveBytesSent = static_cast<std::size_t>(bytesSent);
-    if (positiveBytesSent >= len)
+    AdvanceIovecs(iov, iovCount, 0);
+    while (fdCount > SocketMaxFdsPerCall)
     {
-        assert(positiveBytesSent == len);
-        return true;
+        ssize_t bytesSent = SendWithFd(fd, iov->iov_base, 1, fds, SocketMaxFdsPerCall, BlockingFlag::Blocking);
+        if (!HandleSendResult(BlockingFlag::Blocking, "sendmsg", bytesSent, errno))
+        {
+            return false;
+        }
+
+        AdvanceIovecs(iov, iovCount, 1);
+        fds += SocketMaxFdsPerCall;
+        fdCount -= SocketMaxFdsPerCall;
     }
-    else
+
+    // Make sure to send fds only once.
+    while (iovCount > 0)
     {
-        return SendExactBytes(fd, static_cast<const std::byte*>(buf) + positiveBytesSent, len - positiveBytesSent);
+        ssize_t bytesSent = SendIovecsWithFd(fd, iov, iovCount, fds, fdCount, BlockingFlag::Blocking);
+        if (!HandleSendResult(BlockingFlag::Blocking, "sendmsg", bytesSent, errno))
+        {
+            return false;
+        }
+
+        AdvanceIovecs(iov, iovCount, static_cast<std::size_t>(bytesSent));
+        fds = nullptr;
+        fdCount = 0;
     }
+
+    return true;
 }
 
 ssize_t SendWithFd(int fd, const void* buf, std::size_t len, const int* fds, std::size_t fdCount, BlockingFlag blocking) noexcept
@@ -68,31 +131,42 @@ ssize_t SendWithFd(int fd, const void* buf, std::size_t len, const int* fds, std
         return send_restarting(fd, buf, len, MakeSockFlags(blocking));
     }
 
+    iovec iov;
+    iov.iov_base = const_cast<void*>(buf);
+    iov.iov_len = len;
+    return SendIovecsWithFd(fd, &iov, 1, fds, fdCount, blocking);
+}
+
+ssize_t SendIovecsWithFd(int fd, const iovec* iov, std::size_t iovCount, const int* fds, std::size_t fdCount, BlockingFlag blocking) noexcept
+{
     if (fdCount > SocketMaxFdsPerCall)
     {
         errno = EINVAL;
         return -1;
     }
 
-    iovec iov;
     msghdr msg;
     CmsgFds cmsgFds;
 
-    iov.iov_base = const_cast<void*>(buf);
-    iov.iov_len = len;
     msg.msg_name = nullptr;
     msg.msg_namelen = 0;
-    msg.msg_iov = &iov;
-    msg.msg_iovlen = 1;
-    msg.msg_control = cmsgFds.Buffer;
-    msg.msg_controllen = CMSG_SPACE(sizeof(int) * fdCount);
+    msg.msg_iov = const_cast<iovec*>(iov);
+    msg.msg_iovlen = iovCount;
+    msg.msg_control = nullptr;
+    msg.msg_controllen = 0;
     msg.msg_flags = 0;
 
-    struct cmsghdr* pcmsghdr = CMSG_FIRSTHDR(&msg);
-    pcmsghdr->cmsg_len = CMSG_LEN(sizeof(int) * fdCount);
-    pcmsghdr->cmsg_level = SOL_SOCKET;
-    pcmsghdr->cmsg_type = SCM_RIGHTS;
-    std::memcpy(CMSG_DATA(pcmsghdr), fds, sizeof(int) * fdCount);
+    if (fds != nullptr && fdCount != 0)
+    {
+        msg.msg_control = cmsgFds.Buffer;
+        msg.msg_controllen = CMSG_SPACE(sizeof(int) * fdCount);
+
+        struct cmsghdr* pcmsghdr = CMSG_FIRSTHDR(&msg);
+        pcmsghdr->cmsg_len = CMSG_LEN(sizeof(int) * fdCount);
+        pcmsghdr->cmsg_level = SOL_SOCKET;
+        pcmsghdr->cmsg_type = SCM_RIGHTS;
+        std::memcpy(CMSG_DATA(pcmsghdr), fds, sizeof(int) * fdCount);
+    }
 
     return sendmsg_restarting(fd, &msg, MakeSockFlags(blocking));
 }
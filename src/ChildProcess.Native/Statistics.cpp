@@ -0,0 +1,122 @@
+// Copyright (c) @asmichi (https://github.com/asmichi). Licensed under the MIT License. See LICENCE in the project root for details.
+
+#include "Statistics.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    // floor(log2(value)) clamped to [0, bucketCount - 1].
+    int GetLog2Bucket(std::uint64_t value, int bucketCount) noexcept
+    {
+        int bucket = 0;
+        while (value >>= 1)
+        {
+            bucket++;
+        }
+        return std::min(bucket, bucketCount - 1);
+    }
+
+    template<typename T>
+    void Append(std::vector<std::byte>* buf, T value)
+    {
+        const auto offset = buf->size();
+        buf->resize(offset + sizeof(T));
+        std::memcpy(buf->data() + offset, &value, sizeof(T));
+    }
+} // namespace
+
+void Statistics::RecordSpawn(int err, std::uint64_t latencyMicroseconds) noexcept
+{
+    if (err == 0)
+    {
+        spawnCount_.fetch_add(1, std::memory_order_relaxed);
+    }
+    else
+    {
+        spawnFailureCount_.fetch_add(1, std::memory_order_relaxed);
+        spawnFailuresByErrno_[err > 0 && err < MaxTrackedErrno ? err : 0].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    spawnLatencyHistogram_[GetLog2Bucket(latencyMicroseconds, SpawnLatencyBucketCount)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void Statistics::RecordReapBatch(std::uint32_t reapedCount, std::uint32_t orphanCount) noexcept
+{
+    if (reapedCount == 0)
+    {
+        return;
+    }
+
+    reapCount_.fetch_add(reapedCount, std::memory_order_relaxed);
+    orphanReapCount_.fetch_add(orphanCount, std::memory_order_relaxed);
+    reapBatchHistogram_[GetLog2Bucket(reapedCount, ReapBatchBucketCount)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void Statistics::RecordNotificationBatch(std::size_t count) noexcept
+{
+    UpdateMax(maxNotificationBatchSize_, count);
+}
+
+void Statistics::SetPendingMainChannelBytes(std::size_t bytes) noexcept
+{
+    pendingMainChannelBytes_.store(bytes, std::memory_order_relaxed);
+}
+
+void Statistics::UpdateMax(std::atomic<std::uint64_t>& target, std::uint64_t value) noexcept
+{
+    auto current = target.load(std::memory_order_relaxed);
+    while (current < value && !target.compare_exchange_weak(current, value, std::memory_order_relaxed))
+    {
+    }
+}
+
+void Statistics::Serialize(std::vector<std::byte>* buf, std::uint64_t liveChildCount, std::uint64_t subchannelCount, std::uint64_t notificationQueueDepth) const
+{
+    auto load = [](const std::atomic<std::uint64_t>& x) { return x.load(std::memory_order_relaxed); };
+
+    Append(buf, load(spawnCount_));
+    Append(buf, load(spawnFailureCount_));
+    Append(buf, liveChildCount);
+    Append(buf, subchannelCount);
+    Append(buf, load(pendingMainChannelBytes_));
+    Append(buf, notificationQueueDepth);
+    Append(buf, load(maxNotificationBatchSize_));
+    Append(buf, load(reapCount_));
+    Append(buf, load(orphanReapCount_));
+
+    Append(buf, static_cast<std::uint32_t>(SpawnLatencyBucketCount));
+    for (const auto& x : spawnLatencyHistogram_)
+    {
+        Append(buf, load(x));
+    }
+
+    Append(buf, static_cast<std::uint32_t>(ReapBatchBucketCount));
+    for (const auto& x : reapBatchHistogram_)
+    {
+        Append(buf, load(x));
+    }
+
+    // Take a snapshot first so that the entry count matches the entries.
+    std::uint64_t failuresByErrno[MaxTrackedErrno];
+    std::uint32_t errnoEntryCount = 0;
+    for (int i = 0; i < MaxTrackedErrno; i++)
+    {
+        failuresByErrno[i] = load(spawnFailuresByErrno_[i]);
+        errnoEntryCount += failuresByErrno[i] != 0;
+    }
+
+    Append(buf, errnoEntryCount);
+    for (int i = 0; i < MaxTrackedErrno; i++)
+    {
+        if (failuresByErrno[i] != 0)
+        {
+            Append(buf, static_cast<std::int32_t>(i));
+            Append(buf, failuresByErrno[i]);
+        }
+    }
+}
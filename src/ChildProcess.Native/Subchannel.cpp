@@ -6,18 +6,28 @@
 #include "BinaryReader.hpp"
 #include "ChildProcessState.hpp"
 #include "ErrorCodeExceptions.hpp"
+#include "EventTrace.hpp"
 #include "Globals.hpp"
+#include "JobState.hpp"
 #include "MiscHelpers.hpp"
+#include "OutputMultiplexer.hpp"
+#include "OutputTee.hpp"
+#include "Probes.hpp"
 #include "Request.hpp"
 #include "Service.hpp"
+#include "Statistics.hpp"
 #include "UniqueResource.hpp"
 #include "config.h"
 #include <algorithm>
 #include <cassert>
+#include <climits>
 #include <cstdint>
 #include <cstdio>
 #include <cstring>
+#include <fcntl.h>
+#include <initializer_list>
 #include <memory>
+#include <mutex>
 #include <poll.h>
 #include <spawn.h>
 #include <unistd.h>
@@ -29,6 +39,14 @@
 #define HAVE_COMPLETE_CLOEXEC 0
 #endif
 
+// On Linux, vfork suspends the parent until the child performs exec or exits, so that the child can report an exec error
+// through the shared address space. Elsewhere, fall back to fork with a pipe-based handshake.
+#if HAVE_COMPLETE_CLOEXEC && defined(__linux__)
+#define USE_VFORK 1
+#else
+#define USE_VFORK 0
+#endif
+
 class ScopedPosixSpawnFileActions final
 {
 public:
@@ -83,6 +101,42 @@ private:
     bool initialized_ = false;
 };
 
+namespace
+{
+    // Brackets a spawn with ChildProcessStateMap::BeginSpawn/EndSpawn.
+    // Complete right after allocating the child and before notifying the service of the registration.
+    class PendingSpawnScope final
+    {
+    public:
+        PendingSpawnScope() noexcept { g_ChildProcessStateMap.BeginSpawn(); }
+        ~PendingSpawnScope() { Complete(); }
+        PendingSpawnScope(const PendingSpawnScope&) = delete;
+        PendingSpawnScope& operator=(const PendingSpawnScope&) = delete;
+
+        void Complete() noexcept
+        {
+            if (!completed_)
+            {
+                g_ChildProcessStateMap.EndSpawn();
+                completed_ = true;
+            }
+        }
+
+    private:
+        bool completed_ = false;
+    };
+
+    void CreateCapturePipe(UniqueFd* pWriteEnd, UniqueFd* pReadEnd, std::uint32_t bufferSize);
+    int GetMaxTargetFd(const SpawnProcessRequest& r) noexcept;
+    [[nodiscard]] bool MoveFdAbove(UniqueFd& fd, int maxFd) noexcept;
+    void CloseNonInheritedFds(const SpawnProcessRequest& r, int extraFdToKeep) noexcept;
+#if USE_VFORK
+    std::pair<int, int> CreateProcessWithVfork(const SpawnProcessRequest& r, int processGroup, SpawnTimings* pTimings);
+#else
+    std::pair<int, int> CreateProcessWithFork(const SpawnProcessRequest& r, int processGroup, SpawnTimings* pTimings);
+#endif
+} // namespace
+
 // After StartCommunicationThread succeeds, this instance must not be manipulated outside the communication thread.
 bool Subchannel::StartCommunicationThread()
 {
@@ -103,6 +157,8 @@ void* Subchannel::CommunicationThreadFunc(void* arg)
 {
     auto const pSubchannel = static_cast<Subchannel*>(arg);
 
+    SetTraceThreadName("subchannel");
+
     try
     {
         pSubchannel->CommunicationLoop();
@@ -134,15 +190,52 @@ void Subchannel::CommunicationLoop()
         {
             RawRequest rawRequest;
             RecvRawRequest(&rawRequest);
+            RecordTraceEvent(TraceEventType::RequestReceived, 0, static_cast<std::int32_t>(rawRequest.Command));
 
             switch (rawRequest.Command)
             {
             case RequestCommand::SpawnProcess:
-                HandleProcessCreationCommand(std::move(rawRequest.Body), rawRequest.BodyLength);
+                HandleProcessCreationCommand(rawRequest.Body, rawRequest.BodyLength);
                 break;
 
             case RequestCommand::SendSignal:
-                HandleSendSignalCommand(std::move(rawRequest.Body), rawRequest.BodyLength);
+                HandleSendSignalCommand(rawRequest.Body, rawRequest.BodyLength);
+                break;
+
+            case RequestCommand::SendSignalBulk:
+                HandleSendSignalBulkCommand(rawRequest.Body, rawRequest.BodyLength);
+                break;
+
+            case RequestCommand::CreateJob:
+                HandleCreateJobCommand(rawRequest.Body, rawRequest.BodyLength);
+                break;
+
+            case RequestCommand::SendSignalToJob:
+                HandleSendSignalToJobCommand(rawRequest.Body, rawRequest.BodyLength);
+                break;
+
+            case RequestCommand::GetJobStatistics:
+                HandleGetJobStatisticsCommand(rawRequest.Body, rawRequest.BodyLength);
+                break;
+
+            case RequestCommand::CloseJob:
+                HandleCloseJobCommand(rawRequest.Body, rawRequest.BodyLength);
+                break;
+
+            case RequestCommand::GetStatistics:
+                HandleGetStatisticsCommand(rawRequest.BodyLength);
+                break;
+
+            case RequestCommand::DumpTrace:
+                HandleDumpTraceCommand(rawRequest.BodyLength);
+                break;
+
+            case RequestCommand::CreateOutputMultiplexer:
+                HandleCreateOutputMultiplexerCommand(rawRequest.Body, rawRequest.BodyLength);
+                break;
+
+            case RequestCommand::CloseOutputMultiplexer:
+                HandleCloseOutputMultiplexerCommand(rawRequest.Body, rawRequest.BodyLength);
                 break;
 
             default:
@@ -158,18 +251,84 @@ void Subchannel::CommunicationLoop()
     }
 }
 
-void Subchannel::HandleProcessCreationCommand(std::unique_ptr<std::byte[]> body, std::uint32_t bodyLength)
+void Subchannel::HandleProcessCreationCommand(const std::byte* body, std::uint32_t bodyLength)
 {
-    SpawnProcessRequest r;
-    ToProcessCreationRequest(&r, std::move(body), bodyLength);
+    auto& r = spawnProcessRequest_;
+
+    SpawnTimings timings{};
+    timings.RequestReceived = GetMonotonicNanoseconds();
+
+    std::pair<int, int> result;
+    bool shouldReportTimings = false;
+    try
+    {
+        ToProcessCreationRequest(&r, body, bodyLength);
+        shouldReportTimings = r.Flags & RequestFlagsReportTimings;
+
+        const auto startTime = GetMonotonicMicroseconds();
+        RecordTraceEvent(TraceEventType::Fork, r.Token);
+        PROBE_SPAWN_START(r.Token, r.JobToken);
+        result = CreateProcess(r, &timings);
+        const auto latency = GetMonotonicMicroseconds() - startTime;
+        PROBE_SPAWN_DONE(r.Token, result.second, result.first, latency);
+        RecordTraceEvent(TraceEventType::ExecResult, r.Token, result.first == 0 ? result.second : -result.first);
+        g_Statistics.RecordSpawn(result.first, latency);
+
+        if (result.first == 0 && r.Multiplexer)
+        {
+            // If the client has closed the multiplexer concurrently, the read ends are just closed and the child will get EPIPE.
+            if (r.CapturedStdoutFd.IsValid())
+            {
+                static_cast<void>(r.Multiplexer->AddSource(r.OutputTag, CapturedStream::Stdout, std::move(r.CapturedStdoutFd)));
+            }
+            if (r.CapturedStderrFd.IsValid())
+            {
+                static_cast<void>(r.Multiplexer->AddSource(r.OutputTag, CapturedStream::Stderr, std::move(r.CapturedStderrFd)));
+            }
+        }
+
+        if (result.first == 0)
+        {
+            // If we fail to start a tee, the read end is just closed and the child will get EPIPE.
+            if (r.TeedStdoutFd.IsValid()
+                && !OutputTee::Start(std::make_unique<OutputTee>(std::move(r.TeedStdoutFd), std::move(r.StdoutTeeSinks))))
+            {
+                TRACE_ERROR("Failed to start the tee for stdout of %llu.\n", static_cast<unsigned long long>(r.Token));
+            }
+            if (r.TeedStderrFd.IsValid()
+                && !OutputTee::Start(std::make_unique<OutputTee>(std::move(r.TeedStderrFd), std::move(r.StderrTeeSinks))))
+            {
+                TRACE_ERROR("Failed to start the tee for stderr of %llu.\n", static_cast<unsigned long long>(r.Token));
+            }
+        }
+    }
+    catch (...)
+    {
+        // Do not keep the received fds open until the next request, including the ones not taken yet.
+        ResetSpawnProcessRequest(&r);
+        while (sock_.PopReceivedFd())
+        {
+        }
+        throw;
+    }
+
+    ResetSpawnProcessRequest(&r);
 
-    const auto [err, childPid] = CreateProcess(r);
+    const auto [err, childPid] = result;
     SendResponse(err, childPid);
+
+    if (err == 0 && shouldReportTimings)
+    {
+        if (!sock_.SendExactBytes(&timings, sizeof(timings)))
+        {
+            throw CommunicationError(errno);
+        }
+    }
 }
 
-void Subchannel::ToProcessCreationRequest(SpawnProcessRequest* r, std::unique_ptr<std::byte[]> body, std::uint32_t bodyLength)
+void Subchannel::ToProcessCreationRequest(SpawnProcessRequest* r, const std::byte* body, std::uint32_t bodyLength)
 {
-    DeserializeSpawnProcessRequest(r, std::move(body), bodyLength);
+    DeserializeSpawnProcessRequest(r, body, bodyLength);
 
     auto popOrThrow = [this] {
         auto maybeFd = sock_.PopReceivedFd();
@@ -193,177 +352,510 @@ void Subchannel::ToProcessCreationRequest(SpawnProcessRequest* r, std::unique_pt
     {
         r->StderrFd = popOrThrow();
     }
+    for (auto& entry : r->FdMap)
+    {
+        entry.SourceFd = popOrThrow();
+    }
+    for (auto* pSinks : {&r->StdoutTeeSinks, &r->StderrTeeSinks})
+    {
+        for (auto& sink : *pSinks)
+        {
+            sink.Fd = popOrThrow();
+            if (sink.Backpressure == TeeBackpressure::Spill)
+            {
+                sink.SpillFd = popOrThrow();
+            }
+        }
+    }
     if (sock_.ReceivedFdCount() != 0)
     {
         TRACE_ERROR("Too many fds in a request. Flags=%x, %zu fds remaining.\n", r->Flags, sock_.ReceivedFdCount());
         throw BadRequestError(ErrorCode::InvalidRequest);
     }
-}
 
-std::pair<int, int> Subchannel::CreateProcess(const SpawnProcessRequest& r)
-{
-    const bool shouldCreateNewProcessGroup = r.Flags & RequestFlagsCreateNewProcessGroup;
-    const bool shouldAutoTerminate = r.Flags & RequestFlagsEnableAutoTermination;
-    int err = 0;
+    // Validate only after all the fds of the request have been taken; otherwise they would be left for the next request.
+    if (r->JobToken != 0)
+    {
+        r->Job = g_JobStateMap.GetByToken(r->JobToken);
+        if (!r->Job)
+        {
+            TRACE_ERROR("No such job: %llu\n", static_cast<unsigned long long>(r->JobToken));
+            throw BadRequestError(ESRCH);
+        }
+        if (!(r->Flags & RequestFlagsCreateNewProcessGroup))
+        {
+            TRACE_ERROR("A member of a job must not stay in our process group.\n");
+            throw BadRequestError(ErrorCode::InvalidRequest);
+        }
+    }
 
-#if !HAVE_COMPLETE_CLOEXEC
-    // If neither CLOEXEC nor closefrom is available, fall back to POSIX_SPAWN_CLOEXEC_DEFAULT.
-    ScopedPosixSpawnFileActions fileActions;
-    ScopedPosixSpawnAttr attr;
+    const bool captureStdout = r->Flags & RequestFlagsCaptureStdout;
+    const bool captureStderr = r->Flags & RequestFlagsCaptureStderr;
+    if (captureStdout || captureStderr)
+    {
+        if ((captureStdout && (r->Flags & RequestFlagsRedirectStdout)) || (captureStderr && (r->Flags & RequestFlagsRedirectStderr)))
+        {
+            TRACE_ERROR("A captured stream must not be redirected.\n");
+            throw BadRequestError(ErrorCode::InvalidRequest);
+        }
 
-    if ((err = fileActions.Initialize()) != 0)
+        r->Multiplexer = g_OutputMultiplexerMap.GetByToken(r->OutputMultiplexerToken);
+        if (!r->Multiplexer)
+        {
+            TRACE_ERROR("No such output multiplexer: %llu\n", static_cast<unsigned long long>(r->OutputMultiplexerToken));
+            throw BadRequestError(ESRCH);
+        }
+    }
+
+    const bool teeStdout = r->Flags & RequestFlagsTeeStdout;
+    const bool teeStderr = r->Flags & RequestFlagsTeeStderr;
+    if ((teeStdout && (r->Flags & (RequestFlagsRedirectStdout | RequestFlagsCaptureStdout)))
+        || (teeStderr && (r->Flags & (RequestFlagsRedirectStderr | RequestFlagsCaptureStderr))))
+    {
+        TRACE_ERROR("A tee'd stream must not be redirected or captured.\n");
+        throw BadRequestError(ErrorCode::InvalidRequest);
+    }
+    if (teeStdout == r->StdoutTeeSinks.empty() || teeStderr == r->StderrTeeSinks.empty())
     {
-        return {err, 0};
+        TRACE_ERROR("A tee'd stream must have at least one sink and vice versa.\n");
+        throw BadRequestError(ErrorCode::InvalidRequest);
     }
-    if ((err = attr.Initialize()) != 0)
+
+    if (captureStdout)
     {
-        return {err, 0};
+        CreateCapturePipe(&r->StdoutFd, &r->CapturedStdoutFd, r->PipeBufferSize);
     }
-    if ((err = posix_spawnattr_setflags(&attr.Value, POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETEXEC | POSIX_SPAWN_CLOEXEC_DEFAULT)) != 0)
+    if (captureStderr)
     {
-        return {err, 0};
+        CreateCapturePipe(&r->StderrFd, &r->CapturedStderrFd, r->PipeBufferSize);
     }
-    // We need to call posix_spawn_file_actions_adddup2 instead of dup2 since POSIX_SPAWN_CLOEXEC_DEFAULT will close
-    // all fds except ones created by file actions.
-    if (r.StdinFd.IsValid() && (err = posix_spawn_file_actions_adddup2(&fileActions.Value, r.StdinFd.Get(), STDIN_FILENO)) != 0)
+    if (teeStdout)
     {
-        return {err, 0};
+        CreateCapturePipe(&r->StdoutFd, &r->TeedStdoutFd, r->PipeBufferSize);
     }
-    if (r.StdoutFd.IsValid() && (err = posix_spawn_file_actions_adddup2(&fileActions.Value, r.StdoutFd.Get(), STDOUT_FILENO)) != 0)
+    if (teeStderr)
     {
-        return {err, 0};
+        CreateCapturePipe(&r->StderrFd, &r->TeedStderrFd, r->PipeBufferSize);
     }
-    if (r.StderrFd.IsValid() && (err = posix_spawn_file_actions_adddup2(&fileActions.Value, r.StderrFd.Get(), STDERR_FILENO)) != 0)
+
+    // Move the source fds above all the target fds so that applying the fd map in the child will never overwrite a source fd.
+    const int maxTargetFd = GetMaxTargetFd(*r);
+    for (auto& entry : r->FdMap)
     {
-        return {err, 0};
+        if (!MoveFdAbove(entry.SourceFd, maxTargetFd))
+        {
+            throw BadRequestError(errno);
+        }
     }
+
+    // CloseNonInheritedFds requires this.
+    std::sort(r->FdMap.begin(), r->FdMap.end(), [](const FdMapEntry& x, const FdMapEntry& y) { return x.TargetFd < y.TargetFd; });
+}
+
+std::pair<int, int> Subchannel::CreateProcess(const SpawnProcessRequest& r, SpawnTimings* pTimings)
+{
+    // processGroup: -1 to stay in ours, 0 to create a new one, otherwise the process group to join.
+    auto createProcess = [&r, pTimings](int processGroup) {
+#if USE_VFORK
+        return CreateProcessWithVfork(r, processGroup, pTimings);
+#else
+        return CreateProcessWithFork(r, processGroup, pTimings);
 #endif
+    };
 
-    auto maybeOutPipe = CreatePipe();
-    if (!maybeOutPipe)
+    if (!r.Job)
     {
-        return {errno, 0};
+        return createProcess((r.Flags & RequestFlagsCreateNewProcessGroup) ? 0 : -1);
     }
-    auto maybeInPipe = CreatePipe();
-    if (!maybeInPipe)
+
+    // Hold the lock of the job until the child has joined the process group and been added to the job.
+    const std::lock_guard<std::mutex> guard(r.Job->GetMutex());
+    return createProcess(r.Job->GetProcessGroupForNewMemberLocked());
+}
+
+namespace
+{
+    void CreateCapturePipe(UniqueFd* pWriteEnd, UniqueFd* pReadEnd, std::uint32_t bufferSize)
     {
-        return {errno, 0};
+        auto maybePipe = CreatePipe();
+        if (!maybePipe)
+        {
+            throw BadRequestError(errno);
+        }
+
+        // Best effort; the default capacity still works.
+        if (bufferSize != 0 && !SetChannelBufferSize(maybePipe->WriteEnd.Get(), static_cast<int>(std::min<std::uint32_t>(bufferSize, INT_MAX))))
+        {
+            TRACE_INFO("Failed to set the pipe buffer size to %u (errno=%d).\n", static_cast<unsigned int>(bufferSize), errno);
+        }
+
+        *pWriteEnd = std::move(maybePipe->WriteEnd);
+        *pReadEnd = std::move(maybePipe->ReadEnd);
+    }
+
+    int GetMaxTargetFd(const SpawnProcessRequest& r) noexcept
+    {
+        int maxTargetFd = STDERR_FILENO;
+        for (const auto& entry : r.FdMap)
+        {
+            maxTargetFd = std::max(maxTargetFd, entry.TargetFd);
+        }
+        return maxTargetFd;
     }
 
-    // NOTE: These fds may be inherited by multiple forked processes.
-    //       Those inherited fds will only be closed when the processes perform execve.
-    // parent -> child : To signal "the parent is ready; perform exec"
-    auto outPipe = std::move(*maybeOutPipe);
-    // child -> parent : To signal exec error (or no write on success)
-    auto inPipe = std::move(*maybeInPipe);
+    bool MoveFdAbove(UniqueFd& fd, int maxFd) noexcept
+    {
+        if (fd.Get() > maxFd)
+        {
+            return true;
+        }
+
+        const int newFd = fcntl(fd.Get(), F_DUPFD_CLOEXEC, maxFd + 1);
+        if (newFd == -1)
+        {
+            return false;
+        }
 
-    int childPid = fork();
-    if (childPid == -1)
+        fd.Reset(newFd);
+        return true;
+    }
+
+    // Closes all fds >= 3 except the target fds of the fd map and extraFdToKeep (if not -1), including fds leaked without CLOEXEC.
+    // r.FdMap must be sorted by TargetFd and extraFdToKeep must be greater than all of them.
+    // Async-signal-safe.
+    void CloseNonInheritedFds(const SpawnProcessRequest& r, int extraFdToKeep) noexcept
     {
-        return {errno, 0};
+        int first = STDERR_FILENO + 1;
+        for (const auto& entry : r.FdMap)
+        {
+            CloseFdRange(first, entry.TargetFd - 1);
+            first = entry.TargetFd + 1;
+        }
+        if (extraFdToKeep != -1)
+        {
+            CloseFdRange(first, extraFdToKeep - 1);
+            first = extraFdToKeep + 1;
+        }
+        CloseFdRange(first, INT_MAX);
     }
-    else if (childPid == 0)
+
+#if USE_VFORK
+    std::pair<int, int> CreateProcessWithVfork(const SpawnProcessRequest& r, int processGroup, SpawnTimings* pTimings)
     {
-        // child
-        outPipe.WriteEnd.Reset();
-        inPipe.ReadEnd.Reset();
+        const bool shouldAutoTerminate = r.Flags & RequestFlagsEnableAutoTermination;
 
-        auto reportError = [](int fd, int err) {
-            static_cast<void>(WriteExactBytes(fd, &err, sizeof(err)));
-        };
+        // Written by the child when it fails to execute the program.
+        // The parent is suspended until the child performs exec or exits, hence no synchronization.
+        volatile int childErr = 0;
 
-#if HAVE_COMPLETE_CLOEXEC
-        auto dup2OrFail = [](const UniqueFd& writeEnd, const UniqueFd& src, int dst) {
-            if (src.IsValid())
+        PendingSpawnScope pendingSpawn;
+        int childPid = vfork();
+        if (childPid == -1)
+        {
+            const int err = errno;
+            PROBE_FORK_RETURN(r.Token, -1, (GetMonotonicNanoseconds() - pTimings->RequestReceived) / 1000);
+            return {err, 0};
+        }
+        else if (childPid == 0)
+        {
+            // child
+            // NOTE: The child shares the address space (including the stack and errno) with the parent.
+            //       Only perform async-signal-safe operations and never return from this function.
+            //       Our signal handler only writes to the notification pipe and is as safe here as in a forked child.
+            auto dup2OrFail = [&childErr](const UniqueFd& src, int dst) {
+                if (src.IsValid())
+                {
+                    if (dup2(src.Get(), dst) == -1)
+                    {
+                        childErr = errno;
+                        _exit(1);
+                    }
+                }
+            };
+
+            dup2OrFail(r.StdinFd, STDIN_FILENO);
+            dup2OrFail(r.StdoutFd, STDOUT_FILENO);
+            dup2OrFail(r.StderrFd, STDERR_FILENO);
+            for (const auto& entry : r.FdMap)
+            {
+                dup2OrFail(entry.SourceFd, entry.TargetFd);
+            }
+
+            if (r.Flags & RequestFlagsRestrictFdInheritance)
+            {
+                CloseNonInheritedFds(r, -1);
+            }
+
+            if (r.WorkingDirectory != nullptr)
             {
-                if (dup2(src.Get(), dst) == -1)
+                if (chdir_restarting(r.WorkingDirectory) == -1)
                 {
-                    int err = errno;
-                    static_cast<void>(WriteExactBytes(writeEnd.Get(), &err, sizeof(err)));
+                    childErr = errno;
                     _exit(1);
                 }
             }
-        };
-
-        dup2OrFail(inPipe.WriteEnd, r.StdinFd, STDIN_FILENO);
-        dup2OrFail(inPipe.WriteEnd, r.StdoutFd, STDOUT_FILENO);
-        dup2OrFail(inPipe.WriteEnd, r.StderrFd, STDERR_FILENO);
-#endif
 
-        if (r.WorkingDirectory != nullptr)
-        {
-            if (chdir_restarting(r.WorkingDirectory) == -1)
+            // Joining the process group of a job fails (EPERM) if the group has vanished since the parent chose it.
+            // Do not let such a child run outside the job.
+            if (processGroup >= 0 && setpgid(0, processGroup) == -1)
             {
-                reportError(inPipe.WriteEnd.Get(), errno);
+                childErr = errno;
                 _exit(1);
             }
-        }
 
-        // Wait for the parent to be ready
-        char c;
-        if (!ReadExactBytes(outPipe.ReadEnd.Get(), &c, 1))
-        {
-            // The parent has been SIGKILLed; no point in continuing.
-            // 
-            // In such a case, there is a rare race condition where multiple forked processes get stuck in ReadExactBytes
-            // since outPipe.ReadEnd may be inherited by multiple forked processes.
-            // We have no way to avoid such inheritance; that is how concurrent forks work. Never SIGKILL!!!
+            // NOTE: POSIX specifies execve shall not modify argv and envp.
+            execve(r.ExecutablePath, const_cast<char* const*>(&r.Argv[0]), const_cast<char* const*>(&r.Envp[0]));
+            childErr = errno;
             _exit(1);
         }
-
-        if (shouldCreateNewProcessGroup)
+        else
         {
-            setpgid(0, 0);
-        }
+            // parent
+            // The child has either performed exec or exited. Even if it has exited, register it so that it will be reaped.
+            // The parent has been suspended until the child performed exec.
+            pTimings->ForkReturned = GetMonotonicNanoseconds();
+            pTimings->ChildReleased = pTimings->ForkReturned;
+            pTimings->ExecConfirmed = pTimings->ForkReturned;
+            PROBE_FORK_RETURN(r.Token, childPid, (pTimings->ForkReturned - pTimings->RequestReceived) / 1000);
+
+            if (r.Job)
+            {
+                r.Job->AddMemberLocked(childPid, processGroup);
+            }
+            // Signals to a member of a job should only reach the member itself.
+            g_ChildProcessStateMap.Allocate(childPid, r.Token, processGroup == 0 && !r.Job, shouldAutoTerminate, r.Job);
+            pendingSpawn.Complete();
 
-#if HAVE_COMPLETE_CLOEXEC
-        // NOTE: POSIX specifies execve shall not modify argv and envp.
-        execve(r.ExecutablePath, const_cast<char* const*>(&r.Argv[0]), const_cast<char* const*>(&r.Envp[0]));
-        reportError(inPipe.WriteEnd.Get(), errno);
-#else
-        // This will behave as a more featureful execve since POSIX_SPAWN_SETEXEC is set.
-        err = posix_spawn(nullptr, r.ExecutablePath, &fileActions.Value, &attr.Value, const_cast<char* const*>(&r.Argv[0]), const_cast<char* const*>(&r.Envp[0]));
-        reportError(inPipe.WriteEnd.Get(), err);
-#endif
+            // Send a reap request in case the child has already exited and we have delayed reaping.
+            g_Service.NotifyChildRegistration();
 
-        _exit(1);
+            if (childErr != 0)
+            {
+                // Failed to execute the program: failed to dup2, chdir, setpgid or execve.
+                PROBE_EXEC_FAILURE(r.Token, childPid, childErr, 0);
+                return {childErr, 0};
+            }
+
+            PROBE_EXEC_SUCCESS(r.Token, childPid, 0);
+            return {0, childPid};
+        }
     }
-    else
+#else
+    std::pair<int, int> CreateProcessWithFork(const SpawnProcessRequest& r, int processGroup, SpawnTimings* pTimings)
     {
-        // parent
-        outPipe.ReadEnd.Reset();
-        inPipe.WriteEnd.Reset();
+        const bool shouldAutoTerminate = r.Flags & RequestFlagsEnableAutoTermination;
+        int err = 0;
 
-        // Register the child before the child performs exec.
-        g_ChildProcessStateMap.Allocate(childPid, r.Token, shouldCreateNewProcessGroup, shouldAutoTerminate);
+#if !HAVE_COMPLETE_CLOEXEC
+        // If neither CLOEXEC nor closefrom is available, fall back to POSIX_SPAWN_CLOEXEC_DEFAULT.
+        ScopedPosixSpawnFileActions fileActions;
+        ScopedPosixSpawnAttr attr;
 
-        // Send a reap request in case the child has already been killed and we have delayed reaping.
-        g_Service.NotifyChildRegistration();
+        if ((err = fileActions.Initialize()) != 0)
+        {
+            return {err, 0};
+        }
+        if ((err = attr.Initialize()) != 0)
+        {
+            return {err, 0};
+        }
+        if ((err = posix_spawnattr_setflags(&attr.Value, POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETEXEC | POSIX_SPAWN_CLOEXEC_DEFAULT)) != 0)
+        {
+            return {err, 0};
+        }
+        if (processGroup > 0 && (err = posix_spawnattr_setpgroup(&attr.Value, processGroup)) != 0)
+        {
+            return {err, 0};
+        }
+        // We need to call posix_spawn_file_actions_adddup2 instead of dup2 since POSIX_SPAWN_CLOEXEC_DEFAULT will close
+        // all fds except ones created by file actions.
+        if (r.StdinFd.IsValid() && (err = posix_spawn_file_actions_adddup2(&fileActions.Value, r.StdinFd.Get(), STDIN_FILENO)) != 0)
+        {
+            return {err, 0};
+        }
+        if (r.StdoutFd.IsValid() && (err = posix_spawn_file_actions_adddup2(&fileActions.Value, r.StdoutFd.Get(), STDOUT_FILENO)) != 0)
+        {
+            return {err, 0};
+        }
+        if (r.StderrFd.IsValid() && (err = posix_spawn_file_actions_adddup2(&fileActions.Value, r.StderrFd.Get(), STDERR_FILENO)) != 0)
+        {
+            return {err, 0};
+        }
+        for (const auto& entry : r.FdMap)
+        {
+            if ((err = posix_spawn_file_actions_adddup2(&fileActions.Value, entry.SourceFd.Get(), entry.TargetFd)) != 0)
+            {
+                return {err, 0};
+            }
+        }
+#endif
 
-        // Make the child to perform exec.
-        if (!WriteExactBytes(outPipe.WriteEnd.Get(), "", 1))
+        auto maybeOutPipe = CreatePipe();
+        if (!maybeOutPipe)
         {
-            // The child has already been killed.
             return {errno, 0};
         }
+        auto maybeInPipe = CreatePipe();
+        if (!maybeInPipe)
+        {
+            return {errno, 0};
+        }
+
+        // NOTE: These fds may be inherited by multiple forked processes.
+        //       Those inherited fds will only be closed when the processes perform execve.
+        // parent -> child : To signal "the parent is ready; perform exec"
+        auto outPipe = std::move(*maybeOutPipe);
+        // child -> parent : To signal exec error (or no write on success)
+        auto inPipe = std::move(*maybeInPipe);
 
-        const bool execSuccessful = !ReadExactBytes(inPipe.ReadEnd.Get(), &err, sizeof(err));
-        if (execSuccessful)
+        // Keep the child ends out of the way of the fd map.
+        const int maxTargetFd = GetMaxTargetFd(r);
+        if (!MoveFdAbove(outPipe.ReadEnd, maxTargetFd) || !MoveFdAbove(inPipe.WriteEnd, maxTargetFd))
         {
-            return {0, childPid};
+            return {errno, 0};
         }
-        else
+
+        PendingSpawnScope pendingSpawn;
+        int childPid = fork();
+        if (childPid == -1)
         {
-            // Failed to execute the program: failed to dup2 or execve.
+            err = errno;
+            PROBE_FORK_RETURN(r.Token, -1, (GetMonotonicNanoseconds() - pTimings->RequestReceived) / 1000);
             return {err, 0};
         }
+        else if (childPid == 0)
+        {
+            // child
+            outPipe.WriteEnd.Reset();
+            inPipe.ReadEnd.Reset();
+
+            auto reportError = [](int fd, int err) {
+                static_cast<void>(WriteExactBytes(fd, &err, sizeof(err)));
+            };
+
+#if HAVE_COMPLETE_CLOEXEC
+            auto dup2OrFail = [](const UniqueFd& writeEnd, const UniqueFd& src, int dst) {
+                if (src.IsValid())
+                {
+                    if (dup2(src.Get(), dst) == -1)
+                    {
+                        int err = errno;
+                        static_cast<void>(WriteExactBytes(writeEnd.Get(), &err, sizeof(err)));
+                        _exit(1);
+                    }
+                }
+            };
+
+            dup2OrFail(inPipe.WriteEnd, r.StdinFd, STDIN_FILENO);
+            dup2OrFail(inPipe.WriteEnd, r.StdoutFd, STDOUT_FILENO);
+            dup2OrFail(inPipe.WriteEnd, r.StderrFd, STDERR_FILENO);
+            for (const auto& entry : r.FdMap)
+            {
+                dup2OrFail(inPipe.WriteEnd, entry.SourceFd, entry.TargetFd);
+            }
+#endif
+
+            if (r.WorkingDirectory != nullptr)
+            {
+                if (chdir_restarting(r.WorkingDirectory) == -1)
+                {
+                    reportError(inPipe.WriteEnd.Get(), errno);
+                    _exit(1);
+                }
+            }
+
+            // Wait for the parent to be ready
+            char c;
+            if (!ReadExactBytes(outPipe.ReadEnd.Get(), &c, 1))
+            {
+                // The parent has been SIGKILLed; no point in continuing.
+                // 
+                // In such a case, there is a rare race condition where multiple forked processes get stuck in ReadExactBytes
+                // since outPipe.ReadEnd may be inherited by multiple forked processes.
+                // We have no way to avoid such inheritance; that is how concurrent forks work. Never SIGKILL!!!
+                _exit(1);
+            }
+
+#if HAVE_COMPLETE_CLOEXEC
+            // Keep inPipe.WriteEnd to report an exec error. (If !HAVE_COMPLETE_CLOEXEC, POSIX_SPAWN_CLOEXEC_DEFAULT does this job.)
+            if (r.Flags & RequestFlagsRestrictFdInheritance)
+            {
+                CloseNonInheritedFds(r, inPipe.WriteEnd.Get());
+            }
+#endif
+
+            // Joining the process group of a job fails (EPERM) if the group has vanished since the parent chose it.
+            // Do not let such a child run outside the job.
+            if (processGroup >= 0 && setpgid(0, processGroup) == -1)
+            {
+                reportError(inPipe.WriteEnd.Get(), errno);
+                _exit(1);
+            }
+
+#if HAVE_COMPLETE_CLOEXEC
+            // NOTE: POSIX specifies execve shall not modify argv and envp.
+            execve(r.ExecutablePath, const_cast<char* const*>(&r.Argv[0]), const_cast<char* const*>(&r.Envp[0]));
+            reportError(inPipe.WriteEnd.Get(), errno);
+#else
+            // This will behave as a more featureful execve since POSIX_SPAWN_SETEXEC is set.
+            err = posix_spawn(nullptr, r.ExecutablePath, &fileActions.Value, &attr.Value, const_cast<char* const*>(&r.Argv[0]), const_cast<char* const*>(&r.Envp[0]));
+            reportError(inPipe.WriteEnd.Get(), err);
+#endif
+
+            _exit(1);
+        }
+        else
+        {
+            // parent
+            pTimings->ForkReturned = GetMonotonicNanoseconds();
+            PROBE_FORK_RETURN(r.Token, childPid, (pTimings->ForkReturned - pTimings->RequestReceived) / 1000);
+
+            outPipe.ReadEnd.Reset();
+            inPipe.WriteEnd.Reset();
+
+            // Register the child before the child performs exec.
+            if (r.Job)
+            {
+                r.Job->AddMemberLocked(childPid, processGroup);
+            }
+            // Signals to a member of a job should only reach the member itself.
+            g_ChildProcessStateMap.Allocate(childPid, r.Token, processGroup == 0 && !r.Job, shouldAutoTerminate, r.Job);
+            pendingSpawn.Complete();
+
+            // Send a reap request in case the child has already been killed and we have delayed reaping.
+            g_Service.NotifyChildRegistration();
+
+            // Make the child to perform exec.
+            if (!WriteExactBytes(outPipe.WriteEnd.Get(), "", 1))
+            {
+                // The child has already been killed.
+                return {errno, 0};
+            }
+            pTimings->ChildReleased = GetMonotonicNanoseconds();
+            RecordTraceEvent(TraceEventType::ExecReleased, r.Token, childPid);
+
+            const bool execSuccessful = !ReadExactBytes(inPipe.ReadEnd.Get(), &err, sizeof(err));
+            pTimings->ExecConfirmed = GetMonotonicNanoseconds();
+            if (execSuccessful)
+            {
+                PROBE_EXEC_SUCCESS(r.Token, childPid, (pTimings->ExecConfirmed - pTimings->ForkReturned) / 1000);
+                return {0, childPid};
+            }
+            else
+            {
+                // Failed to execute the program: failed to dup2, chdir, setpgid or execve.
+                PROBE_EXEC_FAILURE(r.Token, childPid, err, (pTimings->ExecConfirmed - pTimings->ForkReturned) / 1000);
+                return {err, 0};
+            }
+        }
     }
-}
+#endif
+} // namespace
 
-void Subchannel::HandleSendSignalCommand(std::unique_ptr<std::byte[]> body, std::uint32_t bodyLength)
+void Subchannel::HandleSendSignalCommand(const std::byte* body, std::uint32_t bodyLength)
 {
     SendSignalRequest r;
-    DeserializeSendSignalRequest(&r, std::move(body), bodyLength);
+    DeserializeSendSignalRequest(&r, body, bodyLength);
 
     auto nativeSignal = ToNativeSignal(r.Signal);
     if (!nativeSignal)
@@ -393,19 +885,230 @@ void Subchannel::HandleSendSignalCommand(std::unique_ptr<std::byte[]> body, std:
     }
 }
 
+void Subchannel::HandleSendSignalBulkCommand(const std::byte* body, std::uint32_t bodyLength)
+{
+    auto& r = sendSignalBulkRequest_;
+    DeserializeSendSignalBulkRequest(&r, body, bodyLength);
+
+    auto nativeSignal = ToNativeSignal(r.Signal);
+    if (!nativeSignal)
+    {
+        throw BadRequestError(ErrorCode::InvalidRequest);
+    }
+
+    g_ChildProcessStateMap.GetByTokens(r.Tokens, &signalBulkTargets_);
+
+    // Report only failures; the process having already been reaped is not a failure.
+    signalBulkFailures_.clear();
+    for (std::size_t i = 0; i < signalBulkTargets_.size(); i++)
+    {
+        const auto& pState = signalBulkTargets_[i];
+        if (pState && !pState->SendSignal(nativeSignal.value(), r.Signal == AbstractSignal::Termination) && errno != ESRCH)
+        {
+            signalBulkFailures_.push_back({static_cast<std::uint32_t>(i), errno});
+        }
+    }
+
+    signalBulkTargets_.clear();
+
+    SendSuccess(static_cast<std::int32_t>(signalBulkFailures_.size()));
+    if (!signalBulkFailures_.empty()
+        && !sock_.SendExactBytes(signalBulkFailures_.data(), sizeof(SendSignalBulkFailure) * signalBulkFailures_.size()))
+    {
+        throw CommunicationError(errno);
+    }
+}
+
+void Subchannel::HandleCreateJobCommand(const std::byte* body, std::uint32_t bodyLength)
+{
+    CreateJobRequest r;
+    DeserializeCreateJobRequest(&r, body, bodyLength);
+
+    if (r.Token == 0 || !g_JobStateMap.Create(r.Token, r.Flags & JobFlagsKillOnClose))
+    {
+        TRACE_ERROR("Invalid or duplicate job token: %llu\n", static_cast<unsigned long long>(r.Token));
+        throw BadRequestError(ErrorCode::InvalidRequest);
+    }
+
+    SendSuccess(0);
+}
+
+void Subchannel::HandleSendSignalToJobCommand(const std::byte* body, std::uint32_t bodyLength)
+{
+    SendSignalToJobRequest r;
+    DeserializeSendSignalToJobRequest(&r, body, bodyLength);
+
+    auto nativeSignal = ToNativeSignal(r.Signal);
+    if (!nativeSignal)
+    {
+        throw BadRequestError(ErrorCode::InvalidRequest);
+    }
+
+    auto pJob = g_JobStateMap.GetByToken(r.Token);
+    if (!pJob)
+    {
+        throw BadRequestError(ESRCH);
+    }
+
+    if (pJob->SendSignal(nativeSignal.value(), r.Signal == AbstractSignal::Termination))
+    {
+        SendSuccess(0);
+    }
+    else
+    {
+        SendError(errno);
+    }
+}
+
+void Subchannel::HandleGetJobStatisticsCommand(const std::byte* body, std::uint32_t bodyLength)
+{
+    JobRequest r;
+    DeserializeJobRequest(&r, body, bodyLength);
+
+    auto pJob = g_JobStateMap.GetByToken(r.Token);
+    if (!pJob)
+    {
+        throw BadRequestError(ESRCH);
+    }
+
+    const JobStatistics statistics = pJob->GetStatistics();
+    SendSuccess(0);
+    if (!sock_.SendExactBytes(&statistics, sizeof(statistics)))
+    {
+        throw CommunicationError(errno);
+    }
+}
+
+void Subchannel::HandleCloseJobCommand(const std::byte* body, std::uint32_t bodyLength)
+{
+    JobRequest r;
+    DeserializeJobRequest(&r, body, bodyLength);
+
+    auto pJob = g_JobStateMap.Remove(r.Token);
+    if (!pJob)
+    {
+        throw BadRequestError(ESRCH);
+    }
+
+    if (pJob->ShouldKillOnClose() && !pJob->SendSignal(SIGKILL))
+    {
+        SendError(errno);
+    }
+    else
+    {
+        SendSuccess(0);
+    }
+}
+
+void Subchannel::HandleGetStatisticsCommand(std::uint32_t bodyLength)
+{
+    if (bodyLength != 0)
+    {
+        throw BadRequestError(ErrorCode::InvalidRequest);
+    }
+
+    std::vector<std::byte> buf;
+    g_Statistics.Serialize(&buf, g_ChildProcessStateMap.Size(), g_Service.GetSubchannelCount(), g_Service.GetNotificationQueueDepth());
+
+    SendSuccess(static_cast<std::int32_t>(buf.size()));
+    if (!sock_.SendExactBytes(buf.data(), buf.size()))
+    {
+        throw CommunicationError(errno);
+    }
+}
+
+void Subchannel::HandleDumpTraceCommand(std::uint32_t bodyLength)
+{
+    if (bodyLength != 0)
+    {
+        throw BadRequestError(ErrorCode::InvalidRequest);
+    }
+
+    const auto json = SerializeTraceAsChromeJson();
+
+    SendSuccess(static_cast<std::int32_t>(json.size()));
+    if (!sock_.SendExactBytes(json.data(), json.size()))
+    {
+        throw CommunicationError(errno);
+    }
+}
+
+void Subchannel::HandleCreateOutputMultiplexerCommand(const std::byte* body, std::uint32_t bodyLength)
+{
+    // Take the sink first so that it will not be left for the next request.
+    auto maybeSinkFd = sock_.PopReceivedFd();
+    if (!maybeSinkFd || sock_.ReceivedFdCount() != 0)
+    {
+        TRACE_ERROR("CreateOutputMultiplexer requires exactly one fd.\n");
+        while (sock_.PopReceivedFd())
+        {
+        }
+        throw BadRequestError(ErrorCode::InvalidRequest);
+    }
+
+    OutputMultiplexerRequest r;
+    DeserializeOutputMultiplexerRequest(&r, body, bodyLength);
+
+    if (r.Token == 0)
+    {
+        throw BadRequestError(ErrorCode::InvalidRequest);
+    }
+
+    const int err = g_OutputMultiplexerMap.Create(r.Token, std::move(*maybeSinkFd));
+    if (err != 0)
+    {
+        TRACE_ERROR("Failed to create output multiplexer %llu: %d\n", static_cast<unsigned long long>(r.Token), err);
+        SendError(err);
+    }
+    else
+    {
+        SendSuccess(0);
+    }
+}
+
+void Subchannel::HandleCloseOutputMultiplexerCommand(const std::byte* body, std::uint32_t bodyLength)
+{
+    OutputMultiplexerRequest r;
+    DeserializeOutputMultiplexerRequest(&r, body, bodyLength);
+
+    auto pMultiplexer = g_OutputMultiplexerMap.Remove(r.Token);
+    if (!pMultiplexer)
+    {
+        throw BadRequestError(ESRCH);
+    }
+
+    pMultiplexer->Complete();
+    SendSuccess(0);
+}
+
 std::optional<int> Subchannel::ToNativeSignal(AbstractSignal abstractSignal) noexcept
 {
     switch (abstractSignal)
     {
+    case AbstractSignal::Hangup:
+        return SIGHUP;
+
     case AbstractSignal::Interrupt:
         return SIGINT;
 
     case AbstractSignal::Kill:
         return SIGKILL;
 
+    case AbstractSignal::User1:
+        return SIGUSR1;
+
+    case AbstractSignal::User2:
+        return SIGUSR2;
+
     case AbstractSignal::Termination:
         return SIGTERM;
 
+    case AbstractSignal::Continue:
+        return SIGCONT;
+
+    case AbstractSignal::Stop:
+        return SIGSTOP;
+
     default:
         return std::nullopt;
     }
@@ -413,13 +1116,26 @@ std::optional<int> Subchannel::ToNativeSignal(AbstractSignal abstractSignal) noe
 
 void Subchannel::RecvRawRequest(RawRequest* r)
 {
+    // Discard the previous request and move any bytes following it to the front.
+    if (requestConsumedLength_ > 0)
+    {
+        requestBufferedLength_ -= requestConsumedLength_;
+        std::memmove(requestBuffer_.get(), requestBuffer_.get() + requestConsumedLength_, requestBufferedLength_);
+        requestConsumedLength_ = 0;
+    }
+
+    // A request that fits in SingleMessageRequestLength (the header, the body and the fds attached to them) arrives with one recvmsg call.
+    // A larger one arrives as the header with the fds, followed by the body.
+    // Either way, never receive the bytes carrying fds partially (see SingleMessageRequestLength).
     std::uint32_t commandAndLength[2];
-    if (!sock_.RecvExactBytes(&commandAndLength, sizeof(commandAndLength)))
+    const std::size_t headerLength = sizeof(commandAndLength);
+    EnsureRequestBuffer(requestBufferedLength_ + SingleMessageRequestLength);
+    while (requestBufferedLength_ < headerLength)
     {
-        // Throws even for a normal shutdown (errno = 0).
-        throw CommunicationError(errno);
+        RecvIntoRequestBuffer(requestBufferLength_ - requestBufferedLength_, BlockingFlag::Blocking);
     }
 
+    std::memcpy(commandAndLength, requestBuffer_.get(), headerLength);
     const RequestCommand command = static_cast<RequestCommand>(commandAndLength[0]);
     const std::uint32_t bodyLength = commandAndLength[1];
 
@@ -428,35 +1144,75 @@ void Subchannel::RecvRawRequest(RawRequest* r)
         TRACE_ERROR("Request too big: %u\n", static_cast<unsigned int>(bodyLength));
 
         // Discard the request body.
-        const size_t BufSize = 64 * 1024;
-        auto buf = std::make_unique<std::byte[]>(BufSize);
-        size_t totalReceivedBytes = 0;
-        while (totalReceivedBytes < bodyLength)
-        {
-            std::size_t bytesToReceive = std::min(BufSize, bodyLength - totalReceivedBytes);
-            ssize_t receivedBytes = sock_.Recv(buf.get(), bytesToReceive, BlockingFlag::Blocking);
-            if (receivedBytes <= 0)
-            {
-                throw CommunicationError(errno);
-            }
-            totalReceivedBytes += receivedBytes;
+        // NOTE: The buffer never grows beyond MaxRequestLength + headerLength, so we have not received the whole body yet.
+        std::size_t remainingBytes = bodyLength - (requestBufferedLength_ - headerLength);
+        while (remainingBytes > 0)
+        {
+            requestBufferedLength_ = 0;
+            remainingBytes -= RecvIntoRequestBuffer(std::min(requestBufferLength_, remainingBytes), BlockingFlag::Blocking);
         }
+        requestBufferedLength_ = 0;
 
         throw BadRequestError(E2BIG);
     }
 
-    auto body = std::make_unique<std::byte[]>(bodyLength);
-    if (!sock_.RecvExactBytes(&body[0], bodyLength))
+    const std::size_t requestLength = headerLength + bodyLength;
+    EnsureRequestBuffer(requestLength);
+    while (requestBufferedLength_ < requestLength)
     {
-        // Throws even for a normal shutdown (errno = 0).
-        throw CommunicationError(errno);
+        // The rest of the body is likely to have arrived already; avoid an extra poll.
+        const std::size_t bytesToReceive = requestLength - requestBufferedLength_;
+        if (RecvIntoRequestBuffer(bytesToReceive, BlockingFlag::NonBlocking) == 0)
+        {
+            RecvIntoRequestBuffer(bytesToReceive, BlockingFlag::Blocking);
+        }
     }
 
+    requestConsumedLength_ = requestLength;
     r->BodyLength = bodyLength;
-    r->Body = std::move(body);
+    r->Body = requestBuffer_.get() + headerLength;
     r->Command = command;
 }
 
+// Receives up to len bytes at the end of the buffered bytes.
+// return: the number of received bytes (0 only if nonblocking and no data is available)
+std::size_t Subchannel::RecvIntoRequestBuffer(std::size_t len, BlockingFlag blocking)
+{
+    assert(requestBufferedLength_ + len <= requestBufferLength_);
+
+    const ssize_t receivedBytes = sock_.Recv(requestBuffer_.get() + requestBufferedLength_, len, blocking);
+    if (receivedBytes > 0)
+    {
+        requestBufferedLength_ += static_cast<std::size_t>(receivedBytes);
+        return static_cast<std::size_t>(receivedBytes);
+    }
+    else if (receivedBytes == -1 && blocking == BlockingFlag::NonBlocking && IsWouldBlockError(errno))
+    {
+        return 0;
+    }
+    else
+    {
+        // Throws even for a normal shutdown (errno = 0).
+        throw CommunicationError(receivedBytes == 0 ? 0 : errno);
+    }
+}
+
+void Subchannel::EnsureRequestBuffer(std::size_t length)
+{
+    if (length > requestBufferLength_)
+    {
+        // Not using std::vector to avoid zero-filling.
+        std::unique_ptr<std::byte[]> newBuffer{new std::byte[length]};
+        if (requestBufferedLength_ > 0)
+        {
+            std::memcpy(newBuffer.get(), requestBuffer_.get(), requestBufferedLength_);
+        }
+
+        requestBuffer_ = std::move(newBuffer);
+        requestBufferLength_ = length;
+    }
+}
+
 void Subchannel::SendSuccess(std::int32_t data)
 {
     SendResponse(0, data);
@@ -36,10 +36,14 @@ void WriteBuffer::Enqueue(const void* buf, std::size_t len)
     }
 
     assert(byteBuf == pEnd);
+    pendingBytes_ += len;
 }
 
 void WriteBuffer::Dequeue(std::size_t len) noexcept
 {
+    assert(len <= pendingBytes_);
+    pendingBytes_ -= len;
+
     while (len != 0)
     {
         auto& front = blocks_.front();
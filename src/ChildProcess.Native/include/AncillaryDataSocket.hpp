@@ -3,6 +3,7 @@
 #pragma once
 
 #include "Base.hpp"
+#include "SocketHelpers.hpp"
 #include "UniqueResource.hpp"
 #include "WriteBuffer.hpp"
 #include <cstddef>
@@ -14,7 +15,7 @@
 class AncillaryDataSocket final
 {
 public:
-    static const constexpr int MaxFdsPerCall = 3;
+    static const constexpr int MaxFdsPerCall = SocketMaxFdsPerCall;
 
     AncillaryDataSocket(UniqueFd&& sockFd, int cancellationPipeReadEnd) noexcept;
 
@@ -23,6 +24,7 @@ public:
     [[nodiscard]] bool SendBuffered(const void* buf, std::size_t len, BlockingFlag blocking) noexcept;
     [[nodiscard]] bool Flush(BlockingFlag blocking) noexcept;
     [[nodiscard]] bool HasPendingData() noexcept { return sendBuffer_.HasPendingData(); }
+    [[nodiscard]] std::size_t GetPendingBytes() const noexcept { return sendBuffer_.GetPendingBytes(); }
 
     [[nodiscard]] ssize_t Recv(void* buf, std::size_t len, BlockingFlag blocking) noexcept;
     [[nodiscard]] bool RecvExactBytes(void* buf, std::size_t len) noexcept;
@@ -2,6 +2,8 @@
 
 #pragma once
 
+#include "JobState.hpp"
+#include <atomic>
 #include <cassert>
 #include <cstdint>
 #include <cstdio>
@@ -13,13 +15,14 @@
 #include <sys/wait.h>
 #include <unistd.h>
 #include <unordered_map>
+#include <vector>
 
 // ChildProcessState should not access g_ChildProcessStateMap to avoid dead locks.
 class ChildProcessState final
 {
 public:
-    ChildProcessState(int pid, std::uint64_t token, bool isNewProcessGroup, bool shouldAutoTerminate)
-        : token_(token), pid_(pid), isNewProcessGroup_(isNewProcessGroup), shouldAutoTerminate_(shouldAutoTerminate) {}
+    ChildProcessState(int pid, std::uint64_t token, bool isNewProcessGroup, bool shouldAutoTerminate, std::shared_ptr<JobState> job)
+        : token_(token), pid_(pid), isNewProcessGroup_(isNewProcessGroup), shouldAutoTerminate_(shouldAutoTerminate), job_(std::move(job)) {}
 
     std::uint64_t GetToken() const { return token_; }
     int GetPid() const { return pid_; }
@@ -39,6 +42,8 @@ private:
     const int pid_;
     const bool isNewProcessGroup_;
     const bool shouldAutoTerminate_;
+    // The job this process belongs to, if any.
+    const std::shared_ptr<JobState> job_;
     bool isReaped_ = false;
 };
 
@@ -50,16 +55,27 @@ private:
 class ChildProcessStateMap final
 {
 public:
-    void Allocate(int pid, std::uint64_t token, bool isNewProcessGroup, bool shouldAutoTerminate);
+    void Allocate(int pid, std::uint64_t token, bool isNewProcessGroup, bool shouldAutoTerminate, std::shared_ptr<JobState> job);
     [[nodiscard]] std::shared_ptr<ChildProcessState> GetByPid(int pid) const; // Used by the reaping process only.
     [[nodiscard]] std::shared_ptr<ChildProcessState> GetByToken(std::uint64_t token) const;
+    // Looks up all the tokens with one lock acquisition. Stores nullptr for a token not found.
+    void GetByTokens(const std::vector<std::uint64_t>& tokens, std::vector<std::shared_ptr<ChildProcessState>>* states) const;
     void Delete(ChildProcessState* pState);
+    [[nodiscard]] std::size_t Size() const;
 
     // Send SIGTERM then SIGCONT to all children whose shouldAutoTerminate_ is set.
     // Should only be called from the service (main) thread.
     void AutoTerminateAll();
 
+    // Bracket a spawn: from just before fork until the child has been allocated.
+    // While no spawn is pending, every child of ours not in the map is an adopted orphan (in the subreaper mode).
+    void BeginSpawn() noexcept { pendingSpawnCount_.fetch_add(1); }
+    void EndSpawn() noexcept { pendingSpawnCount_.fetch_sub(1); }
+    [[nodiscard]] bool HasPendingSpawn() const noexcept { return pendingSpawnCount_.load() != 0; }
+
 private:
+    std::atomic<int> pendingSpawnCount_{0};
+
     // Serializes lookup, insertion and removal.
     mutable std::mutex mapMutex_;
     std::unordered_map<int, std::shared_ptr<ChildProcessState>> byPid_;
@@ -0,0 +1,38 @@
+// Copyright (c) @asmichi (https://github.com/asmichi). Licensed under the MIT License. See LICENCE in the project root for details.
+
+#pragma once
+
+// Low-overhead binary trace of spawn/reap lifecycle events, dumped on demand as a Chrome trace (also read by Perfetto).
+//
+// Each thread records into its own fixed-size ring, hence no locking on the hot path (except the first event of a thread).
+// Old events are overwritten. The ring of an exited thread is retained and reused by a later thread.
+
+#include <cstdint>
+#include <string>
+
+enum class TraceEventType : std::uint32_t
+{
+    // Arg: command
+    RequestReceived,
+    // Token: process token
+    Fork,
+    // Token: process token, Arg: pid. (The fork implementation only.)
+    ExecReleased,
+    // Token: process token, Arg: pid on success, -errno on failure
+    ExecResult,
+    // SIGCHLD (a reap request) processed by the service thread.
+    ChildSignal,
+    // Token: process token (0 for an adopted orphan), Arg: pid
+    Reap,
+    // Token: process token (0 when flushing), Arg: pending bytes left in the main channel
+    NotificationFlushed,
+};
+
+// Must not be called in a vfork child or a signal handler.
+void RecordTraceEvent(TraceEventType type, std::uint64_t token = 0, std::int32_t arg = 0) noexcept;
+
+// Names the track of the current thread in dumps. name must be a string literal.
+void SetTraceThreadName(const char* name) noexcept;
+
+// Serializes all recorded events in the Chrome trace event format (JSON).
+[[nodiscard]] std::string SerializeTraceAsChromeJson();
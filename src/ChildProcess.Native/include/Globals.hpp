@@ -5,5 +5,14 @@
 class ChildProcessStateMap;
 extern ChildProcessStateMap g_ChildProcessStateMap;
 
+class JobStateMap;
+extern JobStateMap g_JobStateMap;
+
+class OutputMultiplexerMap;
+extern OutputMultiplexerMap g_OutputMultiplexerMap;
+
 class Service;
 extern Service g_Service;
+
+class Statistics;
+extern Statistics g_Statistics;
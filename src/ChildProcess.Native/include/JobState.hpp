@@ -0,0 +1,78 @@
+// Copyright (c) @asmichi (https://github.com/asmichi). Licensed under the MIT License. See LICENCE in the project root for details.
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <sys/resource.h>
+#include <unordered_map>
+
+// NOTE: Make sure to sync with the client.
+struct JobStatistics final
+{
+    std::uint32_t LiveMemberCount;
+    std::uint32_t TotalMemberCount;
+    std::uint64_t UserTimeMicroseconds;
+    std::uint64_t SystemTimeMicroseconds;
+    std::uint64_t MaxResidentSetBytes;
+};
+
+// A set of child processes that share one process group so that they (and their descendants) can be signaled at once.
+//
+// NOTE: A process group ID can be recycled once the group becomes empty.
+//       We only signal the group while it has a live (unreaped) member, which keeps the ID in use.
+//       Adding and reaping members are serialized by the mutex of the job.
+class JobState final
+{
+public:
+    JobState(std::uint64_t token, bool killOnClose) noexcept : token_(token), killOnClose_(killOnClose) {}
+
+    std::uint64_t GetToken() const noexcept { return token_; }
+    bool ShouldKillOnClose() const noexcept { return killOnClose_; }
+
+    // Lock this while spawning a member and while reaping a member.
+    std::mutex& GetMutex() const noexcept { return mutex_; }
+
+    // Pre: GetMutex() is held.
+    // Returns the process group a new member should join, or 0 if a new member should create a new one.
+    int GetProcessGroupForNewMemberLocked() const noexcept;
+    // Pre: GetMutex() is held. processGroup: the return value of GetProcessGroupForNewMemberLocked.
+    void AddMemberLocked(int pid, int processGroup) noexcept;
+    // Pre: GetMutex() is held. The member has just been reaped.
+    void RemoveMemberLocked(const struct rusage& ru) noexcept;
+
+    // Signals all members (including their descendants that have not left the process group).
+    [[nodiscard]] bool SendSignal(int sig, bool alsoSendSigCont = false) const;
+    JobStatistics GetStatistics() const;
+
+private:
+    mutable std::mutex mutex_;
+    const std::uint64_t token_;
+    const bool killOnClose_;
+    int processGroup_ = 0;
+    std::uint32_t liveMemberCount_ = 0;
+    std::uint32_t totalMemberCount_ = 0;
+    // Accumulated over reaped members.
+    std::uint64_t userTimeMicroseconds_ = 0;
+    std::uint64_t systemTimeMicroseconds_ = 0;
+    std::uint64_t maxResidentSetBytes_ = 0;
+};
+
+// Maintains jobs created by the client.
+class JobStateMap final
+{
+public:
+    [[nodiscard]] bool Create(std::uint64_t token, bool killOnClose);
+    [[nodiscard]] std::shared_ptr<JobState> GetByToken(std::uint64_t token) const;
+    // Removes the job from the map. The job lives on while it has members.
+    [[nodiscard]] std::shared_ptr<JobState> Remove(std::uint64_t token);
+
+    // Kill all members of jobs whose killOnClose is set (as if the client closed them).
+    // Should only be called from the service (main) thread.
+    void KillAllOnClose();
+
+private:
+    mutable std::mutex mapMutex_;
+    std::unordered_map<std::uint64_t, std::shared_ptr<JobState>> byToken_;
+};
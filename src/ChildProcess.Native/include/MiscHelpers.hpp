@@ -6,6 +6,7 @@
 
 #include "UniqueResource.hpp"
 #include <array>
+#include <cstdint>
 #include <optional>
 #include <pthread.h>
 
@@ -23,6 +24,14 @@ struct pollfd;
 [[nodiscard]] int poll_restarting(struct pollfd* fds, unsigned int nfds, int timeout) noexcept;
 [[nodiscard]] int chdir_restarting(const char* path) noexcept;
 
+// CLOCK_MONOTONIC in microseconds.
+[[nodiscard]] std::uint64_t GetMonotonicMicroseconds() noexcept;
+// CLOCK_MONOTONIC in nanoseconds.
+[[nodiscard]] std::uint64_t GetMonotonicNanoseconds() noexcept;
+
+// Closes all fds in [first, last] (ignoring errors). Async-signal-safe; can be called in a vfork child.
+void CloseFdRange(int first, int last) noexcept;
+
 // RAII wrappers.
 struct PipeEnds
 {
@@ -32,8 +41,22 @@ struct PipeEnds
 
 [[nodiscard]] std::optional<PipeEnds> CreatePipe() noexcept;
 [[nodiscard]] std::optional<UniqueFd> CreateUnixStreamSocket() noexcept;
+// Sets the buffer capacity of a pipe (F_SETPIPE_SZ, bounded by /proc/sys/fs/pipe-max-size; no-op where unsupported)
+// or a socket (SO_SNDBUF and SO_RCVBUF).
+[[nodiscard]] bool SetChannelBufferSize(int fd, int size) noexcept;
 [[nodiscard]] std::optional<std::array<UniqueFd, 2>> CreateUnixStreamSocketPair() noexcept;
 [[nodiscard]] std::optional<UniqueFd> DuplicateFd(int fd) noexcept;
+// Creates a read-only file that has the specified content, positioned at the beginning:
+// a sealed memfd if available, otherwise an unlinked temporary file.
+[[nodiscard]] std::optional<UniqueFd> CreateReadOnlyMemoryFile(const void* data, std::size_t len) noexcept;
+// Creates an empty temporary file on disk (in $TMPDIR or /tmp) that has already been unlinked.
+[[nodiscard]] std::optional<UniqueFd> CreateUnlinkedTemporaryFile() noexcept;
+// Creates a file to capture output into: a memfd if available, otherwise an unlinked temporary file.
+// If maxLength is not negative, a memfd cannot grow beyond maxLength.
+[[nodiscard]] std::optional<UniqueFd> CreateCaptureMemoryFile(std::int64_t maxLength) noexcept;
+// Maps the content written to a file created by CreateCaptureMemoryFile (at most maxLength bytes if not negative) read-only.
+// *outAddr is nullptr if the content is empty.
+[[nodiscard]] bool MapCapturedMemoryFile(int fd, std::int64_t maxLength, void** outAddr, std::size_t* outLen) noexcept;
 
 // Wrappers with my default values.
 enum CreateThreadFlags : int
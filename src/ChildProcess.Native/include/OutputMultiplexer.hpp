@@ -0,0 +1,104 @@
+// Copyright (c) @asmichi (https://github.com/asmichi). Licensed under the MIT License. See LICENCE in the project root for details.
+
+#pragma once
+
+#include "UniqueResource.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// NOTE: Make sure to sync with the client.
+enum class CapturedStream : std::uint32_t
+{
+    Stdout = 0,
+    Stderr = 1,
+};
+
+// Precedes each chunk of captured output in the sink. A chunk of length 0 indicates EOF of the stream.
+// NOTE: Make sure to sync with the client.
+struct OutputFrameHeader final
+{
+    std::uint64_t Tag;
+    // CLOCK_MONOTONIC in nanoseconds when the chunk was read.
+    std::uint64_t Timestamp;
+    std::uint32_t Length;
+    CapturedStream Stream;
+};
+static_assert(sizeof(OutputFrameHeader) == 24);
+
+// The maximum length of the data of a frame.
+const std::size_t MaxOutputFrameDataLength = 64 * 1024;
+
+// Reads stdout/stderr pipes of many children on one thread and writes them to a single sink (a pipe to the client or a file)
+// as framed chunks, preserving the order in which the chunks were read.
+//
+// The sink is written with blocking writes: if the client does not drain it, the children eventually block on their pipes.
+// If the sink breaks, the output is read and discarded so that the children never block.
+class OutputMultiplexer final : public std::enable_shared_from_this<OutputMultiplexer>
+{
+public:
+    OutputMultiplexer(std::uint64_t token, UniqueFd sinkFd, UniqueFd wakeupReadEnd, UniqueFd wakeupWriteEnd) noexcept
+        : token_(token), wakeupReadEnd_(std::move(wakeupReadEnd)), wakeupWriteEnd_(std::move(wakeupWriteEnd)), sinkFd_(std::move(sinkFd))
+    {
+    }
+
+    std::uint64_t GetToken() const noexcept { return token_; }
+
+    [[nodiscard]] bool StartThread();
+
+    // Starts capturing fd. Returns false (closing fd) if the multiplexer has already finished.
+    bool AddSource(std::uint64_t tag, CapturedStream stream, UniqueFd fd);
+    // No more sources will be added. The sink will be closed after all sources reach EOF.
+    void Complete() noexcept;
+
+private:
+    struct Source final
+    {
+        std::uint64_t Tag;
+        CapturedStream Stream;
+        UniqueFd Fd;
+    };
+
+    static void* ThreadFunc(void* arg);
+    void Run();
+    // return: false if the source reached EOF (or failed).
+    bool ReadSource(const Source& source);
+    void AppendFrame(const Source& source, const std::byte* data, std::size_t length);
+    void FlushFrames() noexcept;
+    void Wakeup() noexcept;
+
+    const std::uint64_t token_;
+    const UniqueFd wakeupReadEnd_;
+    const UniqueFd wakeupWriteEnd_;
+
+    // Protects the following fields.
+    std::mutex mutex_;
+    std::vector<Source> pendingSources_;
+    bool completed_ = false;
+    bool finished_ = false;
+
+    // Owned by the multiplexer thread.
+    UniqueFd sinkFd_;
+    std::vector<Source> sources_;
+    std::vector<std::byte> frames_;
+    std::unique_ptr<std::byte[]> readBuffer_;
+    bool sinkBroken_ = false;
+};
+
+// Maintains output multiplexers created by the client.
+class OutputMultiplexerMap final
+{
+public:
+    // Returns 0 or errno.
+    [[nodiscard]] int Create(std::uint64_t token, UniqueFd sinkFd);
+    [[nodiscard]] std::shared_ptr<OutputMultiplexer> GetByToken(std::uint64_t token) const;
+    // Removes the multiplexer from the map. It lives on until all of its sources reach EOF.
+    [[nodiscard]] std::shared_ptr<OutputMultiplexer> Remove(std::uint64_t token);
+
+private:
+    mutable std::mutex mapMutex_;
+    std::unordered_map<std::uint64_t, std::shared_ptr<OutputMultiplexer>> byToken_;
+};
@@ -0,0 +1,66 @@
+// Copyright (c) @asmichi (https://github.com/asmichi). Licensed under the MIT License. See LICENCE in the project root for details.
+
+#pragma once
+
+#include "UniqueResource.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// NOTE: Make sure to sync with the client.
+enum class TeeBackpressure : std::uint32_t
+{
+    // Wait until the sink accepts the output (the child eventually blocks on its pipe).
+    Block = 0,
+    // Discard the output the sink cannot accept immediately.
+    Drop = 1,
+    // Write the output the sink cannot accept immediately to the spill fd instead.
+    Spill = 2,
+};
+
+struct TeeSink final
+{
+    UniqueFd Fd;
+    TeeBackpressure Backpressure;
+    // Valid only for TeeBackpressure::Spill.
+    UniqueFd SpillFd;
+};
+
+// The maximum number of sinks of one tee'd stream.
+const std::uint32_t MaxTeeSinkCount = 8;
+
+// Copies the output of a child (the read end of its stdout/stderr pipe) to multiple sinks on a dedicated thread
+// until EOF, then closes the sinks.
+//
+// On Linux, the output is moved with splice(2) and duplicated with tee(2) without being copied to userspace.
+// A sink that fails (for example, EPIPE) is closed and skipped afterwards.
+class OutputTee final
+{
+public:
+    OutputTee(UniqueFd sourceFd, std::vector<TeeSink> sinks) noexcept
+        : sourceFd_(std::move(sourceFd)), sinks_(std::move(sinks))
+    {
+    }
+
+    // Starts the thread that owns the tee. Returns false (closing everything) on failure.
+    [[nodiscard]] static bool Start(std::unique_ptr<OutputTee> tee) noexcept;
+
+private:
+    static void* ThreadFunc(void* arg);
+    void Run() noexcept;
+#if defined(__linux__)
+    // return: false if splice/tee are not supported for the fds.
+    bool RunWithSplice() noexcept;
+    void DeliverStaged(TeeSink& sink, int stageFd, std::size_t length) noexcept;
+#endif
+    void RunWithBuffer() noexcept;
+    void Deliver(TeeSink& sink, const std::byte* data, std::size_t length) noexcept;
+    void Discard(int stageFd, std::size_t length) noexcept;
+    bool IsSinkReady(const TeeSink& sink) noexcept;
+    void MarkBroken(TeeSink& sink) noexcept;
+
+    UniqueFd sourceFd_;
+    std::vector<TeeSink> sinks_;
+    std::unique_ptr<std::byte[]> buffer_;
+};
@@ -0,0 +1,103 @@
+// Copyright (c) @asmichi (https://github.com/asmichi). Licensed under the MIT License. See LICENCE in the project root for details.
+
+#pragma once
+
+// USDT (statically defined tracing) probes for perf, bpftrace, etc. Enabled by -DENABLE_USDT=ON (Linux only).
+//
+// Emits the same ELF notes (.note.stapsdt) as <sys/sdt.h> without depending on it.
+// A probe is a single nop; tracers find it through the note and patch it only while attached.
+// When disabled, probes compile to nothing and their arguments are not evaluated.
+//
+// Provider: asmichi_childprocess. All arguments are signed and pointer-sized. See tools/spawn-latency.bt.
+
+#include "config.h"
+
+#if ENABLE_USDT && defined(__linux__) && defined(__ELF__)
+#define ASMICHI_PROBES_ENABLED 1
+#else
+#define ASMICHI_PROBES_ENABLED 0
+#endif
+
+#if ASMICHI_PROBES_ENABLED
+
+#if defined(__LP64__)
+#define ASMICHI_PROBE_ADDR ".8byte"
+#define ASMICHI_PROBE_ARG(n) "-8@%" #n
+#else
+#define ASMICHI_PROBE_ADDR ".4byte"
+#define ASMICHI_PROBE_ARG(n) "-4@%" #n
+#endif
+
+// See https://sourceware.org/systemtap/wiki/UserSpaceProbeImplementation for the note format.
+#define ASMICHI_PROBE_ASM(name, argFormat) \
+    "990: nop\n" \
+    ".pushsection .note.stapsdt,\"?\",\"note\"\n" \
+    ".balign 4\n" \
+    ".4byte 992f-991f, 994f-993f, 3\n" \
+    "991: .asciz \"stapsdt\"\n" \
+    "992: .balign 4\n" \
+    "993: " ASMICHI_PROBE_ADDR " 990b\n" \
+    ASMICHI_PROBE_ADDR " _.stapsdt.base\n" \
+    ASMICHI_PROBE_ADDR " 0\n" \
+    ".asciz \"asmichi_childprocess\"\n" \
+    ".asciz \"" #name "\"\n" \
+    ".asciz \"" argFormat "\"\n" \
+    "994: .balign 4\n" \
+    ".popsection\n" \
+    ".ifndef _.stapsdt.base\n" \
+    ".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n" \
+    ".weak _.stapsdt.base\n" \
+    ".hidden _.stapsdt.base\n" \
+    "_.stapsdt.base: .space 1\n" \
+    ".size _.stapsdt.base, 1\n" \
+    ".popsection\n" \
+    ".endif\n"
+
+#define ASMICHI_PROBE_OPERAND(x) "nor"(static_cast<long>(x))
+
+#define ASMICHI_PROBE2(name, a0, a1) \
+    __asm__ __volatile__(ASMICHI_PROBE_ASM(name, ASMICHI_PROBE_ARG(0) " " ASMICHI_PROBE_ARG(1)) \
+                         : \
+                         : ASMICHI_PROBE_OPERAND(a0), ASMICHI_PROBE_OPERAND(a1))
+#define ASMICHI_PROBE3(name, a0, a1, a2) \
+    __asm__ __volatile__(ASMICHI_PROBE_ASM(name, ASMICHI_PROBE_ARG(0) " " ASMICHI_PROBE_ARG(1) " " ASMICHI_PROBE_ARG(2)) \
+                         : \
+                         : ASMICHI_PROBE_OPERAND(a0), ASMICHI_PROBE_OPERAND(a1), ASMICHI_PROBE_OPERAND(a2))
+#define ASMICHI_PROBE4(name, a0, a1, a2, a3) \
+    __asm__ __volatile__(ASMICHI_PROBE_ASM(name, ASMICHI_PROBE_ARG(0) " " ASMICHI_PROBE_ARG(1) " " ASMICHI_PROBE_ARG(2) " " ASMICHI_PROBE_ARG(3)) \
+                         : \
+                         : ASMICHI_PROBE_OPERAND(a0), ASMICHI_PROBE_OPERAND(a1), ASMICHI_PROBE_OPERAND(a2), ASMICHI_PROBE_OPERAND(a3))
+
+#else
+
+#define ASMICHI_PROBE2(name, a0, a1) \
+    do \
+    { \
+    } while (0)
+#define ASMICHI_PROBE3(name, a0, a1, a2) \
+    do \
+    { \
+    } while (0)
+#define ASMICHI_PROBE4(name, a0, a1, a2, a3) \
+    do \
+    { \
+    } while (0)
+
+#endif
+
+// Probes. Latencies are in microseconds.
+
+// CreateProcess entered.
+#define PROBE_SPAWN_START(token, jobToken) ASMICHI_PROBE2(spawn__start, token, jobToken)
+// CreateProcess returned. pid: 0 on failure. err: 0 on success, otherwise errno.
+#define PROBE_SPAWN_DONE(token, pid, err, latency) ASMICHI_PROBE4(spawn__done, token, pid, err, latency)
+// fork/vfork returned in the parent. pid: -1 on failure. latency: since the request was received.
+#define PROBE_FORK_RETURN(token, pid, latency) ASMICHI_PROBE3(fork__return, token, pid, latency)
+// The child performed exec. latency: since fork returned (always 0 with vfork, which returns after exec).
+#define PROBE_EXEC_SUCCESS(token, pid, latency) ASMICHI_PROBE3(exec__success, token, pid, latency)
+// The child failed to execute the program. latency: as in exec__success.
+#define PROBE_EXEC_FAILURE(token, pid, err, latency) ASMICHI_PROBE4(exec__failure, token, pid, err, latency)
+// A child is reaped. token: 0 for an adopted orphan. status: si_status.
+#define PROBE_REAP(token, pid, status) ASMICHI_PROBE3(reap, token, pid, status)
+// An exit notification is queued to the client. status: as notified.
+#define PROBE_NOTIFY(token, pid, status, pendingBytes) ASMICHI_PROBE4(notify, token, pid, status, pendingBytes)
@@ -2,6 +2,9 @@
 
 #pragma once
 
+#include "JobState.hpp"
+#include "OutputMultiplexer.hpp"
+#include "OutputTee.hpp"
 #include "UniqueResource.hpp"
 #include <cstddef>
 #include <cstdint>
@@ -11,19 +14,43 @@
 // Limitations to prevent OOM errors.
 const std::uint32_t MaxMessageLength = 2 * 1024 * 1024;
 const std::uint32_t MaxStringArrayCount = 64 * 1024;
+// Bounded so that all fds of a request can be attached to the 8-byte request header (SocketMaxFdsPerCall fds per byte).
+const std::uint32_t MaxFdMapCount = 64;
+const std::uint32_t MaxSignalBulkTokenCount = 64 * 1024;
+
+// The client sends a request (and its fds) with one sendmsg call only if the whole request fits in this length;
+// the helper always has this much room for the first recvmsg call of a request, so that fds are received exactly once.
+// (On WSL 1, fds are delivered again to every recvmsg call that partially receives the data sent with them.)
+// NOTE: Make sure to sync with Protocol.md.
+const std::size_t SingleMessageRequestLength = 16 * 1024;
 
 // NOTE: Make sure to sync with the client.
 enum class RequestCommand : std::uint32_t
 {
     SpawnProcess = 0,
     SendSignal = 1,
+    SendSignalBulk = 2,
+    CreateJob = 3,
+    SendSignalToJob = 4,
+    GetJobStatistics = 5,
+    CloseJob = 6,
+    GetStatistics = 7,
+    DumpTrace = 8,
+    CreateOutputMultiplexer = 9,
+    CloseOutputMultiplexer = 10,
 };
 
+// NOTE: Values are the signal numbers on Linux x86_64 regardless of the platform. Make sure to sync with the client.
 enum class AbstractSignal : std::uint32_t
 {
+    Hangup = 1,
     Interrupt = 2,
     Kill = 9,
+    User1 = 10,
+    User2 = 12,
     Termination = 15,
+    Continue = 18,
+    Stop = 19,
 };
 
 enum SpawnProcessRequestFlags
@@ -33,11 +60,30 @@ enum SpawnProcessRequestFlags
     RequestFlagsRedirectStderr = 1 << 2,
     RequestFlagsCreateNewProcessGroup = 1 << 3,
     RequestFlagsEnableAutoTermination = 1 << 4,
+    RequestFlagsRestrictFdInheritance = 1 << 5,
+    RequestFlagsReportTimings = 1 << 6,
+    // Mutually exclusive with RequestFlagsRedirectStdout/RequestFlagsRedirectStderr respectively.
+    RequestFlagsCaptureStdout = 1 << 7,
+    RequestFlagsCaptureStderr = 1 << 8,
+    // Mutually exclusive with RequestFlagsRedirectStdout/RequestFlagsCaptureStdout (RequestFlagsRedirectStderr/RequestFlagsCaptureStderr) respectively.
+    RequestFlagsTeeStdout = 1 << 9,
+    RequestFlagsTeeStderr = 1 << 10,
 };
 
+enum CreateJobRequestFlags
+{
+    JobFlagsKillOnClose = 1 << 0,
+};
+
+struct FdMapEntry final
+{
+    UniqueFd SourceFd;
+    int TargetFd;
+};
+
+// NOTE: Strings and string arrays point into the request body passed to DeserializeSpawnProcessRequest.
 struct SpawnProcessRequest final
 {
-    std::unique_ptr<const std::byte[]> Data;
     std::uint64_t Token;
     std::uint32_t Flags;
     const char* WorkingDirectory;
@@ -47,6 +93,28 @@ struct SpawnProcessRequest final
     UniqueFd StdinFd;
     UniqueFd StdoutFd;
     UniqueFd StderrFd;
+    std::vector<FdMapEntry> FdMap;
+    // 0 if none.
+    std::uint64_t JobToken;
+    // Resolved from JobToken by the subchannel.
+    std::shared_ptr<JobState> Job;
+    // 0 if none. Required by RequestFlagsCaptureStdout/RequestFlagsCaptureStderr.
+    std::uint64_t OutputMultiplexerToken;
+    // Attached to the captured output.
+    std::uint64_t OutputTag;
+    // Resolved from OutputMultiplexerToken by the subchannel.
+    std::shared_ptr<OutputMultiplexer> Multiplexer;
+    // The read ends of the pipes created for RequestFlagsCaptureStdout/RequestFlagsCaptureStderr.
+    UniqueFd CapturedStdoutFd;
+    UniqueFd CapturedStderrFd;
+    // The sinks for RequestFlagsTeeStdout/RequestFlagsTeeStderr.
+    std::vector<TeeSink> StdoutTeeSinks;
+    std::vector<TeeSink> StderrTeeSinks;
+    // The buffer capacity of the pipes created by the helper (for capture and tee). 0 for the default.
+    std::uint32_t PipeBufferSize;
+    // The read ends of the pipes created for RequestFlagsTeeStdout/RequestFlagsTeeStderr.
+    UniqueFd TeedStdoutFd;
+    UniqueFd TeedStderrFd;
 };
 
 struct SendSignalRequest final
@@ -55,6 +123,51 @@ struct SendSignalRequest final
     AbstractSignal Signal;
 };
 
-// NOTE: DeserializeSpawnProcessRequest does not set fds.
-void DeserializeSpawnProcessRequest(SpawnProcessRequest* r, std::unique_ptr<const std::byte[]> data, std::size_t length);
-void DeserializeSendSignalRequest(SendSignalRequest* r, std::unique_ptr<const std::byte[]> data, std::size_t length);
+struct SendSignalBulkRequest final
+{
+    AbstractSignal Signal;
+    std::vector<std::uint64_t> Tokens;
+};
+
+struct CreateJobRequest final
+{
+    std::uint64_t Token;
+    std::uint32_t Flags;
+};
+
+struct SendSignalToJobRequest final
+{
+    std::uint64_t Token;
+    AbstractSignal Signal;
+};
+
+// For GetJobStatistics and CloseJob.
+struct JobRequest final
+{
+    std::uint64_t Token;
+};
+
+// For CreateOutputMultiplexer and CloseOutputMultiplexer.
+struct OutputMultiplexerRequest final
+{
+    std::uint64_t Token;
+};
+
+// NOTE: Make sure to sync with the client.
+struct SendSignalBulkFailure final
+{
+    std::uint32_t Index;
+    std::int32_t Error;
+};
+
+// NOTE: DeserializeSpawnProcessRequest does not set fds (but sets FdMap[i].TargetFd and the backpressure policies of the tee sinks).
+//       The caller must keep data alive while using r.
+void DeserializeSpawnProcessRequest(SpawnProcessRequest* r, const std::byte* data, std::size_t length);
+void DeserializeSendSignalRequest(SendSignalRequest* r, const std::byte* data, std::size_t length);
+void DeserializeSendSignalBulkRequest(SendSignalBulkRequest* r, const std::byte* data, std::size_t length);
+void DeserializeCreateJobRequest(CreateJobRequest* r, const std::byte* data, std::size_t length);
+void DeserializeSendSignalToJobRequest(SendSignalToJobRequest* r, const std::byte* data, std::size_t length);
+void DeserializeJobRequest(JobRequest* r, const std::byte* data, std::size_t length);
+void DeserializeOutputMultiplexerRequest(OutputMultiplexerRequest* r, const std::byte* data, std::size_t length);
+// Closes all fds and clears all arrays while keeping their capacity so that r can be reused for the next request.
+void ResetSpawnProcessRequest(SpawnProcessRequest* r) noexcept;
@@ -19,6 +19,8 @@ enum class NotificationToService : std::uint8_t
     ReapRequest,
     // A subchannel is closed, indicating that we may be able to exit.
     SubchannelClosed,
+    // SIGUSR1: Dump the event trace to a file.
+    DumpTrace,
 };
 
 class Service final
@@ -26,12 +28,16 @@ class Service final
 public:
     // Interface for main.
     // Delayed initialization.
-    void Initialize(UniqueFd mainChannelFd);
+    // enableSubreaper: Adopt orphaned descendants (PR_SET_CHILD_SUBREAPER), reap them and terminate them on shutdown.
+    void Initialize(UniqueFd mainChannelFd, bool enableSubreaper);
     [[nodiscard]] int Run();
 
     // Interface for subchannels.
     void NotifyChildRegistration();
     void NotifySubchannelClosed(Subchannel* pSubchannel);
+    [[nodiscard]] std::size_t GetSubchannelCount() const { return subchannelCollection_.Size(); }
+    // The number of notifications not yet processed by the service thread.
+    [[nodiscard]] std::size_t GetNotificationQueueDepth() const noexcept;
 
     // Interface for the signal handler.
     void NotifySignal(int signum);
@@ -42,11 +48,15 @@ private:
     bool ShouldExit();
     void HandleNotificationPipeInput();
     void ReapAllExitedChildren();
+    void TerminateAdoptedOrphans();
+    void WriteTraceFile();
     void HandleMainChannelInput();
     void HandleMainChannelOutput();
     void NotifyClientOfExitedChild(ChildProcessState* pState, siginfo_t siginfo);
 
     bool shuttingDown_ = false;
+    bool isSubreaper_ = false;
+    int traceFileCount_ = 0;
 
     // Write to wake up the service thread.
     int notificationPipeReadEnd_ = 0;
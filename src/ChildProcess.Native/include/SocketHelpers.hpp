@@ -7,9 +7,11 @@
 #include "Base.hpp"
 #include <cstddef>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/types.h>
 
-constexpr const int SocketMaxFdsPerCall = 3;
+// Maximum number of fds attached to one sendmsg call. SendExactBytesWithFd splits more fds into multiple calls.
+constexpr const int SocketMaxFdsPerCall = 16;
 
 struct CmsgFds
 {
@@ -19,7 +21,10 @@ struct CmsgFds
 
 [[nodiscard]] bool SendExactBytes(int fd, const void* buf, std::size_t len) noexcept;
 [[nodiscard]] bool SendExactBytesWithFd(int fd, const void* buf, std::size_t len, const int* fds, std::size_t fdCount) noexcept;
+// Sends all data in iov (gathering) along with fds. Modifies iov to track progress.
+[[nodiscard]] bool SendExactIovecsWithFd(int fd, iovec* iov, std::size_t iovCount, const int* fds, std::size_t fdCount) noexcept;
 [[nodiscard]] ssize_t SendWithFd(int fd, const void* buf, std::size_t len, const int* fds, std::size_t fdCount, BlockingFlag blocking) noexcept;
+[[nodiscard]] ssize_t SendIovecsWithFd(int fd, const iovec* iov, std::size_t iovCount, const int* fds, std::size_t fdCount, BlockingFlag blocking) noexcept;
 [[nodiscard]] bool RecvExactBytes(int fd, void* buf, std::size_t len) noexcept;
 
 [[nodiscard]] constexpr int MakeSockFlags(BlockingFlag blocking) noexcept
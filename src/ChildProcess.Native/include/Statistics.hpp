@@ -0,0 +1,44 @@
+// Copyright (c) @asmichi (https://github.com/asmichi). Licensed under the MIT License. See LICENCE in the project root for details.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Counters and gauges reported by the GetStatistics command.
+// Updated with relaxed atomics on hot paths; a snapshot is not necessarily consistent across fields.
+class Statistics final
+{
+public:
+    // Bucket i (> 0) counts latencies in [2^i, 2^(i+1)) us. Bucket 0 counts [0, 2) us. The last bucket is unbounded.
+    static constexpr int SpawnLatencyBucketCount = 24;
+    // Bucket i counts batches of [2^i, 2^(i+1)) children. The last bucket is unbounded.
+    static constexpr int ReapBatchBucketCount = 8;
+    // Failures with errno beyond this are counted as errno 0.
+    static constexpr int MaxTrackedErrno = 256;
+
+    // err: 0 on success, otherwise errno.
+    void RecordSpawn(int err, std::uint64_t latencyMicroseconds) noexcept;
+    void RecordReapBatch(std::uint32_t reapedCount, std::uint32_t orphanCount) noexcept;
+    void RecordNotificationBatch(std::size_t count) noexcept;
+    void SetPendingMainChannelBytes(std::size_t bytes) noexcept;
+
+    // Appends the counters in the wire format to buf. (The gauges owned by others are passed in.)
+    // NOTE: Make sure to sync with the client. See Protocol.md.
+    void Serialize(std::vector<std::byte>* buf, std::uint64_t liveChildCount, std::uint64_t subchannelCount, std::uint64_t notificationQueueDepth) const;
+
+private:
+    static void UpdateMax(std::atomic<std::uint64_t>& target, std::uint64_t value) noexcept;
+
+    std::atomic<std::uint64_t> spawnCount_{0};
+    std::atomic<std::uint64_t> spawnFailureCount_{0};
+    std::atomic<std::uint64_t> spawnFailuresByErrno_[MaxTrackedErrno]{};
+    std::atomic<std::uint64_t> spawnLatencyHistogram_[SpawnLatencyBucketCount]{};
+    std::atomic<std::uint64_t> pendingMainChannelBytes_{0};
+    std::atomic<std::uint64_t> maxNotificationBatchSize_{0};
+    std::atomic<std::uint64_t> reapCount_{0};
+    std::atomic<std::uint64_t> orphanReapCount_{0};
+    std::atomic<std::uint64_t> reapBatchHistogram_[ReapBatchBucketCount]{};
+};
@@ -3,22 +3,40 @@
 #pragma once
 
 #include "AncillaryDataSocket.hpp"
+#include "ChildProcessState.hpp"
 #include "Request.hpp"
 #include "UniqueResource.hpp"
+#include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <optional>
 #include <tuple>
+#include <vector>
 
 // Random big value to prevent exhausting memory (by storing a request in memory).
 const std::uint32_t MaxRequestLength = 2 * 1024 * 1024;
 
+// NOTE: Body points into the request buffer of the subchannel and is valid until the next RecvRawRequest.
 struct RawRequest final
 {
     RequestCommand Command;
     uint32_t BodyLength;
-    std::unique_ptr<std::byte[]> Body;
+    const std::byte* Body;
 };
 
+// CLOCK_MONOTONIC in nanoseconds. Reported to the client when RequestFlagsReportTimings is specified.
+// NOTE: Make sure to sync with the client.
+struct SpawnTimings final
+{
+    std::uint64_t RequestReceived;
+    std::uint64_t ForkReturned;
+    // The child is allowed to perform exec. Same as ForkReturned with vfork.
+    std::uint64_t ChildReleased;
+    // The child has performed exec (or failed). Same as ForkReturned with vfork.
+    std::uint64_t ExecConfirmed;
+};
+static_assert(sizeof(SpawnTimings) == 32);
+
 class Subchannel final
 {
 public:
@@ -30,18 +48,41 @@ private:
     static void* CommunicationThreadFunc(void* arg);
     void CommunicationLoop();
 
-    void HandleProcessCreationCommand(std::unique_ptr<std::byte[]> body, std::uint32_t bodyLength);
-    void ToProcessCreationRequest(SpawnProcessRequest* r, std::unique_ptr<std::byte[]> body, std::uint32_t bodyLength);
+    void HandleProcessCreationCommand(const std::byte* body, std::uint32_t bodyLength);
+    void ToProcessCreationRequest(SpawnProcessRequest* r, const std::byte* body, std::uint32_t bodyLength);
     // return: {err, pid}
-    std::pair<int, int> CreateProcess(const SpawnProcessRequest& r);
+    std::pair<int, int> CreateProcess(const SpawnProcessRequest& r, SpawnTimings* pTimings);
 
-    void HandleSendSignalCommand(std::unique_ptr<std::byte[]> body, std::uint32_t bodyLength);
+    void HandleSendSignalCommand(const std::byte* body, std::uint32_t bodyLength);
+    void HandleSendSignalBulkCommand(const std::byte* body, std::uint32_t bodyLength);
+    void HandleCreateJobCommand(const std::byte* body, std::uint32_t bodyLength);
+    void HandleSendSignalToJobCommand(const std::byte* body, std::uint32_t bodyLength);
+    void HandleGetJobStatisticsCommand(const std::byte* body, std::uint32_t bodyLength);
+    void HandleCloseJobCommand(const std::byte* body, std::uint32_t bodyLength);
+    void HandleGetStatisticsCommand(std::uint32_t bodyLength);
+    void HandleDumpTraceCommand(std::uint32_t bodyLength);
+    void HandleCreateOutputMultiplexerCommand(const std::byte* body, std::uint32_t bodyLength);
+    void HandleCloseOutputMultiplexerCommand(const std::byte* body, std::uint32_t bodyLength);
     std::optional<int> ToNativeSignal(AbstractSignal abstractSignal) noexcept;
 
     void RecvRawRequest(RawRequest* r);
+    std::size_t RecvIntoRequestBuffer(std::size_t len, BlockingFlag blocking);
+    void EnsureRequestBuffer(std::size_t length);
     void SendSuccess(std::int32_t data);
     void SendError(int err);
     void SendResponse(int err, std::int32_t data);
 
     AncillaryDataSocket sock_;
+
+    // Reused across requests so that the steady state performs no heap allocation.
+    // The request buffer only grows (to the largest request seen so far).
+    // [0, requestConsumedLength_): the current request; [requestConsumedLength_, requestBufferedLength_): received bytes following it.
+    std::unique_ptr<std::byte[]> requestBuffer_;
+    std::size_t requestBufferLength_ = 0;
+    std::size_t requestBufferedLength_ = 0;
+    std::size_t requestConsumedLength_ = 0;
+    SpawnProcessRequest spawnProcessRequest_;
+    SendSignalBulkRequest sendSignalBulkRequest_;
+    std::vector<std::shared_ptr<ChildProcessState>> signalBulkTargets_;
+    std::vector<SendSignalBulkFailure> signalBulkFailures_;
 };
@@ -14,6 +14,7 @@ public:
     void Enqueue(const void* buf, std::size_t len);
     void Dequeue(std::size_t len) noexcept;
     bool HasPendingData() noexcept { return !blocks_.empty(); }
+    std::size_t GetPendingBytes() const noexcept { return pendingBytes_; }
     std::tuple<std::byte*, std::size_t> GetPendingData() noexcept;
 
 private:
@@ -28,4 +29,5 @@ private:
     std::size_t StoreToBlock(Block* pBlock, const std::byte* pSrc, std::size_t len) noexcept;
 
     std::vector<Block> blocks_;
+    std::size_t pendingBytes_ = 0;
 };
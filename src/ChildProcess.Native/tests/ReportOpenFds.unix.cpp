@@ -0,0 +1,24 @@
+// Copyright (c) @asmichi (https://github.com/asmichi). Licensed under the MIT License. See LICENCE in the project root for details.
+
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Writes the numbers of open fds greater than 2 to stdout, separated by spaces.
+int TestCommandReportOpenFds(int, const char* const*)
+{
+    const int maxFd = static_cast<int>(sysconf(_SC_OPEN_MAX));
+    const char* separator = "";
+    for (int fd = STDERR_FILENO + 1; fd < maxFd && fd < 64 * 1024; fd++)
+    {
+        if (fcntl(fd, F_GETFD) != -1)
+        {
+            std::fprintf(stdout, "%s%d", separator, fd);
+            separator = " ";
+        }
+    }
+
+    std::fflush(stdout);
+
+    return 0;
+}
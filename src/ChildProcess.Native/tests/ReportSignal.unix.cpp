@@ -23,6 +23,22 @@ namespace
             bytes = write(STDOUT_FILENO, "T", 1);
             break;
 
+        case SIGHUP:
+            bytes = write(STDOUT_FILENO, "H", 1);
+            break;
+
+        case SIGUSR1:
+            bytes = write(STDOUT_FILENO, "1", 1);
+            break;
+
+        case SIGUSR2:
+            bytes = write(STDOUT_FILENO, "2", 1);
+            break;
+
+        case SIGCONT:
+            bytes = write(STDOUT_FILENO, "C", 1);
+            break;
+
         default:
             break;
         }
@@ -33,6 +49,10 @@ int TestCommandReportSignal(int, const char* const*)
 {
     SetSignalHandler(SIGINT, SA_RESTART, SignalHandler);
     SetSignalHandler(SIGTERM, SA_RESTART, SignalHandler);
+    SetSignalHandler(SIGHUP, SA_RESTART, SignalHandler);
+    SetSignalHandler(SIGUSR1, SA_RESTART, SignalHandler);
+    SetSignalHandler(SIGUSR2, SA_RESTART, SignalHandler);
+    SetSignalHandler(SIGCONT, SA_RESTART, SignalHandler);
 
     // Tell the parent we are ready.
     std::fprintf(stdout, "R");
@@ -0,0 +1,45 @@
+// Copyright (c) @asmichi (https://github.com/asmichi). Licensed under the MIT License. See LICENCE in the project root for details.
+
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Writes the buffer capacity of stdout to stdout: F_GETPIPE_SZ for a pipe, SO_SNDBUF for a socket, -1 if unknown.
+int TestCommandReportStdoutBufferSize(int, const char* const*)
+{
+    struct stat st;
+    if (fstat(STDOUT_FILENO, &st) == -1)
+    {
+        perror("fstat");
+        return 1;
+    }
+
+    int size = -1;
+    if (S_ISSOCK(st.st_mode))
+    {
+        socklen_t len = sizeof(size);
+        if (getsockopt(STDOUT_FILENO, SOL_SOCKET, SO_SNDBUF, &size, &len) == -1)
+        {
+            perror("getsockopt");
+            return 1;
+        }
+    }
+#if defined(F_GETPIPE_SZ)
+    else if (S_ISFIFO(st.st_mode))
+    {
+        size = fcntl(STDOUT_FILENO, F_GETPIPE_SZ);
+        if (size == -1)
+        {
+            perror("fcntl");
+            return 1;
+        }
+    }
+#endif
+
+    std::fprintf(stdout, "%d", size);
+    std::fflush(stdout);
+
+    return 0;
+}
@@ -13,6 +13,10 @@ extern int TestCommandReportSignal(int argc, const char* const* argv);
 extern int TestCommandDumpEnvironmentVariables(int argc, const char* const* argv);
 #if defined(_WIN32)
 #else
+extern int TestCommandReportOpenFds(int argc, const char* const* argv);
+extern int TestCommandReportStdoutBufferSize(int argc, const char* const* argv);
+extern int TestCommandWriteToFd(int argc, const char* const* argv);
+extern int TestCommandWriteZeros(int argc, const char* const* argv);
 #endif
 
 namespace
@@ -28,6 +32,10 @@ namespace
         {"DumpEnvironmentVariables", TestCommandDumpEnvironmentVariables},
 #if defined(_WIN32)
 #else
+        {"ReportOpenFds", TestCommandReportOpenFds},
+        {"ReportStdoutBufferSize", TestCommandReportStdoutBufferSize},
+        {"WriteToFd", TestCommandWriteToFd},
+        {"WriteZeros", TestCommandWriteZeros},
 #endif
     };
 } // namespace
@@ -0,0 +1,27 @@
+// Copyright (c) @asmichi (https://github.com/asmichi). Licensed under the MIT License. See LICENCE in the project root for details.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+// WriteToFd fd text: Writes text to the specified fd.
+int TestCommandWriteToFd(int argc, const char* const* argv)
+{
+    if (argc < 4)
+    {
+        std::fprintf(stderr, "Usage: TestChildNative WriteToFd fd text\n");
+        return 1;
+    }
+
+    const int fd = std::atoi(argv[2]);
+    const char* const text = argv[3];
+    const std::size_t len = std::strlen(text);
+    if (write(fd, text, len) != static_cast<ssize_t>(len))
+    {
+        perror("write");
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,43 @@
+// Copyright (c) @asmichi (https://github.com/asmichi). Licensed under the MIT License. See LICENCE in the project root for details.
+
+#include <cstdio>
+#include <cstdlib>
+#include <sys/resource.h>
+#include <unistd.h>
+
+// WriteZeros bytes: Writes the specified number of zero bytes to stdout in 64 KiB writes,
+// then writes the voluntary and involuntary context switches of this process to stderr.
+int TestCommandWriteZeros(int argc, const char* const* argv)
+{
+    if (argc < 3)
+    {
+        std::fprintf(stderr, "Usage: TestChildNative WriteZeros bytes\n");
+        return 1;
+    }
+
+    static char buf[64 * 1024];
+    long long remaining = std::atoll(argv[2]);
+    while (remaining > 0)
+    {
+        const ssize_t bytes = write(STDOUT_FILENO, buf, remaining < static_cast<long long>(sizeof(buf)) ? static_cast<std::size_t>(remaining) : sizeof(buf));
+        if (bytes == -1)
+        {
+            perror("write");
+            return 1;
+        }
+
+        remaining -= bytes;
+    }
+
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == -1)
+    {
+        perror("getrusage");
+        return 1;
+    }
+
+    std::fprintf(stderr, "%ld %ld", static_cast<long>(usage.ru_nvcsw), static_cast<long>(usage.ru_nivcsw));
+    std::fflush(stderr);
+
+    return 0;
+}
@@ -59,6 +59,21 @@ namespace Asmichi.ProcessManagement
             Assert.Equal(expected, sut.EnvironmentVariables);
         }
 
+        [Fact]
+        public void CanDeriveContext()
+        {
+            var context = new ChildProcessCreationContext(new KV[] { new("A", "A"), new("B", "B"), new("C", "C") });
+
+            var sut = context.WithEnvironmentVariables(new KV[] { new("D", "D"), new("B", null!), new("A", "a"), new("C", "") });
+            Assert.Equal(new KV[] { new("A", "a"), new("D", "D") }, sut.EnvironmentVariables);
+
+            // The original context is not modified.
+            Assert.Equal(new KV[] { new("A", "A"), new("B", "B"), new("C", "C") }, context.EnvironmentVariables);
+
+            Assert.Same(context, context.WithEnvironmentVariables(Array.Empty<KV>()));
+            Assert.Throws<ArgumentException>(() => context.WithEnvironmentVariables(new KV[] { new("A=", "A") }));
+        }
+
         [Fact]
         public void AcceptsEmptyValue()
         {
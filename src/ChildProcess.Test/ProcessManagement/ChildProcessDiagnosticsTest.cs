@@ -0,0 +1,72 @@
+// Copyright (c) @asmichi (https://github.com/asmichi). Licensed under the MIT License. See LICENCE in the project root for details.
+
+using System;
+using System.IO;
+using System.Linq;
+using System.Runtime.InteropServices;
+using System.Text;
+using Asmichi.Utilities;
+using Xunit;
+
+namespace Asmichi.ProcessManagement
+{
+    public sealed class ChildProcessDiagnosticsTest
+    {
+        [Fact]
+        public void CanGetHelperStatistics()
+        {
+            if (RuntimeInformation.IsOSPlatform(OSPlatform.Windows))
+            {
+                Assert.Throws<PlatformNotSupportedException>(() => ChildProcessDiagnostics.GetHelperStatistics());
+                return;
+            }
+
+            var before = ChildProcessDiagnostics.GetHelperStatistics();
+
+            using (var sut = ChildProcess.Start(new ChildProcessStartInfo(TestUtil.TestChildNativePath, "ReportSignal")
+            {
+                StdInputRedirection = InputRedirection.InputPipe,
+                StdOutputRedirection = OutputRedirection.OutputPipe,
+            }))
+            {
+                Assert.Equal('R', sut.StandardOutput.ReadByte());
+                Assert.True(ChildProcessDiagnostics.GetHelperStatistics().LiveChildCount >= 1);
+
+                sut.Kill();
+                sut.WaitForExit();
+            }
+
+            var after = ChildProcessDiagnostics.GetHelperStatistics();
+            Assert.True(after.SpawnCount >= before.SpawnCount + 1);
+            Assert.True(after.ReapCount >= before.ReapCount + 1);
+            Assert.True(after.SubchannelCount >= 1);
+            Assert.True(after.SpawnLatencyHistogram.Sum() >= after.SpawnCount + after.SpawnFailureCount);
+            Assert.True(after.ReapBatchSizeHistogram.Sum() >= 1);
+            Assert.Equal(after.SpawnFailureCount, after.SpawnFailuresByErrorCode.Values.Sum());
+        }
+
+        [Fact]
+        public void CanWriteHelperTrace()
+        {
+            if (RuntimeInformation.IsOSPlatform(OSPlatform.Windows))
+            {
+                Assert.Throws<PlatformNotSupportedException>(() => ChildProcessDiagnostics.WriteHelperTrace(Stream.Null));
+                return;
+            }
+
+            using (var sut = ChildProcess.Start(new ChildProcessStartInfo(TestUtil.DotnetCommandName, TestUtil.TestChildPath, "ExitCode", "0")))
+            {
+                sut.WaitForExit();
+            }
+
+            using var stream = new MemoryStream();
+            ChildProcessDiagnostics.WriteHelperTrace(stream);
+
+            var json = Encoding.UTF8.GetString(stream.ToArray());
+            Assert.StartsWith("{", json, StringComparison.Ordinal);
+            Assert.Contains("\"traceEvents\"", json, StringComparison.Ordinal);
+            Assert.Contains("\"name\":\"spawn\"", json, StringComparison.Ordinal);
+            Assert.Contains("\"name\":\"reap\"", json, StringComparison.Ordinal);
+        }
+    }
+}
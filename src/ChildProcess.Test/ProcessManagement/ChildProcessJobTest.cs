@@ -0,0 +1,143 @@
+// Copyright (c) @asmichi (https://github.com/asmichi). Licensed under the MIT License. See LICENCE in the project root for details.
+
+using System;
+using System.ComponentModel;
+using System.Runtime.InteropServices;
+using Asmichi.Utilities;
+using Xunit;
+
+namespace Asmichi.ProcessManagement
+{
+    public sealed class ChildProcessJobTest
+    {
+        [Fact]
+        public void CanSignalJob()
+        {
+            if (RuntimeInformation.IsOSPlatform(OSPlatform.Windows))
+            {
+                Assert.Throws<PlatformNotSupportedException>(() => new ChildProcessJob());
+                return;
+            }
+
+            using var job = new ChildProcessJob();
+            var si = new ChildProcessStartInfo(TestUtil.TestChildNativePath, "ReportSignal")
+            {
+                StdInputRedirection = InputRedirection.InputPipe,
+                StdOutputRedirection = OutputRedirection.OutputPipe,
+                Job = job,
+            };
+
+            using var sut0 = ChildProcess.Start(si);
+            using var sut1 = ChildProcess.Start(si);
+
+            Assert.Equal('R', sut0.StandardOutput.ReadByte());
+            Assert.Equal('R', sut1.StandardOutput.ReadByte());
+
+            job.SendSignal(ChildProcessSignal.Interrupt);
+            Assert.Equal('I', sut0.StandardOutput.ReadByte());
+            Assert.Equal('I', sut1.StandardOutput.ReadByte());
+
+            job.Freeze();
+            job.Thaw();
+            Assert.Equal('C', sut0.StandardOutput.ReadByte());
+            Assert.Equal('C', sut1.StandardOutput.ReadByte());
+
+            job.SendSignal(ChildProcessSignal.Kill);
+            sut0.WaitForExit();
+            sut1.WaitForExit();
+            Assert.NotEqual(0, sut0.ExitCode);
+            Assert.NotEqual(0, sut1.ExitCode);
+
+            var statistics = job.GetStatistics();
+            Assert.Equal(0, statistics.ActiveProcessCount);
+            Assert.Equal(2, statistics.TotalProcessCount);
+
+            // Succeeds for a job without live members.
+            job.SendSignal(ChildProcessSignal.Kill);
+        }
+
+        [Fact]
+        public void KillsMembersOnClose()
+        {
+            if (RuntimeInformation.IsOSPlatform(OSPlatform.Windows))
+            {
+                return;
+            }
+
+            var job = new ChildProcessJob(ChildProcessJobFlags.KillOnClose);
+            var si = new ChildProcessStartInfo(TestUtil.TestChildNativePath, "ReportSignal")
+            {
+                StdInputRedirection = InputRedirection.InputPipe,
+                StdOutputRedirection = OutputRedirection.OutputPipe,
+                Job = job,
+            };
+
+            using var sut = ChildProcess.Start(si);
+            Assert.Equal('R', sut.StandardOutput.ReadByte());
+
+            job.Dispose();
+            sut.WaitForExit();
+            Assert.NotEqual(0, sut.ExitCode);
+
+            Assert.Throws<ObjectDisposedException>(() => job.SendSignal(ChildProcessSignal.Kill));
+            Assert.Throws<ObjectDisposedException>(() => ChildProcess.Start(si));
+        }
+
+        [Fact]
+        public void FailedStartWithClosedJobDoesNotAffectLaterStarts()
+        {
+            if (RuntimeInformation.IsOSPlatform(OSPlatform.Windows))
+            {
+                return;
+            }
+
+            // Simulate Dispose racing with Start: the helper has already forgotten the job when the spawn request arrives.
+            var job = new ChildProcessJob();
+            ChildProcessHelper.Shared.CloseJob(job.Token);
+
+            var siWithJob = new ChildProcessStartInfo(TestUtil.TestChildNativePath, "ReportSignal")
+            {
+                StdInputRedirection = InputRedirection.InputPipe,
+                StdOutputRedirection = OutputRedirection.OutputPipe,
+                Job = job,
+            };
+            var si = new ChildProcessStartInfo(TestUtil.TestChildNativePath, "ReportSignal")
+            {
+                StdInputRedirection = InputRedirection.InputPipe,
+                StdOutputRedirection = OutputRedirection.OutputPipe,
+            };
+
+            for (int i = 0; i < 4; i++)
+            {
+                Assert.Throws<Win32Exception>(() => ChildProcess.Start(siWithJob));
+
+                // Must not receive the fds of the failed request.
+                using var sut = ChildProcess.Start(si);
+                Assert.Equal('R', sut.StandardOutput.ReadByte());
+                sut.StandardInput.Close();
+                sut.WaitForExit();
+                Assert.Equal(0, sut.ExitCode);
+            }
+
+            Assert.Throws<Win32Exception>(() => job.Dispose());
+        }
+
+        [Fact]
+        public void RejectsAttachToCurrentConsole()
+        {
+            if (RuntimeInformation.IsOSPlatform(OSPlatform.Windows))
+            {
+                return;
+            }
+
+            using var job = new ChildProcessJob();
+            var si = new ChildProcessStartInfo(TestUtil.TestChildNativePath, "ReportSignal")
+            {
+                Flags = ChildProcessFlags.AttachToCurrentConsole,
+                Job = job,
+            };
+
+            Assert.Throws<ArgumentException>(() => ChildProcess.Start(si));
+        }
+    }
+}
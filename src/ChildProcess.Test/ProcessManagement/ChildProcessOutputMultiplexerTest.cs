@@ -0,0 +1,220 @@
+// Copyright (c) @asmichi (https://github.com/asmichi). Licensed under the MIT License. See LICENCE in the project root for details.
+
+using System;
+using System.Collections.Generic;
+using System.ComponentModel;
+using System.IO;
+using System.Runtime.InteropServices;
+using System.Text;
+using System.Threading.Tasks;
+using Asmichi.Utilities;
+using Xunit;
+
+namespace Asmichi.ProcessManagement
+{
+    public sealed class ChildProcessOutputMultiplexerTest
+    {
+        [Fact]
+        public async Task CapturesOutputOfMultipleChildren()
+        {
+            if (RuntimeInformation.IsOSPlatform(OSPlatform.Windows))
+            {
+                Assert.Throws<PlatformNotSupportedException>(() => new ChildProcessOutputMultiplexer());
+                return;
+            }
+
+            const int ChildCount = 4;
+
+            using var sut = new ChildProcessOutputMultiplexer();
+            var collector = new ChunkCollector();
+            var readTask = sut.ReadChunksAsync(collector.Handle);
+
+            var children = new List<ChildProcess>();
+            try
+            {
+                for (int i = 0; i < ChildCount; i++)
+                {
+                    var si = new ChildProcessStartInfo(TestUtil.DotnetCommandName, TestUtil.TestChildPath, "EchoOutAndError")
+                    {
+                        StdOutputRedirection = OutputRedirection.Multiplexer,
+                        StdErrorRedirection = OutputRedirection.Multiplexer,
+                        OutputMultiplexer = sut,
+                        OutputTag = 100 + i,
+                    };
+                    children.Add(ChildProcess.Start(si));
+                }
+
+                foreach (var child in children)
+                {
+                    child.WaitForExit();
+                    Assert.True(child.IsSuccessful);
+                }
+            }
+            finally
+            {
+                foreach (var child in children)
+                {
+                    child.Dispose();
+                }
+            }
+
+            sut.Complete();
+            await readTask;
+
+            for (int i = 0; i < ChildCount; i++)
+            {
+                Assert.Equal("TestChild.Out", collector.GetText(100 + i, ChildProcessOutputSource.StandardOutput));
+                Assert.Equal("TestChild.Error", collector.GetText(100 + i, ChildProcessOutputSource.StandardError));
+                Assert.True(collector.HasEndOfStream(100 + i, ChildProcessOutputSource.StandardOutput));
+                Assert.True(collector.HasEndOfStream(100 + i, ChildProcessOutputSource.StandardError));
+            }
+        }
+
+        [Fact]
+        public void CanWriteChunksToFile()
+        {
+            if (RuntimeInformation.IsOSPlatform(OSPlatform.Windows))
+            {
+                return;
+            }
+
+            using var tmp = new TemporaryDirectory();
+            var path = Path.Combine(tmp.Location, "chunks");
+
+            using (var sut = new ChildProcessOutputMultiplexer(path))
+            {
+                var si = new ChildProcessStartInfo(TestUtil.DotnetCommandName, TestUtil.TestChildPath, "EchoOutAndError")
+                {
+                    StdOutputRedirection = OutputRedirection.Multiplexer,
+                    StdErrorRedirection = OutputRedirection.NullDevice,
+                    OutputMultiplexer = sut,
+                    OutputTag = 42,
+                };
+
+                using var child = ChildProcess.Start(si);
+                child.WaitForExit();
+
+                Assert.Throws<InvalidOperationException>(() => { _ = sut.ReadChunksAsync(_ => { }); });
+            }
+
+            // The helper closes the file after the multiplexer has finished; wait for the EOF chunk.
+            var collector = new ChunkCollector();
+            var deadline = DateTime.UtcNow.AddSeconds(10);
+            while (!collector.HasEndOfStream(42, ChildProcessOutputSource.StandardOutput))
+            {
+                Assert.True(DateTime.UtcNow < deadline);
+                collector = new ChunkCollector();
+                using var stream = new FileStream(path, FileMode.Open, FileAccess.Read, FileShare.ReadWrite);
+                ChildProcessOutputMultiplexer.ReadChunks(stream, collector.Handle);
+            }
+
+            Assert.Equal("TestChild.Out", collector.GetText(42, ChildProcessOutputSource.StandardOutput));
+            Assert.Equal("", collector.GetText(42, ChildProcessOutputSource.StandardError));
+        }
+
+        [Fact]
+        public void FailedStartWithClosedMultiplexerDoesNotAffectLaterStarts()
+        {
+            if (RuntimeInformation.IsOSPlatform(OSPlatform.Windows))
+            {
+                return;
+            }
+
+            using var tmp = new TemporaryDirectory();
+            var sut = new ChildProcessOutputMultiplexer(Path.Combine(tmp.Location, "chunks"));
+
+            // Simulate Complete racing with Start: the helper has already forgotten the multiplexer when the spawn request arrives.
+            ChildProcessHelper.Shared.CloseOutputMultiplexer(sut.Token);
+
+            var siWithMultiplexer = new ChildProcessStartInfo(TestUtil.TestChildNativePath, "ReportSignal")
+            {
+                StdInputRedirection = InputRedirection.InputPipe,
+                StdOutputRedirection = OutputRedirection.Multiplexer,
+                OutputMultiplexer = sut,
+            };
+            var si = new ChildProcessStartInfo(TestUtil.TestChildNativePath, "ReportSignal")
+            {
+                StdInputRedirection = InputRedirection.InputPipe,
+                StdOutputRedirection = OutputRedirection.OutputPipe,
+            };
+
+            for (int i = 0; i < 4; i++)
+            {
+                Assert.Throws<Win32Exception>(() => ChildProcess.Start(siWithMultiplexer));
+
+                // Must not receive the fds of the failed request.
+                using var child = ChildProcess.Start(si);
+                Assert.Equal('R', child.StandardOutput.ReadByte());
+                child.StandardInput.Close();
+                child.WaitForExit();
+                Assert.Equal(0, child.ExitCode);
+            }
+
+            Assert.Throws<Win32Exception>(() => sut.Dispose());
+        }
+
+        [Fact]
+        public void RejectsMultiplexerRedirectionWithoutMultiplexer()
+        {
+            if (RuntimeInformation.IsOSPlatform(OSPlatform.Windows))
+            {
+                return;
+            }
+
+            var si = new ChildProcessStartInfo(TestUtil.DotnetCommandName, TestUtil.TestChildPath, "EchoOutAndError")
+            {
+                StdOutputRedirection = OutputRedirection.Multiplexer,
+            };
+
+            Assert.Throws<ArgumentException>(() => ChildProcess.Start(si));
+        }
+
+        [Fact]
+        public void RejectsMalformedChunks()
+        {
+            var header = new byte[24];
+            BitConverter.TryWriteBytes(header.AsSpan(16), 1u);
+            BitConverter.TryWriteBytes(header.AsSpan(20), 2u);
+
+            Assert.Throws<InvalidDataException>(() => ChildProcessOutputMultiplexer.ReadChunks(new MemoryStream(header), _ => { }));
+
+            // Truncated.
+            BitConverter.TryWriteBytes(header.AsSpan(20), 0u);
+            Assert.Throws<InvalidDataException>(() => ChildProcessOutputMultiplexer.ReadChunks(new MemoryStream(header), _ => { }));
+        }
+
+        private sealed class ChunkCollector
+        {
+            private readonly Dictionary<(long, ChildProcessOutputSource), MemoryStream> _data = new();
+            private readonly HashSet<(long, ChildProcessOutputSource)> _endOfStreams = new();
+            private long _lastTimestamp;
+
+            public void Handle(ChildProcessOutputChunk chunk)
+            {
+                // Chunks are delivered in the order they were read.
+                Assert.True(chunk.Timestamp >= _lastTimestamp);
+                _lastTimestamp = chunk.Timestamp;
+
+                var key = (chunk.Tag, chunk.Source);
+                if (chunk.IsEndOfStream)
+                {
+                    Assert.True(_endOfStreams.Add(key));
+                    return;
+                }
+
+                Assert.DoesNotContain(key, _endOfStreams);
+                if (!_data.TryGetValue(key, out var ms))
+                {
+                    ms = new MemoryStream();
+                    _data.Add(key, ms);
+                }
+                ms.Write(chunk.Data);
+            }
+
+            public string GetText(long tag, ChildProcessOutputSource source) =>
+                _data.TryGetValue((tag, source), out var ms) ? Encoding.UTF8.GetString(ms.ToArray()) : "";
+
+            public bool HasEndOfStream(long tag, ChildProcessOutputSource source) => _endOfStreams.Contains((tag, source));
+        }
+    }
+}
@@ -0,0 +1,81 @@
+// Copyright (c) @asmichi (https://github.com/asmichi). Licensed under the MIT License. See LICENCE in the project root for details.
+
+using System;
+using System.Collections.Generic;
+using System.Threading.Channels;
+using System.Threading.Tasks;
+using Asmichi.Utilities;
+using Xunit;
+
+namespace Asmichi.ProcessManagement
+{
+    public sealed class ChildProcessSetTest
+    {
+        [Fact]
+        public async Task DeliversProcessesInOrderOfExit()
+        {
+            var sut = new ChildProcessSet();
+
+            var si = new ChildProcessStartInfo(TestUtil.DotnetCommandName, TestUtil.TestChildPath, "EchoBack")
+            {
+                StdInputRedirection = InputRedirection.InputPipe,
+                StdOutputRedirection = OutputRedirection.NullDevice,
+            };
+
+            using var p0 = ChildProcess.Start(si);
+            using var p1 = ChildProcess.Start(si);
+            sut.Add(p0);
+            sut.Add(p1);
+            Assert.Equal(2, sut.PendingCount);
+            Assert.False(sut.Exited.TryRead(out _));
+
+            p1.StandardInput.Close();
+            Assert.Same(p1, await sut.WhenAnyExitedAsync());
+
+            p0.StandardInput.Close();
+            Assert.Same(p0, await sut.WhenAnyExitedAsync());
+            Assert.Equal(0, sut.PendingCount);
+
+            // An exited process is delivered immediately.
+            sut.Add(p0);
+            Assert.True(sut.Exited.TryRead(out var exited));
+            Assert.Same(p0, exited);
+
+            sut.Complete();
+            await Assert.ThrowsAsync<ChannelClosedException>(async () => await sut.WhenAnyExitedAsync());
+            Assert.Throws<InvalidOperationException>(() => sut.Add(p0));
+        }
+
+        [Fact]
+        public async Task WhenAllExitedAsyncWaitsForAllProcesses()
+        {
+            var sut = new ChildProcessSet();
+            var processes = new List<IChildProcess>();
+            try
+            {
+                for (int i = 0; i < 4; i++)
+                {
+                    var p = ChildProcess.Start(new ChildProcessStartInfo(TestUtil.DotnetCommandName, TestUtil.TestChildPath, "ExitCode", i.ToString(System.Globalization.CultureInfo.InvariantCulture)));
+                    processes.Add(p);
+                    sut.Add(p);
+                }
+
+                await sut.WhenAllExitedAsync();
+
+                Assert.Equal(0, sut.PendingCount);
+                Assert.True(sut.Exited.Completion.IsCompleted);
+                for (int i = 0; i < processes.Count; i++)
+                {
+                    Assert.Equal(i, processes[i].ExitCode);
+                }
+            }
+            finally
+            {
+                foreach (var p in processes)
+                {
+                    p.Dispose();
+                }
+            }
+        }
+    }
+}
@@ -17,11 +17,17 @@ namespace Asmichi.ProcessManagement
             Assert.Equal(OutputRedirection.ParentOutput, sut.StdOutputRedirection);
             Assert.Equal(OutputRedirection.ParentError, sut.StdErrorRedirection);
             Assert.Null(sut.StdInputFile);
+            Assert.True(sut.StdInputBytes.IsEmpty);
             Assert.Null(sut.StdInputHandle);
             Assert.Null(sut.StdOutputFile);
             Assert.Null(sut.StdOutputHandle);
             Assert.Null(sut.StdErrorFile);
             Assert.Null(sut.StdErrorHandle);
+            Assert.Null(sut.MemoryCaptureMaxLength);
+            Assert.Empty(sut.StdOutputTeeSinks);
+            Assert.Empty(sut.StdErrorTeeSinks);
+            Assert.Null(sut.OutputBufferMemoryBudget);
+            Assert.Null(sut.StdioBufferSize);
             Assert.Null(sut.FileName);
             Assert.Equal(Array.Empty<string>(), sut.Arguments);
             Assert.Null(sut.WorkingDirectory);
@@ -1,8 +1,10 @@
 // Copyright (c) @asmichi (https://github.com/asmichi). Licensed under the MIT License. See LICENCE in the project root for details.
 
 using System;
+using System.Collections.Generic;
 using System.ComponentModel;
 using System.IO;
+using System.Runtime.InteropServices;
 using Asmichi.Utilities;
 using Xunit;
 using static Asmichi.ProcessManagement.ChildProcessExecutionTestUtil;
@@ -44,6 +46,35 @@ namespace Asmichi.ProcessManagement
             Assert.Equal("TestChild", output);
         }
 
+        [Fact]
+        public void CanStartPreparedStartInfoRepeatedly()
+        {
+            var si = new ChildProcessStartInfo(TestUtil.DotnetCommandName, TestUtil.TestChildPath)
+            {
+                StdOutputRedirection = OutputRedirection.OutputPipe,
+                // Makes the environment variables encoded once.
+                ExtraEnvironmentVariables = new[] { new KeyValuePair<string, string>("A", "A") },
+            };
+
+            var prepared = ChildProcess.Prepare(si);
+            Assert.True(Path.IsPathRooted(prepared.ResolvedPath));
+
+            for (int i = 0; i < 3; i++)
+            {
+                using var sut = ChildProcess.Start(prepared);
+                using var sr = new StreamReader(sut.StandardOutput);
+                var output = sr.ReadToEnd();
+
+                sut.WaitForExit();
+                Assert.Equal(0, sut.ExitCode);
+                Assert.Equal("TestChild", output);
+            }
+
+            Assert.Throws<ArgumentException>(
+                () => ChildProcess.Prepare(new ChildProcessStartInfo { FileName = null, Arguments = Array.Empty<string>() }));
+            Assert.Throws<ArgumentNullException>(() => ChildProcess.Start((PreparedChildProcessStartInfo)null!));
+        }
+
         [Fact]
         public void RespectsSearchPath()
         {
@@ -138,5 +169,46 @@ namespace Asmichi.ProcessManagement
             sut.WaitForExit();
             Assert.Equal(0, sut.ExitCode);
         }
+
+        [Fact]
+        public void CanReportStartupTimings()
+        {
+            using (var sut = ChildProcess.Start(new ChildProcessStartInfo(TestUtil.TestChildNativePath, "ReportSignal")
+            {
+                StdInputRedirection = InputRedirection.NullDevice,
+                StdOutputRedirection = OutputRedirection.NullDevice,
+            }))
+            {
+                Assert.Null(sut.StartupTimings);
+                sut.Kill();
+                sut.WaitForExit();
+            }
+
+            using (var sut = ChildProcess.Start(new ChildProcessStartInfo(TestUtil.TestChildNativePath, "ReportSignal")
+            {
+                StdInputRedirection = InputRedirection.NullDevice,
+                StdOutputRedirection = OutputRedirection.NullDevice,
+                Flags = ChildProcessFlags.ReportStartupTimings,
+            }))
+            {
+                if (RuntimeInformation.IsOSPlatform(OSPlatform.Windows))
+                {
+                    Assert.Null(sut.StartupTimings);
+                }
+                else
+                {
+                    var timings = sut.StartupTimings;
+                    Assert.NotNull(timings);
+                    Assert.True(timings!.RequestReceivedTimestamp <= timings.ForkReturnedTimestamp);
+                    Assert.True(timings.ForkReturnedTimestamp <= timings.ChildReleasedTimestamp);
+                    Assert.True(timings.ChildReleasedTimestamp <= timings.ExecConfirmedTimestamp);
+                    Assert.True(timings.Fork > TimeSpan.Zero);
+                    Assert.Equal(timings.Total, timings.Queueing + timings.Fork + timings.Release + timings.Exec);
+                }
+
+                sut.Kill();
+                sut.WaitForExit();
+            }
+        }
     }
 }
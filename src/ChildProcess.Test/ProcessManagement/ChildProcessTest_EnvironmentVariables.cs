@@ -39,6 +39,20 @@ namespace Asmichi.ProcessManagement
             AssertEnvironmentVariables(expected, null, extraEnvVars, true);
         }
 
+        [Fact]
+        public void CanAddLargeEnvironmentVariables()
+        {
+            // Makes the spawn request (which carries the fd of stdout) larger than what the helper receives with one recvmsg call.
+            var extraEnvVars = new KV[]
+            {
+                new("A", new string('a', 100 * 1024)),
+            };
+
+            var expected = GetProcessEnvVars().Concat(extraEnvVars);
+
+            AssertEnvironmentVariables(expected, null, extraEnvVars, true);
+        }
+
         [Fact]
         public void CanRemoveEnvironmentVariables()
         {
@@ -59,6 +73,20 @@ namespace Asmichi.ProcessManagement
             AssertEnvironmentVariables(processEnvVars, context, extraEnvVars, true);
         }
 
+        [Fact]
+        public void CanUseDerivedContext()
+        {
+            var processEnvVars = GetProcessEnvVars().ToArray();
+            var context = new ChildProcessCreationContext(processEnvVars)
+                .WithEnvironmentVariables(new KV[] { new("A", "A"), new("BB", "BB") });
+
+            var expected = processEnvVars.Concat(new KV[] { new("A", "A"), new("BB", "BB") }).ToArray();
+
+            // The second run uses the cached encoded environment variables of the context.
+            AssertEnvironmentVariables(expected, context, Array.Empty<KV>(), true);
+            AssertEnvironmentVariables(expected, context, Array.Empty<KV>(), true);
+        }
+
         [Fact]
         public void CanDisableEnvironmentVariableInheritance()
         {
@@ -1,9 +1,15 @@
 // Copyright (c) @asmichi (https://github.com/asmichi). Licensed under the MIT License. See LICENCE in the project root for details.
 
 using System;
+using System.Diagnostics;
+using System.Globalization;
+using System.IO;
 using System.IO.Pipes;
+using System.Runtime.InteropServices;
+using System.Threading;
 using Asmichi.Utilities;
 using Xunit;
+using static System.FormattableString;
 
 namespace Asmichi.ProcessManagement
 {
@@ -61,6 +67,130 @@ namespace Asmichi.ProcessManagement
             Assert.Equal(-1, stdOutputPipe.ReadByte());
         }
 
+        [Fact]
+        public void SubreaperReapsAndTerminatesOrphans()
+        {
+            if (!RuntimeInformation.IsOSPlatform(OSPlatform.Linux))
+            {
+                return;
+            }
+
+            // A dedicated helper in the subreaper mode, as if Asmichi.ChildProcess.EnableSubreaper were set
+            // (the switch is read only once for the shared helper).
+            var helper = new UnixChildProcessStateHelper(1, enableSubreaper: true);
+            int orphanToTerminate;
+            try
+            {
+                using var tracked = StartWithHelper(helper, new ChildProcessStartInfo(TestUtil.TestChildNativePath, "ReportSignal")
+                {
+                    StdInputRedirection = InputRedirection.InputPipe,
+                    StdOutputRedirection = OutputRedirection.OutputPipe,
+                });
+                Assert.Equal('R', tracked.StandardOutput.ReadByte());
+                var helperPid = GetParentProcessId(tracked.Id);
+
+                // The helper adopts the grandchildren when their parents exit.
+                var orphanToKill = StartOrphan(helper);
+                orphanToTerminate = StartOrphan(helper);
+                Assert.Equal(helperPid, GetParentProcessId(orphanToKill));
+                Assert.Equal(helperPid, GetParentProcessId(orphanToTerminate));
+
+                // The helper reaps an adopted orphan without notifying anyone.
+                var orphanReapCount = helper.GetHelperStatistics().OrphanReapCount;
+                using (var orphan = Process.GetProcessById(orphanToKill))
+                {
+                    orphan.Kill();
+                }
+                Assert.True(WaitUntil(() => !Directory.Exists(Invariant($"/proc/{orphanToKill}"))));
+                Assert.Equal(orphanReapCount + 1, helper.GetHelperStatistics().OrphanReapCount);
+                Assert.False(tracked.WaitForExit(0));
+
+                tracked.StandardInput.Close();
+                tracked.WaitForExit();
+                Assert.Equal(0, tracked.ExitCode);
+            }
+            finally
+            {
+                helper.ShutdownAsync().GetAwaiter().GetResult();
+                helper.Dispose();
+            }
+
+            // The helper terminates the remaining orphans on shutdown (init reaps them afterwards).
+            Assert.True(WaitUntil(() => HasTerminated(orphanToTerminate)));
+        }
+
+        // Starts a child that starts a sleeping grandchild and exits. Returns the pid of the grandchild.
+        private static int StartOrphan(UnixChildProcessStateHelper helper)
+        {
+            using var sut = StartWithHelper(helper, new ChildProcessStartInfo("/bin/sh", "-c", "sleep 120 </dev/null >/dev/null 2>&1 & echo $!")
+            {
+                StdOutputRedirection = OutputRedirection.OutputPipe,
+            });
+
+            using var sr = new StreamReader(sut.StandardOutput);
+            var pid = int.Parse(sr.ReadToEnd().Trim(), CultureInfo.InvariantCulture);
+            sut.WaitForExit();
+            return pid;
+        }
+
+        // Equivalent to ChildProcess.Start, but with the specified helper.
+        private static IChildProcess StartWithHelper(UnixChildProcessStateHelper helper, ChildProcessStartInfo startInfo)
+        {
+            var startInfoInternal = new ChildProcessStartInfoInternal(startInfo);
+            using var stdHandles = new PipelineStdHandleCreator(ref startInfoInternal);
+            var processState = helper.SpawnProcess(
+                startInfo: ref startInfoInternal,
+                resolvedPath: startInfo.FileName!,
+                preparedRequest: null,
+                stdIn: stdHandles.PipelineStdIn,
+                stdOut: stdHandles.PipelineStdOut,
+                stdErr: stdHandles.PipelineStdErr,
+                stdOutTeeSinks: null,
+                stdErrTeeSinks: null);
+            var process = new ChildProcessImpl(
+                processState, stdHandles.InputStream, stdHandles.OutputStream, stdHandles.ErrorStream, stdHandles.CapturedOutput, stdHandles.CapturedError);
+            stdHandles.DetachStreams();
+            return process;
+        }
+
+        // The fields of /proc/[pid]/stat after the command name: state, ppid, ...
+        private static string[] ReadStatFields(int pid)
+        {
+            var stat = File.ReadAllText(Invariant($"/proc/{pid}/stat"));
+            return stat.Substring(stat.LastIndexOf(')') + 2).Split(' ');
+        }
+
+        private static bool HasTerminated(int pid)
+        {
+            try
+            {
+                return ReadStatFields(pid)[0] == "Z";
+            }
+            catch (IOException)
+            {
+                // Already reaped.
+                return true;
+            }
+        }
+
+        private static int GetParentProcessId(int pid) => int.Parse(ReadStatFields(pid)[1], CultureInfo.InvariantCulture);
+
+        private static bool WaitUntil(Func<bool> condition)
+        {
+            var sw = Stopwatch.StartNew();
+            while (!condition())
+            {
+                if (sw.ElapsedMilliseconds > 10000)
+                {
+                    return false;
+                }
+
+                Thread.Sleep(10);
+            }
+
+            return true;
+        }
+
         private static IChildProcess CreateProcessTree(AnonymousPipeServerStream stdOutputPipe)
         {
             var si = new ChildProcessStartInfo(
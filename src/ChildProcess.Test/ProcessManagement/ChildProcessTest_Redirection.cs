@@ -1,11 +1,20 @@
 // Copyright (c) @asmichi (https://github.com/asmichi). Licensed under the MIT License. See LICENCE in the project root for details.
 
 using System;
+using System.Buffers;
+using System.Collections.Generic;
+using System.Globalization;
 using System.IO;
+using System.IO.Pipes;
+using System.Linq;
 using System.Net.Sockets;
+using System.Runtime.InteropServices;
+using System.Text;
 using System.Threading.Tasks;
 using Asmichi.Utilities;
+using Microsoft.Win32.SafeHandles;
 using Xunit;
+using static Asmichi.ProcessManagement.ChildProcessExecutionTestUtil;
 
 namespace Asmichi.ProcessManagement
 {
@@ -336,6 +345,415 @@ namespace Asmichi.ProcessManagement
             }
         }
 
+        [Fact]
+        public void CanRedirectInputFromBytes()
+        {
+            // Larger than the pipe buffer so that the child process would block if the content were written to a pipe.
+            var text = string.Concat(Enumerable.Repeat("0123456789abcdef", 64 * 1024));
+
+            var si = new ChildProcessStartInfo(TestUtil.DotnetCommandName, TestUtil.TestChildPath, "EchoBack")
+            {
+                StdInputRedirection = InputRedirection.Bytes,
+                StdInputBytes = Encoding.UTF8.GetBytes(text),
+                StdOutputRedirection = OutputRedirection.OutputPipe,
+            };
+
+            // Each child process reads the content from the beginning.
+            Assert.Equal(text, ExecuteForStandardOutput(si));
+            Assert.Equal(text, ExecuteForStandardOutput(si));
+
+            si.StdInputBytes = ReadOnlyMemory<byte>.Empty;
+            Assert.Equal("", ExecuteForStandardOutput(si));
+        }
+
+        [Fact]
+        public void CanCaptureOutputInMemory()
+        {
+            var si = new ChildProcessStartInfo(TestUtil.DotnetCommandName, TestUtil.TestChildPath, "EchoOutAndError")
+            {
+                StdOutputRedirection = OutputRedirection.MemoryCapture,
+                StdErrorRedirection = OutputRedirection.MemoryCapture,
+            };
+
+            if (RuntimeInformation.IsOSPlatform(OSPlatform.Windows))
+            {
+                Assert.Throws<PlatformNotSupportedException>(() => ChildProcess.Start(si));
+                return;
+            }
+
+            using (var sut = ChildProcess.Start(si))
+            {
+                sut.WaitForExit();
+                Assert.Equal(0, sut.ExitCode);
+                Assert.False(sut.HasStandardOutput);
+                Assert.False(sut.HasStandardError);
+
+                using var capturedOutput = sut.GetCapturedStandardOutput();
+                using var capturedError = sut.GetCapturedStandardError();
+                Assert.Equal("TestChild.Out", Encoding.UTF8.GetString(capturedOutput.Memory.Span));
+                Assert.Equal("TestChild.Error", Encoding.UTF8.GetString(capturedError.Memory.Span));
+            }
+
+            si.StdErrorRedirection = OutputRedirection.NullDevice;
+            si.MemoryCaptureMaxLength = 0;
+            using (var sut = ChildProcess.Start(si))
+            {
+                sut.WaitForExit();
+                using var capturedOutput = sut.GetCapturedStandardOutput();
+                Assert.True(capturedOutput.Memory.IsEmpty);
+                Assert.Throws<InvalidOperationException>(() => sut.GetCapturedStandardError());
+            }
+
+            si.MemoryCaptureMaxLength = -1;
+            Assert.Throws<ArgumentException>(() => ChildProcess.Start(si));
+        }
+
+        [Fact]
+        public void CannotGetCapturedOutputBeforeExit()
+        {
+            if (RuntimeInformation.IsOSPlatform(OSPlatform.Windows))
+            {
+                return;
+            }
+
+            var si = new ChildProcessStartInfo(TestUtil.DotnetCommandName, TestUtil.TestChildPath, "EchoBack")
+            {
+                StdInputRedirection = InputRedirection.InputPipe,
+                StdOutputRedirection = OutputRedirection.MemoryCapture,
+            };
+
+            using var sut = ChildProcess.Start(si);
+            Assert.Throws<InvalidOperationException>(() => sut.GetCapturedStandardOutput());
+
+            sut.StandardInput.Write(new byte[] { (byte)'a' });
+            sut.StandardInput.Close();
+            sut.WaitForExit();
+            using var capturedOutput = sut.GetCapturedStandardOutput();
+            Assert.Equal(new byte[] { (byte)'a' }, capturedOutput.Memory.ToArray());
+        }
+
+        [Fact]
+        public void CapturedOutputOutlivesChildProcess()
+        {
+            if (RuntimeInformation.IsOSPlatform(OSPlatform.Windows))
+            {
+                return;
+            }
+
+            var si = new ChildProcessStartInfo(TestUtil.DotnetCommandName, TestUtil.TestChildPath, "EchoOutAndError")
+            {
+                StdOutputRedirection = OutputRedirection.MemoryCapture,
+                StdErrorRedirection = OutputRedirection.NullDevice,
+            };
+
+            IMemoryOwner<byte> captured;
+            using (var sut = ChildProcess.Start(si))
+            {
+                sut.WaitForExit();
+                captured = sut.GetCapturedStandardOutput();
+            }
+
+            // The mapping must stay alive while the owner is alive.
+            using (captured)
+            {
+                Assert.Equal("TestChild.Out", Encoding.UTF8.GetString(captured.Memory.Span));
+            }
+
+            Assert.Throws<ObjectDisposedException>(() => captured.Memory);
+        }
+
+        [Fact]
+        public void CanTeeOutput()
+        {
+            using var tmp = new TemporaryDirectory();
+            var outFile = Path.Combine(tmp.Location, "out");
+            var errFile = Path.Combine(tmp.Location, "err");
+
+            using (var outStream = new FileStream(outFile, FileMode.Create, FileAccess.Write))
+            using (var errStream = new FileStream(errFile, FileMode.Create, FileAccess.Write))
+            {
+                var si = new ChildProcessStartInfo(TestUtil.DotnetCommandName, TestUtil.TestChildPath, "EchoOutAndError")
+                {
+                    StdOutputRedirection = OutputRedirection.Tee,
+                    StdErrorRedirection = OutputRedirection.Tee,
+                    StdOutputTeeSinks = new[] { new ChildProcessTeeSink(outStream.SafeFileHandle) },
+                    StdErrorTeeSinks = new[] { new ChildProcessTeeSink(errStream.SafeFileHandle, ChildProcessTeeBackpressure.Drop) },
+                };
+
+                if (RuntimeInformation.IsOSPlatform(OSPlatform.Windows))
+                {
+                    Assert.Throws<PlatformNotSupportedException>(() => ChildProcess.Start(si));
+                    return;
+                }
+
+                using var sut = ChildProcess.Start(si);
+                using var srOut = new StreamReader(sut.StandardOutput);
+                using var srErr = new StreamReader(sut.StandardError);
+                var stdoutTask = srOut.ReadToEndAsync();
+                var stderrTask = srErr.ReadToEndAsync();
+                sut.WaitForExit();
+
+                // The helper closes the pipes only after it has written to all the sinks.
+                Assert.Equal("TestChild.Out", stdoutTask.Result);
+                Assert.Equal("TestChild.Error", stderrTask.Result);
+            }
+
+            Assert.Equal("TestChild.Out", File.ReadAllText(outFile));
+            Assert.Equal("TestChild.Error", File.ReadAllText(errFile));
+        }
+
+        [Fact]
+        public void CanTeeOutputToMultiplePipes()
+        {
+            if (RuntimeInformation.IsOSPlatform(OSPlatform.Windows))
+            {
+                return;
+            }
+
+            var content = CreateTeeTestContent();
+            using var pipe1 = new AnonymousPipeServerStream(PipeDirection.In);
+            using var pipe2 = new AnonymousPipeServerStream(PipeDirection.In);
+            var sinks = new[]
+            {
+                new ChildProcessTeeSink(pipe1.ClientSafePipeHandle),
+                new ChildProcessTeeSink(pipe2.ClientSafePipeHandle),
+            };
+
+            var sinkTasks = new[] { pipe1, pipe2 }.Select(x => Task.Run(() => ReadToEnd(x))).ToArray();
+            var output = RunWithTeedOutput(content, sinks, () =>
+            {
+                pipe1.DisposeLocalCopyOfClientHandle();
+                pipe2.DisposeLocalCopyOfClientHandle();
+            });
+
+            Assert.Equal(content, output);
+            Assert.Equal(content, sinkTasks[0].Result);
+            Assert.Equal(content, sinkTasks[1].Result);
+        }
+
+        [Fact]
+        public void CanTeeOutputToPipesNeverRead()
+        {
+            if (RuntimeInformation.IsOSPlatform(OSPlatform.Windows))
+            {
+                return;
+            }
+
+            // Far more than the capacity of a pipe.
+            var content = CreateTeeTestContent();
+            using var tmp = new TemporaryDirectory();
+            var spillFile = Path.Combine(tmp.Location, "spill");
+            using var dropPipe = new AnonymousPipeServerStream(PipeDirection.In);
+            using var spillPipe = new AnonymousPipeServerStream(PipeDirection.In);
+
+            byte[] output;
+            using (var spillStream = new FileStream(spillFile, FileMode.Create, FileAccess.Write))
+            {
+                var sinks = new[]
+                {
+                    new ChildProcessTeeSink(dropPipe.ClientSafePipeHandle, ChildProcessTeeBackpressure.Drop),
+                    new ChildProcessTeeSink(spillPipe.ClientSafePipeHandle, ChildProcessTeeBackpressure.Spill, spillStream.SafeFileHandle),
+                };
+
+                // The pipes are not read until the child has exited; they must not block the child or the other sinks.
+                output = RunWithTeedOutput(content, sinks, () =>
+                {
+                    dropPipe.DisposeLocalCopyOfClientHandle();
+                    spillPipe.DisposeLocalCopyOfClientHandle();
+                });
+            }
+
+            Assert.Equal(content, output);
+
+            // The drop sink got what fit in the pipe and lost the rest.
+            var dropped = ReadToEnd(dropPipe);
+            Assert.InRange(dropped.Length, 1, content.Length - 1);
+            Assert.Equal(content.AsSpan(0, dropped.Length).ToArray(), dropped);
+
+            // The spill sink got what fit in the pipe and the spill file holds the overflow.
+            var spilled = ReadToEnd(spillPipe);
+            Assert.InRange(spilled.Length, 1, content.Length - 1);
+            Assert.Equal(content, spilled.Concat(File.ReadAllBytes(spillFile)).ToArray());
+        }
+
+        [Fact]
+        public void CanTeeOutputAfterSinkClosed()
+        {
+            if (RuntimeInformation.IsOSPlatform(OSPlatform.Windows))
+            {
+                return;
+            }
+
+            var content = CreateTeeTestContent();
+            using var closedPipe = new AnonymousPipeServerStream(PipeDirection.In);
+            using var pipe = new AnonymousPipeServerStream(PipeDirection.In);
+            var sinks = new[]
+            {
+                new ChildProcessTeeSink(closedPipe.ClientSafePipeHandle),
+                new ChildProcessTeeSink(pipe.ClientSafePipeHandle),
+            };
+
+            var sinkTask = Task.Run(() => ReadToEnd(pipe));
+            var output = RunWithTeedOutput(content, sinks, () =>
+            {
+                closedPipe.DisposeLocalCopyOfClientHandle();
+                pipe.DisposeLocalCopyOfClientHandle();
+
+                // A broken sink is closed and must not disturb the others.
+                closedPipe.Dispose();
+            });
+
+            Assert.Equal(content, output);
+            Assert.Equal(content, sinkTask.Result);
+        }
+
+        private static byte[] CreateTeeTestContent() =>
+            Encoding.ASCII.GetBytes(string.Concat(Enumerable.Range(0, 100000).Select(x => x.ToString(CultureInfo.InvariantCulture) + "\n")));
+
+        // Echoes content through the child with the stdout tee'd to the sinks and returns what the current process read.
+        private static byte[] RunWithTeedOutput(byte[] content, IReadOnlyList<ChildProcessTeeSink> sinks, Action onStarted)
+        {
+            var si = new ChildProcessStartInfo(TestUtil.DotnetCommandName, TestUtil.TestChildPath, "EchoBack")
+            {
+                StdInputRedirection = InputRedirection.InputPipe,
+                StdOutputRedirection = OutputRedirection.Tee,
+                StdOutputTeeSinks = sinks,
+            };
+
+            using var sut = ChildProcess.Start(si);
+            onStarted();
+
+            var writeTask = Task.Run(() =>
+            {
+                using var input = sut.StandardInput;
+                input.Write(content, 0, content.Length);
+            });
+
+            var output = ReadToEnd(sut.StandardOutput);
+            writeTask.Wait();
+            sut.WaitForExit();
+            Assert.Equal(0, sut.ExitCode);
+            return output;
+        }
+
+        private static byte[] ReadToEnd(Stream stream)
+        {
+            var output = new MemoryStream();
+            stream.CopyTo(output);
+            return output.ToArray();
+        }
+
+        [Fact]
+        public void CanBufferOutputBeyondPipeCapacity()
+        {
+            // Far more than the capacity of a pipe; the child process must be able to exit without anyone reading the output.
+            var content = Encoding.ASCII.GetBytes(
+                string.Concat(Enumerable.Range(0, 400000).Select(x => x.ToString(CultureInfo.InvariantCulture) + "\n")));
+
+            foreach (var memoryBudget in new[] { 0, 256 * 1024, content.Length * 2 })
+            {
+                var si = new ChildProcessStartInfo(TestUtil.DotnetCommandName, TestUtil.TestChildPath, "EchoBack")
+                {
+                    StdInputRedirection = InputRedirection.Bytes,
+                    StdInputBytes = content,
+                    StdOutputRedirection = OutputRedirection.OutputPipe,
+                    OutputBufferMemoryBudget = memoryBudget,
+                };
+
+                using var sut = ChildProcess.Start(si);
+                sut.WaitForExit();
+                Assert.Equal(0, sut.ExitCode);
+
+                var output = new MemoryStream();
+                sut.StandardOutput.CopyTo(output);
+                Assert.Equal(content, output.ToArray());
+            }
+
+            var invalid = new ChildProcessStartInfo(TestUtil.DotnetCommandName, TestUtil.TestChildPath, "EchoBack")
+            {
+                StdOutputRedirection = OutputRedirection.OutputPipe,
+                OutputBufferMemoryBudget = -1,
+            };
+            Assert.Throws<ArgumentException>(() => ChildProcess.Start(invalid));
+        }
+
+        [Fact]
+        public void CanSpecifyStdioBufferSize()
+        {
+            var content = Encoding.ASCII.GetBytes(
+                string.Concat(Enumerable.Range(0, 100000).Select(x => x.ToString(CultureInfo.InvariantCulture) + "\n")));
+
+            var si = new ChildProcessStartInfo(TestUtil.DotnetCommandName, TestUtil.TestChildPath, "EchoBack")
+            {
+                StdInputRedirection = InputRedirection.InputPipe,
+                StdOutputRedirection = OutputRedirection.OutputPipe,
+                StdioBufferSize = 1024 * 1024,
+            };
+
+            using (var sut = ChildProcess.Start(si))
+            {
+                var writeTask = Task.Run(() =>
+                {
+                    using var input = sut.StandardInput;
+                    input.Write(content, 0, content.Length);
+                });
+
+                var output = new MemoryStream();
+                sut.StandardOutput.CopyTo(output);
+                writeTask.Wait();
+                sut.WaitForExit();
+
+                Assert.Equal(0, sut.ExitCode);
+                Assert.Equal(content, output.ToArray());
+            }
+
+            if (!RuntimeInformation.IsOSPlatform(OSPlatform.Windows))
+            {
+                // The stdout of the child is a unix socket for OutputPipe.
+                // Smaller than the default on Linux (net.core.wmem_default) so that the default would not pass; Linux doubles SO_SNDBUF.
+                const int SocketBufferSize = 32 * 1024;
+                var socketBufferSize = ExecuteForStandardOutput(
+                    new ChildProcessStartInfo(TestUtil.TestChildNativePath, "ReportStdoutBufferSize")
+                    {
+                        StdOutputRedirection = OutputRedirection.OutputPipe,
+                        StdioBufferSize = SocketBufferSize,
+                    });
+                Assert.InRange(int.Parse(socketBufferSize, CultureInfo.InvariantCulture), SocketBufferSize, SocketBufferSize * 2);
+            }
+
+            if (RuntimeInformation.IsOSPlatform(OSPlatform.Linux))
+            {
+                // The stdout of the child is a pipe created by the helper for Tee. Larger than the default (64 KiB).
+                const int PipeBufferSize = 256 * 1024;
+                using var nullDevice = File.OpenWrite("/dev/null");
+                var pipeBufferSize = ExecuteForStandardOutput(
+                    new ChildProcessStartInfo(TestUtil.TestChildNativePath, "ReportStdoutBufferSize")
+                    {
+                        StdOutputRedirection = OutputRedirection.Tee,
+                        StdOutputTeeSinks = new[] { new ChildProcessTeeSink(nullDevice.SafeFileHandle) },
+                        StdioBufferSize = PipeBufferSize,
+                    });
+                Assert.Equal(PipeBufferSize, int.Parse(pipeBufferSize, CultureInfo.InvariantCulture));
+            }
+
+            var invalid = new ChildProcessStartInfo(TestUtil.DotnetCommandName, TestUtil.TestChildPath, "EchoBack")
+            {
+                StdOutputRedirection = OutputRedirection.OutputPipe,
+                StdioBufferSize = 0,
+            };
+            Assert.Throws<ArgumentException>(() => ChildProcess.Start(invalid));
+        }
+
+        [Fact]
+        public void TeeSinkRequiresSpillHandleOnlyForSpill()
+        {
+            using var handle = new SafeFileHandle(IntPtr.Zero, false);
+            Assert.Throws<ArgumentException>(() => new ChildProcessTeeSink(handle, ChildProcessTeeBackpressure.Spill));
+            Assert.Throws<ArgumentException>(() => new ChildProcessTeeSink(handle, ChildProcessTeeBackpressure.Drop, handle));
+            Assert.Throws<ArgumentNullException>(() => new ChildProcessTeeSink(null!));
+            Assert.Same(handle, new ChildProcessTeeSink(handle, ChildProcessTeeBackpressure.Spill, handle).SpillHandle);
+        }
+
         [Fact]
         public void CanRedirectToSameFile()
         {
@@ -434,5 +852,89 @@ namespace Asmichi.ProcessManagement
                 Assert.Equal(Text, File.ReadAllText(outFile));
             }
         }
+
+        [Fact]
+        public void CanPassExtraFileDescriptors()
+        {
+            if (RuntimeInformation.IsOSPlatform(OSPlatform.Windows))
+            {
+                Assert.Throws<PlatformNotSupportedException>(() => ChildProcess.Start(
+                    new ChildProcessStartInfo(TestUtil.TestChildNativePath)
+                    {
+                        ExtraFileDescriptors = new[] { KeyValuePair.Create(3, (SafeHandle)new SafeFileHandle(IntPtr.Zero, false)) },
+                    }));
+                return;
+            }
+
+            using var tmp = new TemporaryDirectory();
+
+            // More fds than one sendmsg call can carry, with target fds overlapping the source fds in the helper.
+            const int FileCount = 20;
+            var files = Enumerable.Range(0, FileCount).Select(i => File.Create(Path.Combine(tmp.Location, i.ToString(CultureInfo.InvariantCulture)))).ToArray();
+            try
+            {
+                var extraFds = files.Select((x, i) => KeyValuePair.Create(3 + i, (SafeHandle)x.SafeFileHandle)).ToArray();
+
+                foreach (var targetFd in new[] { 3, 3 + FileCount - 1 })
+                {
+                    var si = new ChildProcessStartInfo(TestUtil.TestChildNativePath, "WriteToFd", targetFd.ToString(CultureInfo.InvariantCulture), "foo")
+                    {
+                        ExtraFileDescriptors = extraFds,
+                    };
+
+                    using var sut = ChildProcess.Start(si);
+                    sut.WaitForExit();
+                    Assert.Equal(0, sut.ExitCode);
+                }
+            }
+            finally
+            {
+                foreach (var x in files)
+                {
+                    x.Dispose();
+                }
+            }
+
+            Assert.Equal("foo", File.ReadAllText(Path.Combine(tmp.Location, "0")));
+            Assert.Equal(string.Empty, File.ReadAllText(Path.Combine(tmp.Location, "1")));
+            Assert.Equal("foo", File.ReadAllText(Path.Combine(tmp.Location, (FileCount - 1).ToString(CultureInfo.InvariantCulture))));
+
+            // Invalid target fds
+            using var nullDevice = File.OpenWrite("/dev/null");
+            Assert.Throws<ArgumentException>(() => ChildProcess.Start(
+                new ChildProcessStartInfo(TestUtil.TestChildNativePath)
+                {
+                    ExtraFileDescriptors = new[] { KeyValuePair.Create(2, (SafeHandle)nullDevice.SafeFileHandle) },
+                }));
+            Assert.Throws<ArgumentException>(() => ChildProcess.Start(
+                new ChildProcessStartInfo(TestUtil.TestChildNativePath)
+                {
+                    ExtraFileDescriptors = new[]
+                    {
+                        KeyValuePair.Create(3, (SafeHandle)nullDevice.SafeFileHandle),
+                        KeyValuePair.Create(3, (SafeHandle)nullDevice.SafeFileHandle),
+                    },
+                }));
+        }
+
+        [Fact]
+        public void CanRestrictFileDescriptorInheritance()
+        {
+            if (RuntimeInformation.IsOSPlatform(OSPlatform.Windows))
+            {
+                return;
+            }
+
+            using var nullDevice = File.OpenWrite("/dev/null");
+            var si = new ChildProcessStartInfo(TestUtil.TestChildNativePath, "ReportOpenFds")
+            {
+                StdOutputRedirection = OutputRedirection.OutputPipe,
+                Flags = ChildProcessFlags.RestrictFileDescriptorInheritance,
+                ExtraFileDescriptors = new[] { KeyValuePair.Create(7, (SafeHandle)nullDevice.SafeFileHandle) },
+            };
+
+            var output = ChildProcessExecutionTestUtil.ExecuteForStandardOutput(si);
+            Assert.Equal("7", output);
+        }
     }
 }
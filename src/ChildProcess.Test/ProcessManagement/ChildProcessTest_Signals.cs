@@ -69,6 +69,98 @@ namespace Asmichi.ProcessManagement
             Assert.NotEqual(0, sut.ExitCode);
         }
 
+        [Fact]
+        public void CanSignalAll()
+        {
+            var si = new ChildProcessStartInfo(TestUtil.TestChildNativePath, "ReportSignal")
+            {
+                StdInputRedirection = InputRedirection.InputPipe,
+                StdOutputRedirection = OutputRedirection.OutputPipe,
+            };
+
+            var processes = new IChildProcess[3];
+            try
+            {
+                for (int i = 0; i < processes.Length; i++)
+                {
+                    processes[i] = ChildProcess.Start(si);
+                }
+
+                foreach (var p in processes)
+                {
+                    Assert.Equal('R', p.StandardOutput.ReadByte());
+                }
+
+                ChildProcess.SignalAll(processes, ChildProcessSignal.Interrupt);
+                foreach (var p in processes)
+                {
+                    Assert.Equal('I', p.StandardOutput.ReadByte());
+                }
+
+                ChildProcess.SignalAll(processes, ChildProcessSignal.Kill);
+                foreach (var p in processes)
+                {
+                    p.WaitForExit();
+                    Assert.NotEqual(0, p.ExitCode);
+                }
+
+                // Succeeds for processes that have already exited.
+                ChildProcess.SignalAll(processes, ChildProcessSignal.Kill);
+            }
+            finally
+            {
+                foreach (var p in processes)
+                {
+                    p?.Dispose();
+                }
+            }
+        }
+
+        [Fact]
+        public void CanSendUnixSignals()
+        {
+            if (RuntimeInformation.IsOSPlatform(OSPlatform.Windows))
+            {
+                return;
+            }
+
+            var si = new ChildProcessStartInfo(TestUtil.TestChildNativePath, "ReportSignal")
+            {
+                StdInputRedirection = InputRedirection.InputPipe,
+                StdOutputRedirection = OutputRedirection.OutputPipe,
+            };
+
+            using var sut = ChildProcess.Start(si);
+
+            Assert.Equal('R', sut.StandardOutput.ReadByte());
+
+            sut.SendSignal(ChildProcessSignal.Hangup);
+            Assert.Equal('H', sut.StandardOutput.ReadByte());
+
+            sut.SendSignal(ChildProcessSignal.User1);
+            Assert.Equal('1', sut.StandardOutput.ReadByte());
+
+            sut.SendSignal(ChildProcessSignal.User2);
+            Assert.Equal('2', sut.StandardOutput.ReadByte());
+
+            sut.Suspend();
+            sut.Resume();
+            Assert.Equal('C', sut.StandardOutput.ReadByte());
+
+            sut.SendSignal(ChildProcessSignal.Kill);
+            sut.WaitForExit();
+
+            Assert.NotEqual(0, sut.ExitCode);
+        }
+
+        [Fact]
+        public void SignalAllValidatesArguments()
+        {
+            Assert.Throws<ArgumentNullException>(() => ChildProcess.SignalAll(null!, ChildProcessSignal.Kill));
+            Assert.Throws<ArgumentException>(() => ChildProcess.SignalAll(new IChildProcess[] { null! }, ChildProcessSignal.Kill));
+            Assert.Throws<ArgumentOutOfRangeException>(() => ChildProcess.SignalAll(Array.Empty<IChildProcess>(), (ChildProcessSignal)100));
+        }
+
         private static bool HasWorkaroundForWindows1809 =>
             RuntimeInformation.IsOSPlatform(OSPlatform.Windows) && WindowsVersion.NeedsWorkaroundForWindows1809;
     }
@@ -0,0 +1,102 @@
+// Copyright (c) @asmichi (https://github.com/asmichi). Licensed under the MIT License. See LICENCE in the project root for details.
+
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+using Asmichi.ProcessManagement;
+using Xunit;
+
+namespace Asmichi.Utilities
+{
+    public sealed class LineSplitterTest
+    {
+        public static readonly object[][] SplitsLinesTestCases = new object[][]
+        {
+            new object[] { "", Array.Empty<string>() },
+            new object[] { "a", new[] { "a" } },
+            new object[] { "a\n", new[] { "a" } },
+            new object[] { "a\r\nb\nc", new[] { "a", "b", "c" } },
+            new object[] { "\n\r\n\n", new[] { "", "", "" } },
+            new object[] { "a\rb\r\n\r", new[] { "a\rb", "\r" } },
+            new object[] { "0123456789\n", new[] { "0123", "4567", "89" } },
+            new object[] { "0123\n4567", new[] { "0123", "4567" } },
+            new object[] { "0123\r\n01234\n", new[] { "0123", "0123", "4" } },
+            new object[] { "012345", new[] { "0123", "45" } },
+        };
+
+        [Theory]
+        [MemberData(nameof(SplitsLinesTestCases))]
+        public void SplitsLines(string input, string[] expected)
+        {
+            // Feed the input in chunks of various sizes so that lines straddle reads.
+            foreach (var chunkSize in new[] { 1, 2, 3, 7, 1024 })
+            {
+                Assert.Equal(expected, Split(Encoding.UTF8.GetBytes(input), chunkSize, bufferSize: 2, maxLineLength: 4));
+            }
+        }
+
+        [Fact]
+        public void GrowsBufferUpToMaxLineLength()
+        {
+            var line = new string('x', 100_000);
+            var input = Encoding.UTF8.GetBytes(line + "\n" + line);
+
+            Assert.Equal(new[] { line, line }, Split(input, 4096, bufferSize: 16, maxLineLength: 1024 * 1024));
+        }
+
+        [Fact]
+        public void ReaderReadsLines()
+        {
+            var input = Encoding.UTF8.GetBytes("a\r\nbb\n\nccc");
+            var expected = new[] { "a", "bb", "", "ccc" };
+
+            var actual = new List<string>();
+            ChildProcessLineReader.ReadLines(new MemoryStream(input), line => actual.Add(Encoding.UTF8.GetString(line)));
+            Assert.Equal(expected, actual);
+        }
+
+        [Fact]
+        public async Task ReaderReadsLinesAsync()
+        {
+            var input = Encoding.UTF8.GetBytes("a\r\nbb\n\nccc");
+            var expected = new[] { "a", "bb", "", "ccc" };
+
+            var actual = new List<string>();
+            await ChildProcessLineReader.ReadLinesAsync(new MemoryStream(input), line => actual.Add(Encoding.UTF8.GetString(line)));
+            Assert.Equal(expected, actual);
+
+            actual.Clear();
+            await foreach (var line in ChildProcessLineReader.EnumerateLinesAsync(new MemoryStream(input)))
+            {
+                actual.Add(Encoding.UTF8.GetString(line.Span));
+            }
+            Assert.Equal(expected, actual);
+        }
+
+        private static List<string> Split(byte[] input, int chunkSize, int bufferSize, int maxLineLength)
+        {
+            var lines = new List<string>();
+            using var sut = new LineSplitter(bufferSize, maxLineLength);
+
+            var offset = 0;
+            while (!sut.IsCompleted)
+            {
+                var buffer = sut.GetReadBuffer().Span;
+                var count = Math.Min(Math.Min(chunkSize, buffer.Length), input.Length - offset);
+                input.AsSpan(offset, count).CopyTo(buffer);
+                offset += count;
+                sut.Advance(count);
+
+                while (sut.TryReadLine(out var line))
+                {
+                    lines.Add(Encoding.UTF8.GetString(line.Span));
+                }
+            }
+
+            return lines;
+        }
+    }
+}
@@ -25,11 +25,23 @@ namespace Asmichi.Interop.Linux
             [In] string path,
             [Out] out SafeFileHandle sock);
 
+        [DllImport(DllName, SetLastError = true)]
+        public static extern SafeFileHandle CreateCaptureFile(
+            [In] long maxLength);
+
         [DllImport(DllName, SetLastError = true)]
         public static extern bool CreatePipe(
             [Out] out SafeFileHandle readPipe,
             [Out] out SafeFileHandle writePipe);
 
+        [DllImport(DllName, SetLastError = true)]
+        public static extern unsafe SafeFileHandle CreateReadOnlyFile(
+            [In] void* data,
+            [In] nuint len);
+
+        [DllImport(DllName, SetLastError = true)]
+        public static extern SafeFileHandle CreateSpillFile();
+
         [DllImport(DllName, SetLastError = true)]
         public static extern bool DuplicateStdFileForChild(
             [In] int stdFd,
@@ -60,9 +72,21 @@ namespace Asmichi.Interop.Linux
         [DllImport(DllName)]
         public static extern int GetPid();
 
+        [DllImport(DllName, SetLastError = true)]
+        public static extern bool MapCapturedFile(
+            [In] SafeFileHandle fd,
+            [In] long maxLength,
+            [Out] out IntPtr addr,
+            [Out] out nuint len);
+
         [DllImport(DllName, SetLastError = true)]
         public static extern SafeFileHandle OpenNullDevice(int fileAccess);
 
+        [DllImport(DllName, SetLastError = true)]
+        public static extern bool SetChannelBufferSize(
+            [In] SafeFileHandle fd,
+            [In] int size);
+
         [DllImport(DllName, SetLastError = true)]
         public static extern SafeSocketHandle SubchannelCreate(
             [In] IntPtr mainChannelFd);
@@ -84,11 +108,18 @@ namespace Asmichi.Interop.Linux
             [In] nuint len);
 
         [DllImport(DllName, SetLastError = true, CharSet = CharSet.Ansi, BestFitMapping = false, ThrowOnUnmappableChar = true)]
-        public static extern unsafe bool SubchannelSendExactBytesAndFds(
+        public static extern unsafe bool SubchannelSendRequest(
             [In] SafeSocketHandle subchannelFd,
-            [In] void* buf,
-            [In] nuint len,
+            [In] void* header,
+            [In] nuint headerLen,
+            [In] void* body,
+            [In] nuint bodyLen,
             [In] int* fds,
             [In] nuint fdCount);
+
+        [DllImport(DllName, SetLastError = true)]
+        public static extern bool UnmapCapturedFile(
+            [In] IntPtr addr,
+            [In] nuint len);
     }
 }
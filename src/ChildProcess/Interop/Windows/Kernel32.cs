@@ -27,6 +27,9 @@ namespace Asmichi.Interop.Windows
         public const int OPEN_ALWAYS = 4;
         public const int TRUNCATE_EXISTING = 5;
 
+        public const int FILE_ATTRIBUTE_TEMPORARY = 0x00000100;
+        public const int FILE_FLAG_DELETE_ON_CLOSE = 0x04000000;
+
         public const int FILE_TYPE_UNKNOWN = 0x0000;
         public const int FILE_TYPE_CHAR = 0x0002;
 
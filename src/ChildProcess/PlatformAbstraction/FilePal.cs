@@ -10,8 +10,10 @@ namespace Asmichi.PlatformAbstraction
     internal interface IFilePal
     {
         (SafeFileHandle readPipe, SafeFileHandle writePipe) CreatePipePair();
-        (Stream serverStream, SafeFileHandle clientPipe) CreatePipePairWithAsyncServerSide(PipeDirection pipeDirection);
+        (Stream serverStream, SafeFileHandle clientPipe) CreatePipePairWithAsyncServerSide(PipeDirection pipeDirection, int bufferSize);
         SafeFileHandle OpenNullDevice(FileAccess fileAccess);
+        SafeFileHandle CreateReadOnlyFile(ReadOnlySpan<byte> content);
+        SafeFileHandle CreateTemporaryFile();
     }
 
     internal static class FilePal
@@ -33,14 +35,30 @@ namespace Asmichi.PlatformAbstraction
 
         public static (SafeFileHandle readPipe, SafeFileHandle writePipe) CreatePipePair() => Impl.CreatePipePair();
 
+        /// <summary>
+        /// Creates an anonymous read-only file that has the specified content, positioned at the beginning.
+        /// The file is backed by memory where possible and vanishes when the last handle to it is closed.
+        /// </summary>
+        /// <param name="content">The content of the file.</param>
+        /// <returns>A handle to the file.</returns>
+        public static SafeFileHandle CreateReadOnlyFile(ReadOnlySpan<byte> content) => Impl.CreateReadOnlyFile(content);
+
+        /// <summary>
+        /// Creates an empty read-write temporary file on disk that is invisible to others (unlinked on Unix)
+        /// and vanishes when the last handle to it is closed.
+        /// </summary>
+        /// <returns>A handle to the file.</returns>
+        public static SafeFileHandle CreateTemporaryFile() => Impl.CreateTemporaryFile();
+
         /// <summary>
         /// Creates a pipe pair. Asynchronous IO is enabled for the server side.
         /// If <paramref name="pipeDirection"/> is <see cref="PipeDirection.In"/>, clientPipe is created with asynchronous IO enabled.
         /// If <see cref="PipeDirection.Out"/>, serverStream is created with asynchronous moIOde enabled.
         /// </summary>
         /// <param name="pipeDirection">Specifies which side is the server side.</param>
+        /// <param name="bufferSize">The buffer capacity of the pipe in bytes. 0 for the default.</param>
         /// <returns>A pipe pair.</returns>
-        public static (Stream serverStream, SafeFileHandle clientPipe) CreatePipePairWithAsyncServerSide(PipeDirection pipeDirection) =>
-            Impl.CreatePipePairWithAsyncServerSide(pipeDirection);
+        public static (Stream serverStream, SafeFileHandle clientPipe) CreatePipePairWithAsyncServerSide(PipeDirection pipeDirection, int bufferSize = 0) =>
+            Impl.CreatePipePairWithAsyncServerSide(pipeDirection, bufferSize);
     }
 }
@@ -1,5 +1,6 @@
 // Copyright (c) @asmichi (https://github.com/asmichi). Licensed under the MIT License. See LICENCE in the project root for details.
 
+using System;
 using System.ComponentModel;
 using System.Diagnostics;
 using System.Globalization;
@@ -29,6 +30,32 @@ namespace Asmichi.PlatformAbstraction.Unix
             return fd;
         }
 
+        public unsafe SafeFileHandle CreateReadOnlyFile(ReadOnlySpan<byte> content)
+        {
+            fixed (byte* pContent = content)
+            {
+                // A sealed memfd on Linux.
+                var fd = LibChildProcess.CreateReadOnlyFile(pContent, (nuint)content.Length);
+                if (fd.IsInvalid)
+                {
+                    throw new Win32Exception();
+                }
+
+                return fd;
+            }
+        }
+
+        public SafeFileHandle CreateTemporaryFile()
+        {
+            var fd = LibChildProcess.CreateSpillFile();
+            if (fd.IsInvalid)
+            {
+                throw new Win32Exception();
+            }
+
+            return fd;
+        }
+
         private static int ToLibChildProcessFileAccess(FileAccess fileAccess)
         {
             return (((fileAccess & FileAccess.Read) != 0) ? LibChildProcess.FileAccessRead : 0)
@@ -45,7 +72,7 @@ namespace Asmichi.PlatformAbstraction.Unix
             return (readPipe, writePipe);
         }
 
-        public (Stream serverStream, SafeFileHandle clientPipe) CreatePipePairWithAsyncServerSide(PipeDirection pipeDirection)
+        public (Stream serverStream, SafeFileHandle clientPipe) CreatePipePairWithAsyncServerSide(PipeDirection pipeDirection, int bufferSize)
         {
             var pipePath = CreateUniqueSocketPath();
 
@@ -62,6 +89,27 @@ namespace Asmichi.PlatformAbstraction.Unix
 
                 var serverSock = listeningSock.Accept();
                 var serverStream = new NetworkStream(serverSock, ownsSocket: true);
+
+                if (bufferSize > 0)
+                {
+                    // The capacity of a unix stream socket is mostly governed by SO_SNDBUF of the writing side; set both sides.
+                    try
+                    {
+                        serverSock.SendBufferSize = bufferSize;
+                        serverSock.ReceiveBufferSize = bufferSize;
+                        if (!LibChildProcess.SetChannelBufferSize(clientSock, bufferSize))
+                        {
+                            throw new Win32Exception();
+                        }
+                    }
+                    catch
+                    {
+                        serverStream.Dispose();
+                        clientSock.Dispose();
+                        throw;
+                    }
+                }
+
                 return (serverStream, clientSock);
             }
             finally
@@ -24,6 +24,72 @@ namespace Asmichi.PlatformAbstraction.Windows
             return OpenFile(NullDeviceFileName, fileAccess);
         }
 
+        public SafeFileHandle CreateReadOnlyFile(ReadOnlySpan<byte> content)
+        {
+            var path = Path.Combine(Path.GetTempPath(), "AsmichiChildProcess." + Guid.NewGuid().ToString("N", CultureInfo.InvariantCulture));
+            var writeHandle = Kernel32.CreateFile(
+                path,
+                Kernel32.GENERIC_WRITE,
+                Kernel32.FILE_SHARE_READ | Kernel32.FILE_SHARE_DELETE,
+                IntPtr.Zero,
+                Kernel32.CREATE_NEW,
+                Kernel32.FILE_ATTRIBUTE_TEMPORARY | Kernel32.FILE_FLAG_DELETE_ON_CLOSE,
+                IntPtr.Zero);
+            if (writeHandle.IsInvalid)
+            {
+                writeHandle.Dispose();
+                throw new Win32Exception();
+            }
+
+            using var writeStream = new FileStream(writeHandle, FileAccess.Write, 1);
+
+            // Open a read-only handle before closing the write handle (which deletes the file when the read handle is closed).
+            var readHandle = Kernel32.CreateFile(
+                path,
+                Kernel32.GENERIC_READ,
+                Kernel32.FILE_SHARE_READ | Kernel32.FILE_SHARE_WRITE | Kernel32.FILE_SHARE_DELETE,
+                IntPtr.Zero,
+                Kernel32.OPEN_EXISTING,
+                0,
+                IntPtr.Zero);
+            if (readHandle.IsInvalid)
+            {
+                readHandle.Dispose();
+                throw new Win32Exception();
+            }
+
+            try
+            {
+                writeStream.Write(content);
+                return readHandle;
+            }
+            catch
+            {
+                readHandle.Dispose();
+                throw;
+            }
+        }
+
+        public SafeFileHandle CreateTemporaryFile()
+        {
+            var path = Path.Combine(Path.GetTempPath(), "AsmichiChildProcess." + Guid.NewGuid().ToString("N", CultureInfo.InvariantCulture));
+            var handle = Kernel32.CreateFile(
+                path,
+                Kernel32.GENERIC_READ | Kernel32.GENERIC_WRITE,
+                0,
+                IntPtr.Zero,
+                Kernel32.CREATE_NEW,
+                Kernel32.FILE_ATTRIBUTE_TEMPORARY | Kernel32.FILE_FLAG_DELETE_ON_CLOSE,
+                IntPtr.Zero);
+            if (handle.IsInvalid)
+            {
+                handle.Dispose();
+                throw new Win32Exception();
+            }
+
+            return handle;
+        }
+
         private static SafeFileHandle OpenFile(
             string fileName,
             FileAccess fileAccess)
@@ -62,9 +128,10 @@ namespace Asmichi.PlatformAbstraction.Windows
             return (readPipe, writePipe);
         }
 
-        public (Stream serverStream, SafeFileHandle clientPipe) CreatePipePairWithAsyncServerSide(PipeDirection pipeDirection)
+        public (Stream serverStream, SafeFileHandle clientPipe) CreatePipePairWithAsyncServerSide(PipeDirection pipeDirection, int bufferSize)
         {
             var (serverMode, clientMode) = ToModes(pipeDirection);
+            var pipeBufferSize = bufferSize > 0 ? (uint)bufferSize : 4096;
 
             while (true)
             {
@@ -77,8 +144,8 @@ namespace Asmichi.PlatformAbstraction.Windows
                     serverMode | Kernel32.FILE_FLAG_OVERLAPPED | Kernel32.FILE_FLAG_FIRST_PIPE_INSTANCE,
                     Kernel32.PIPE_TYPE_BYTE | Kernel32.PIPE_READMODE_BYTE | Kernel32.PIPE_WAIT | Kernel32.PIPE_REJECT_REMOTE_CLIENTS,
                     1,
-                    4096,
-                    4096,
+                    pipeBufferSize,
+                    pipeBufferSize,
                     0,
                     IntPtr.Zero);
                 if (serverPipe.IsInvalid)
@@ -30,9 +30,64 @@ namespace Asmichi.ProcessManagement
         {
             _ = startInfo ?? throw new ArgumentNullException(nameof(startInfo));
 
+            var startInfoInternal = CreateStartInfoInternal(startInfo);
+            var resolvedPath = ResolveExecutablePath(startInfoInternal.FileName!, startInfoInternal.Flags);
+            return StartCore(ref startInfoInternal, resolvedPath, null);
+        }
+
+        /// <summary>
+        /// Starts a child process as specified in <paramref name="startInfo"/>.
+        /// </summary>
+        /// <param name="startInfo"><see cref="PreparedChildProcessStartInfo"/> created by <see cref="Prepare(ChildProcessStartInfo)"/>.</param>
+        /// <returns>The started process.</returns>
+        /// <exception cref="ArgumentException"><paramref name="startInfo"/> has an invalid value.</exception>
+        /// <exception cref="ArgumentNullException"><paramref name="startInfo"/> is null.</exception>
+        /// <exception cref="ChildProcessStartingBlockedException">Starting the child process is blocked. See <see cref="ChildProcessStartingBlockedException"/> for details.</exception>
+        /// <exception cref="FileNotFoundException">The executable not found.</exception>
+        /// <exception cref="IOException">Failed to open a specified file.</exception>
+        /// <exception cref="AsmichiChildProcessLibraryCrashedException">The operation failed due to critical disturbance.</exception>
+        /// <exception cref="Win32Exception">Another kind of native errors.</exception>
+        public static IChildProcess Start(PreparedChildProcessStartInfo startInfo)
+        {
+            _ = startInfo ?? throw new ArgumentNullException(nameof(startInfo));
+
+            var startInfoInternal = startInfo.StartInfo;
+            return StartCore(ref startInfoInternal, startInfo.ResolvedPath, startInfo.PreparedRequest);
+        }
+
+        /// <summary>
+        /// <para>
+        /// Validates <paramref name="startInfo"/>, resolves the executable and encodes the arguments and the environment variables once
+        /// so that <see cref="Start(PreparedChildProcessStartInfo)"/> can start child processes repeatedly without redoing that work.
+        /// </para>
+        /// <para>
+        /// The arguments, the environment variables and the resolved path are captured at this point
+        /// (except that the environment variables of the current process are read on each start if they are inherited as is).
+        /// </para>
+        /// </summary>
+        /// <param name="startInfo"><see cref="ChildProcessStartInfo"/>.</param>
+        /// <returns>The prepared start info.</returns>
+        /// <exception cref="ArgumentException"><paramref name="startInfo"/> has an invalid value.</exception>
+        /// <exception cref="ArgumentNullException"><paramref name="startInfo"/> is null.</exception>
+        /// <exception cref="FileNotFoundException">The executable not found.</exception>
+        public static PreparedChildProcessStartInfo Prepare(ChildProcessStartInfo startInfo)
+        {
+            _ = startInfo ?? throw new ArgumentNullException(nameof(startInfo));
+
+            var startInfoInternal = CreateStartInfoInternal(startInfo);
+            var resolvedPath = ResolveExecutablePath(startInfoInternal.FileName!, startInfoInternal.Flags);
+            var preparedRequest = ChildProcessHelper.Shared.PrepareSpawnRequest(in startInfoInternal, resolvedPath);
+            return new PreparedChildProcessStartInfo(startInfoInternal, resolvedPath, preparedRequest);
+        }
+
+        private static ChildProcessStartInfoInternal CreateStartInfoInternal(ChildProcessStartInfo startInfo)
+        {
             var startInfoInternal = new ChildProcessStartInfoInternal(startInfo);
             _ = startInfoInternal.FileName ?? throw new ArgumentException("ChildProcessStartInfo.FileName must not be null.", nameof(startInfo));
             _ = startInfoInternal.Arguments ?? throw new ArgumentException("ChildProcessStartInfo.Arguments must not be null.", nameof(startInfo));
+            _ = startInfoInternal.ExtraFileDescriptors ?? throw new ArgumentException("ChildProcessStartInfo.ExtraFileDescriptors must not be null.", nameof(startInfo));
+            _ = startInfoInternal.StdOutputTeeSinks ?? throw new ArgumentException("ChildProcessStartInfo.StdOutputTeeSinks must not be null.", nameof(startInfo));
+            _ = startInfoInternal.StdErrorTeeSinks ?? throw new ArgumentException("ChildProcessStartInfo.StdErrorTeeSinks must not be null.", nameof(startInfo));
 
             var flags = startInfoInternal.Flags;
             if (flags.HasUseCustomCodePage() && flags.HasAttachToCurrentConsole())
@@ -40,11 +95,19 @@ namespace Asmichi.ProcessManagement
                 throw new ArgumentException(
                     $"{nameof(ChildProcessFlags.UseCustomCodePage)} cannot be combined with {nameof(ChildProcessFlags.AttachToCurrentConsole)}.", nameof(startInfo));
             }
+            if (startInfoInternal.Job is not null && flags.HasAttachToCurrentConsole())
+            {
+                throw new ArgumentException(
+                    $"{nameof(ChildProcessStartInfo.Job)} cannot be combined with {nameof(ChildProcessFlags.AttachToCurrentConsole)}.", nameof(startInfo));
+            }
 
             ChildProcessHelper.Shared.ValidatePlatformSpecificStartInfo(in startInfoInternal);
 
-            var resolvedPath = ResolveExecutablePath(startInfoInternal.FileName, startInfoInternal.Flags);
+            return startInfoInternal;
+        }
 
+        private static ChildProcessImpl StartCore(ref ChildProcessStartInfoInternal startInfoInternal, string resolvedPath, object? preparedRequest)
+        {
             using var stdHandles = new PipelineStdHandleCreator(ref startInfoInternal);
             IChildProcessStateHolder processState;
             try
@@ -52,9 +115,12 @@ namespace Asmichi.ProcessManagement
                 processState = ChildProcessHelper.Shared.SpawnProcess(
                     startInfo: ref startInfoInternal,
                     resolvedPath: resolvedPath,
+                    preparedRequest: preparedRequest,
                     stdIn: stdHandles.PipelineStdIn,
                     stdOut: stdHandles.PipelineStdOut,
-                    stdErr: stdHandles.PipelineStdErr);
+                    stdErr: stdHandles.PipelineStdErr,
+                    stdOutTeeSinks: stdHandles.PipelineStdOutTeeSinks,
+                    stdErrTeeSinks: stdHandles.PipelineStdErrTeeSinks);
             }
             catch (Win32Exception ex)
             {
@@ -69,11 +135,68 @@ namespace Asmichi.ProcessManagement
                 throw;
             }
 
-            var process = new ChildProcessImpl(processState, stdHandles.InputStream, stdHandles.OutputStream, stdHandles.ErrorStream);
+            var process = new ChildProcessImpl(
+                processState, stdHandles.InputStream, stdHandles.OutputStream, stdHandles.ErrorStream, stdHandles.CapturedOutput, stdHandles.CapturedError);
             stdHandles.DetachStreams();
             return process;
         }
 
+        /// <summary>
+        /// <para>
+        /// Sends <paramref name="signal"/> to each of <paramref name="processes"/>.
+        /// Attempts to signal every process even if signaling some of them fails.
+        /// </para>
+        /// <para>
+        /// (Non-Windows-specific) Signals all the processes with one request to the helper process
+        /// (per 65536 processes) instead of one request per process.
+        /// </para>
+        /// </summary>
+        /// <param name="processes">The processes to signal.</param>
+        /// <param name="signal">The signal to send.</param>
+        /// <exception cref="ArgumentNullException"><paramref name="processes"/> is null.</exception>
+        /// <exception cref="ArgumentException"><paramref name="processes"/> contains null.</exception>
+        /// <exception cref="ArgumentOutOfRangeException"><paramref name="signal"/> is not a valid value.</exception>
+        /// <exception cref="InvalidOperationException">
+        /// <paramref name="signal"/> is not <see cref="ChildProcessSignal.Kill"/> and some of <paramref name="processes"/> do not support sending signals.
+        /// </exception>
+        /// <exception cref="ObjectDisposedException">Some of <paramref name="processes"/> have been disposed.</exception>
+        /// <exception cref="PlatformNotSupportedException"><paramref name="signal"/> is not supported on this platform.</exception>
+        /// <exception cref="Win32Exception">Failed to signal some of the processes. Describes the first failure.</exception>
+        public static void SignalAll(IEnumerable<IChildProcess> processes, ChildProcessSignal signal)
+        {
+            _ = processes ?? throw new ArgumentNullException(nameof(processes));
+            if (!signal.IsValid())
+            {
+                throw new ArgumentOutOfRangeException(nameof(signal));
+            }
+
+            // Validate everything before sending anything.
+            var states = new List<IChildProcessState>();
+            var otherProcesses = new List<IChildProcess>();
+            foreach (var process in processes)
+            {
+                switch (process)
+                {
+                    case null:
+                        throw new ArgumentException("The collection must not contain null.", nameof(processes));
+                    case ChildProcessImpl impl:
+                        states.Add(impl.GetStateForSignal(signal));
+                        break;
+                    default:
+                        // Not created by us; fall back to the individual methods.
+                        otherProcesses.Add(process);
+                        break;
+                }
+            }
+
+            ChildProcessHelper.Shared.SignalAll(states, signal);
+
+            foreach (var process in otherProcesses)
+            {
+                process.SendSignal(signal);
+            }
+        }
+
         private static string ResolveExecutablePath(string fileName, ChildProcessFlags flags)
         {
             bool ignoreSearchPath = flags.HasIgnoreSearchPath();
@@ -68,6 +68,39 @@ namespace Asmichi.ProcessManagement
             return new ChildProcessCreationContext(processEnvVars.AsMemory());
         }
 
+        /// <summary>
+        /// <para>
+        /// Creates a <see cref="ChildProcessCreationContext"/> with the environment variables of this context
+        /// overridden or removed by <paramref name="environmentVariables"/>
+        /// (in the same way as <see cref="ChildProcessStartInfo.ExtraEnvironmentVariables"/>).
+        /// </para>
+        /// <para>
+        /// Prefer this to specifying the same <see cref="ChildProcessStartInfo.ExtraEnvironmentVariables"/> to many child processes:
+        /// the environment variables of a context are merged once and (when no extra environment variables are specified)
+        /// encoded once for all the child processes created with it.
+        /// </para>
+        /// </summary>
+        /// <param name="environmentVariables">
+        /// The environment variables to override. If the value is <see langword="null"/> or empty, the environment variable is removed.
+        /// Names must not contain '\0' or '='. Values must not contain '\0'.
+        /// </param>
+        /// <returns>Created instance of the <see cref="ChildProcessCreationContext"/> class.</returns>
+        /// <exception cref="ArgumentNullException"><paramref name="environmentVariables"/> is null.</exception>
+        /// <exception cref="ArgumentException"><paramref name="environmentVariables"/> contains a name that contains '\0' or '='.</exception>
+        /// <exception cref="ArgumentException"><paramref name="environmentVariables"/> contains a value that contains '\0'.</exception>
+        public ChildProcessCreationContext WithEnvironmentVariables(IReadOnlyCollection<KeyValuePair<string, string>> environmentVariables)
+        {
+            _ = environmentVariables ?? throw new ArgumentNullException(nameof(environmentVariables));
+
+            if (environmentVariables.Count == 0)
+            {
+                return this;
+            }
+
+            return new ChildProcessCreationContext(
+                EnvironmentVariableListCreation.MergeExtraEnvVarsWithContext(EnvironmentVariablesInternal, environmentVariables));
+        }
+
         private static ReadOnlyMemory<KeyValuePair<string, string>> SortAndValidate(
             IReadOnlyCollection<KeyValuePair<string, string>> environmentVariables)
         {
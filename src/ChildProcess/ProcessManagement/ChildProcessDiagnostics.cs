@@ -0,0 +1,158 @@
+// Copyright (c) @asmichi (https://github.com/asmichi). Licensed under the MIT License. See LICENCE in the project root for details.
+
+using System;
+using System.Collections.Generic;
+using System.ComponentModel;
+using System.IO;
+
+namespace Asmichi.ProcessManagement
+{
+    /// <summary>
+    /// Provides diagnostic information about the machinery that creates child processes.
+    /// </summary>
+    public static class ChildProcessDiagnostics
+    {
+        /// <summary>
+        /// (Non-Windows-specific) Gets the counters and gauges of the helper process that creates and reaps child processes.
+        /// Useful for detecting saturation of the helper process.
+        /// </summary>
+        /// <returns>A snapshot of the statistics.</returns>
+        /// <remarks>
+        /// The values are updated concurrently and are not necessarily consistent with each other.
+        /// </remarks>
+        /// <exception cref="PlatformNotSupportedException">There is no helper process on this platform (Windows).</exception>
+        /// <exception cref="AsmichiChildProcessLibraryCrashedException">The operation failed due to critical disturbance.</exception>
+        /// <exception cref="Win32Exception">Another kind of native errors.</exception>
+        public static ChildProcessHelperStatistics GetHelperStatistics() => ChildProcessHelper.Shared.GetHelperStatistics();
+
+        /// <summary>
+        /// (Non-Windows-specific) Writes the recent spawn/reap lifecycle events recorded by the helper process to <paramref name="destination"/>
+        /// in the Chrome trace event format (JSON), which can be opened with chrome://tracing or Perfetto.
+        /// </summary>
+        /// <param name="destination">The stream to write the trace to.</param>
+        /// <remarks>
+        /// The helper process keeps the latest 4096 events per thread.
+        /// Sending SIGUSR1 to the helper process writes the same trace to <c>${TMPDIR:-/tmp}/AsmichiChildProcessHelper.&lt;pid&gt;.&lt;n&gt;.trace.json</c>.
+        /// </remarks>
+        /// <exception cref="ArgumentNullException"><paramref name="destination"/> is null.</exception>
+        /// <exception cref="PlatformNotSupportedException">There is no helper process on this platform (Windows).</exception>
+        /// <exception cref="AsmichiChildProcessLibraryCrashedException">The operation failed due to critical disturbance.</exception>
+        /// <exception cref="Win32Exception">Another kind of native errors.</exception>
+        public static void WriteHelperTrace(Stream destination)
+        {
+            if (destination is null)
+            {
+                throw new ArgumentNullException(nameof(destination));
+            }
+
+            ChildProcessHelper.Shared.WriteHelperTrace(destination);
+        }
+    }
+
+    /// <summary>
+    /// Counters and gauges of the helper process. See <see cref="ChildProcessDiagnostics.GetHelperStatistics"/>.
+    /// </summary>
+    public sealed class ChildProcessHelperStatistics
+    {
+        internal ChildProcessHelperStatistics(
+            long spawnCount,
+            long spawnFailureCount,
+            long liveChildCount,
+            long subchannelCount,
+            long pendingNotificationBytes,
+            long notificationQueueDepth,
+            long maxNotificationBatchSize,
+            long reapCount,
+            long orphanReapCount,
+            IReadOnlyList<long> spawnLatencyHistogram,
+            IReadOnlyList<long> reapBatchSizeHistogram,
+            IReadOnlyDictionary<int, long> spawnFailuresByErrorCode)
+        {
+            SpawnCount = spawnCount;
+            SpawnFailureCount = spawnFailureCount;
+            LiveChildCount = liveChildCount;
+            SubchannelCount = subchannelCount;
+            PendingNotificationBytes = pendingNotificationBytes;
+            NotificationQueueDepth = notificationQueueDepth;
+            MaxNotificationBatchSize = maxNotificationBatchSize;
+            ReapCount = reapCount;
+            OrphanReapCount = orphanReapCount;
+            SpawnLatencyHistogram = spawnLatencyHistogram;
+            ReapBatchSizeHistogram = reapBatchSizeHistogram;
+            SpawnFailuresByErrorCode = spawnFailuresByErrorCode;
+        }
+
+        /// <summary>
+        /// The number of child processes successfully created.
+        /// </summary>
+        public long SpawnCount { get; }
+
+        /// <summary>
+        /// The number of child processes that failed to be created (for example, exec failed).
+        /// </summary>
+        public long SpawnFailureCount { get; }
+
+        /// <summary>
+        /// The number of child processes that have not been reaped yet.
+        /// </summary>
+        public long LiveChildCount { get; }
+
+        /// <summary>
+        /// The number of connections (subchannels) to the helper process.
+        /// </summary>
+        public long SubchannelCount { get; }
+
+        /// <summary>
+        /// The number of bytes of exit notifications that the helper process has not been able to send to this process yet.
+        /// A large value indicates that this process is not keeping up with exit notifications.
+        /// </summary>
+        public long PendingNotificationBytes { get; }
+
+        /// <summary>
+        /// The number of internal notifications (such as SIGCHLD) queued to the main thread of the helper process.
+        /// </summary>
+        public long NotificationQueueDepth { get; }
+
+        /// <summary>
+        /// The largest number of internal notifications processed at once by the main thread of the helper process.
+        /// </summary>
+        public long MaxNotificationBatchSize { get; }
+
+        /// <summary>
+        /// The number of processes reaped, including ones counted in <see cref="OrphanReapCount"/>.
+        /// </summary>
+        public long ReapCount { get; }
+
+        /// <summary>
+        /// The number of orphaned descendants adopted and reaped in the subreaper mode.
+        /// </summary>
+        public long OrphanReapCount { get; }
+
+        /// <summary>
+        /// <para>
+        /// The histogram of the time taken to create a child process (from fork to the result of exec).
+        /// </para>
+        /// <para>
+        /// The element at index i (&gt; 0) counts durations in [2^i, 2^(i+1)) microseconds.
+        /// The element at index 0 counts durations less than 2 microseconds. The last element has no upper bound.
+        /// </para>
+        /// </summary>
+        public IReadOnlyList<long> SpawnLatencyHistogram { get; }
+
+        /// <summary>
+        /// <para>
+        /// The histogram of the number of processes reaped at once.
+        /// </para>
+        /// <para>
+        /// The element at index i counts batches of [2^i, 2^(i+1)) processes. The last element has no upper bound.
+        /// </para>
+        /// </summary>
+        public IReadOnlyList<long> ReapBatchSizeHistogram { get; }
+
+        /// <summary>
+        /// The number of failures to create a child process, by error code (errno).
+        /// Error codes too large to track are counted as 0.
+        /// </summary>
+        public IReadOnlyDictionary<int, long> SpawnFailuresByErrorCode { get; }
+    }
+}
@@ -1,6 +1,7 @@
 // Copyright (c) @asmichi (https://github.com/asmichi). Licensed under the MIT License. See LICENCE in the project root for details.
 
 using System;
+using System.Buffers;
 using System.IO;
 using System.Runtime.InteropServices;
 using System.Threading;
@@ -22,18 +23,24 @@ namespace Asmichi.ProcessManagement
         private readonly Stream? _standardInput;
         private readonly Stream? _standardOutput;
         private readonly Stream? _standardError;
+        private readonly MemoryCapturedOutput? _capturedOutput;
+        private readonly MemoryCapturedOutput? _capturedError;
         private bool _isDisposed;
 
         internal ChildProcessImpl(
             IChildProcessStateHolder childProcessStateHolder,
             Stream? standardInput,
             Stream? standardOutput,
-            Stream? standardError)
+            Stream? standardError,
+            MemoryCapturedOutput? capturedOutput,
+            MemoryCapturedOutput? capturedError)
         {
             _stateHolder = childProcessStateHolder;
             _standardInput = standardInput;
             _standardOutput = standardOutput;
             _standardError = standardError;
+            _capturedOutput = capturedOutput;
+            _capturedError = capturedError;
         }
 
         /// <summary>
@@ -47,6 +54,8 @@ namespace Asmichi.ProcessManagement
                 _standardInput?.Dispose();
                 _standardOutput?.Dispose();
                 _standardError?.Dispose();
+                _capturedOutput?.Dispose();
+                _capturedError?.Dispose();
 
                 _isDisposed = true;
             }
@@ -60,6 +69,12 @@ namespace Asmichi.ProcessManagement
         public Stream StandardOutput => _standardOutput ?? throw new InvalidOperationException("No StandardOutput associated.");
         public Stream StandardError => _standardError ?? throw new InvalidOperationException("No StandardError associated.");
 
+        public IMemoryOwner<byte> GetCapturedStandardOutput() =>
+            GetCapturedContent(_capturedOutput ?? throw new InvalidOperationException("No captured StandardOutput associated."));
+
+        public IMemoryOwner<byte> GetCapturedStandardError() =>
+            GetCapturedContent(_capturedError ?? throw new InvalidOperationException("No captured StandardError associated."));
+
         /// <summary>
         /// (For tests.) Tests use this to wait for the child process without caching its status.
         /// </summary>
@@ -81,7 +96,7 @@ namespace Asmichi.ProcessManagement
                 return true;
             }
 
-            if (!state.ExitedWaitHandle.WaitOne(timeout))
+            if (!state.WaitForExit(timeout))
             {
                 return false;
             }
@@ -109,8 +124,7 @@ namespace Asmichi.ProcessManagement
             }
 
             // Synchronous path: the process has already exited.
-            var waitHandle = _stateHolder.State.ExitedWaitHandle;
-            if (waitHandle.WaitOne(0))
+            if (state.WaitForExit(TimeSpan.Zero))
             {
                 state.DangerousRetrieveExitCode();
                 return CompletedBoolTask.True;
@@ -123,8 +137,7 @@ namespace Asmichi.ProcessManagement
             }
 
             // Start an asynchronous wait operation.
-            var operation = WaitAsyncOperation.Start(waitHandle, timeout, cancellationToken);
-            return operation.Completion;
+            return state.WaitForExitAsync(timeout, cancellationToken);
         }
 
         public int Id
@@ -148,6 +161,15 @@ namespace Asmichi.ProcessManagement
             }
         }
 
+        public ChildProcessStartupTimings? StartupTimings
+        {
+            get
+            {
+                CheckNotDisposed();
+                return _stateHolder.State.StartupTimings;
+            }
+        }
+
         public bool HasHandle
         {
             get
@@ -207,6 +229,43 @@ namespace Asmichi.ProcessManagement
             _stateHolder.State.Kill();
         }
 
+        public void SendSignal(ChildProcessSignal signal)
+        {
+            if (!signal.IsValid())
+            {
+                throw new ArgumentOutOfRangeException(nameof(signal));
+            }
+
+            GetStateForSignal(signal).SendSignal(signal);
+        }
+
+        public void Suspend() => SendSignal(ChildProcessSignal.Stop);
+
+        public void Resume() => SendSignal(ChildProcessSignal.Continue);
+
+        /// <summary>
+        /// Validates that <paramref name="signal"/> can be sent and returns the state.
+        /// </summary>
+        internal IChildProcessState GetStateForSignal(ChildProcessSignal signal)
+        {
+            CheckNotDisposed();
+            if (signal != ChildProcessSignal.Kill)
+            {
+                CheckCanSignal();
+            }
+
+            return _stateHolder.State;
+        }
+
+        /// <summary>
+        /// Invokes <paramref name="callback"/> once when the process exits. See <see cref="IChildProcessState.RegisterExitedCallback"/>.
+        /// </summary>
+        internal void RegisterExitedCallback(Action<object?> callback, object? state)
+        {
+            CheckNotDisposed();
+            _stateHolder.State.RegisterExitedCallback(callback, state);
+        }
+
         private void CheckNotDisposed()
         {
             if (_isDisposed)
@@ -223,6 +282,18 @@ namespace Asmichi.ProcessManagement
             }
         }
 
+        private IMemoryOwner<byte> GetCapturedContent(MemoryCapturedOutput captured)
+        {
+            CheckNotDisposed();
+
+            if (!WaitForExit(TimeSpan.Zero))
+            {
+                throw new InvalidOperationException("The process has not exited. Call WaitForExit before accessing the captured output.");
+            }
+
+            return captured.GetContent();
+        }
+
         private void RetrieveExitCode()
         {
             if (!_stateHolder.State.HasExitCode)
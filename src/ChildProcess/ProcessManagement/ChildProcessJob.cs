@@ -0,0 +1,187 @@
+// Copyright (c) @asmichi (https://github.com/asmichi). Licensed under the MIT License. See LICENCE in the project root for details.
+
+using System;
+using System.ComponentModel;
+using System.Threading;
+
+namespace Asmichi.ProcessManagement
+{
+    /// <summary>
+    /// Specifies how a <see cref="ChildProcessJob"/> is created.
+    /// </summary>
+    [Flags]
+    public enum ChildProcessJobFlags
+    {
+        /// <summary>
+        /// Specifies that no options are set.
+        /// </summary>
+        None = 0,
+
+        /// <summary>
+        /// Specifies that all the live members of the job should be forcibly killed when the job is disposed
+        /// (including the death of this process).
+        /// </summary>
+        KillOnClose = 0x0001,
+    }
+
+    /// <summary>
+    /// Resource usage of the members of a <see cref="ChildProcessJob"/>.
+    /// </summary>
+    public sealed class ChildProcessJobStatistics
+    {
+        internal ChildProcessJobStatistics(
+            int activeProcessCount,
+            int totalProcessCount,
+            TimeSpan totalUserProcessorTime,
+            TimeSpan totalPrivilegedProcessorTime,
+            long peakResidentSetSize)
+        {
+            ActiveProcessCount = activeProcessCount;
+            TotalProcessCount = totalProcessCount;
+            TotalUserProcessorTime = totalUserProcessorTime;
+            TotalPrivilegedProcessorTime = totalPrivilegedProcessorTime;
+            PeakResidentSetSize = peakResidentSetSize;
+        }
+
+        /// <summary>
+        /// The number of the members that have not been reaped yet.
+        /// </summary>
+        public int ActiveProcessCount { get; }
+
+        /// <summary>
+        /// The number of the processes that have ever joined the job.
+        /// </summary>
+        public int TotalProcessCount { get; }
+
+        /// <summary>
+        /// The user processor time consumed by the members that have exited (including their reaped descendants).
+        /// </summary>
+        public TimeSpan TotalUserProcessorTime { get; }
+
+        /// <summary>
+        /// The privileged (system) processor time consumed by the members that have exited (including their reaped descendants).
+        /// </summary>
+        public TimeSpan TotalPrivilegedProcessorTime { get; }
+
+        /// <summary>
+        /// The largest peak resident set size in bytes among the members that have exited.
+        /// </summary>
+        public long PeakResidentSetSize { get; }
+    }
+
+    /// <summary>
+    /// <para>
+    /// (Non-Windows-specific) Represents a group of child processes that can be signaled and accounted as a unit.
+    /// Specify a job in <see cref="ChildProcessStartInfo.Job"/> to make the child process join it.
+    /// </para>
+    /// <para>
+    /// All instance members are thread-safe.
+    /// </para>
+    /// </summary>
+    /// <remarks>
+    /// <para>
+    /// A job is a process group shared by its members. Signals to the job are sent to the whole process group
+    /// with one request to the helper process, hence also reach the grandchildren that stay in the process group
+    /// and do not race with the members spawning them.
+    /// </para>
+    /// <para>
+    /// The process group is created by the first member. If all the members have exited, the next member creates a new one.
+    /// </para>
+    /// </remarks>
+    public sealed class ChildProcessJob : IDisposable
+    {
+        private static long _prevToken;
+
+        private readonly long _token;
+        private int _isDisposed;
+
+        /// <summary>
+        /// Initializes a new instance of the <see cref="ChildProcessJob"/> class.
+        /// </summary>
+        /// <param name="flags"><see cref="ChildProcessJobFlags"/>.</param>
+        /// <exception cref="PlatformNotSupportedException">Jobs are not supported on this platform (Windows).</exception>
+        /// <exception cref="Win32Exception">Failed to create the job.</exception>
+        public ChildProcessJob(ChildProcessJobFlags flags = ChildProcessJobFlags.None)
+        {
+            _token = Interlocked.Increment(ref _prevToken);
+            Flags = flags;
+            ChildProcessHelper.Shared.CreateJob(_token, flags);
+        }
+
+        /// <summary>
+        /// The flags specified when the job was created.
+        /// </summary>
+        public ChildProcessJobFlags Flags { get; }
+
+        /// <summary>
+        /// (For the helper process) Identifies this job.
+        /// </summary>
+        internal long Token
+        {
+            get
+            {
+                CheckNotDisposed();
+                return _token;
+            }
+        }
+
+        /// <summary>
+        /// Closes the job. If <see cref="ChildProcessJobFlags.KillOnClose"/> is set, kills all the live members.
+        /// The members that have not been killed keep running.
+        /// </summary>
+        public void Dispose()
+        {
+            if (Interlocked.Exchange(ref _isDisposed, 1) == 0)
+            {
+                ChildProcessHelper.Shared.CloseJob(_token);
+            }
+        }
+
+        /// <summary>
+        /// Sends <paramref name="signal"/> to all the members of the job.
+        /// If there is no live member, does nothing.
+        /// </summary>
+        /// <param name="signal">The signal to send.</param>
+        /// <exception cref="ArgumentOutOfRangeException"><paramref name="signal"/> is not a valid value.</exception>
+        /// <exception cref="ObjectDisposedException">The job has been disposed.</exception>
+        /// <exception cref="Win32Exception">Failed to signal the members.</exception>
+        public void SendSignal(ChildProcessSignal signal)
+        {
+            if (!signal.IsValid())
+            {
+                throw new ArgumentOutOfRangeException(nameof(signal));
+            }
+
+            ChildProcessHelper.Shared.SignalJob(Token, signal);
+        }
+
+        /// <summary>
+        /// Suspends all the members of the job (SIGSTOP).
+        /// </summary>
+        /// <exception cref="ObjectDisposedException">The job has been disposed.</exception>
+        /// <exception cref="Win32Exception">Failed to signal the members.</exception>
+        public void Freeze() => SendSignal(ChildProcessSignal.Stop);
+
+        /// <summary>
+        /// Resumes all the members of the job (SIGCONT).
+        /// </summary>
+        /// <exception cref="ObjectDisposedException">The job has been disposed.</exception>
+        /// <exception cref="Win32Exception">Failed to signal the members.</exception>
+        public void Thaw() => SendSignal(ChildProcessSignal.Continue);
+
+        /// <summary>
+        /// Gets the resource usage of the members of the job.
+        /// </summary>
+        /// <returns>The resource usage.</returns>
+        /// <exception cref="ObjectDisposedException">The job has been disposed.</exception>
+        public ChildProcessJobStatistics GetStatistics() => ChildProcessHelper.Shared.GetJobStatistics(Token);
+
+        private void CheckNotDisposed()
+        {
+            if (Volatile.Read(ref _isDisposed) != 0)
+            {
+                throw new ObjectDisposedException(nameof(ChildProcessJob));
+            }
+        }
+    }
+}
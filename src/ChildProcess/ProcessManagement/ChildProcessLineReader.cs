@@ -0,0 +1,169 @@
+// Copyright (c) @asmichi (https://github.com/asmichi). Licensed under the MIT License. See LICENCE in the project root for details.
+
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Runtime.CompilerServices;
+using System.Threading;
+using System.Threading.Tasks;
+using Asmichi.Utilities;
+
+namespace Asmichi.ProcessManagement
+{
+    /// <summary>
+    /// Handles a line read by <see cref="ChildProcessLineReader"/>.
+    /// </summary>
+    /// <param name="line">The line excluding the line terminator. Valid only during the call.</param>
+    public delegate void ChildProcessLineHandler(ReadOnlySpan<byte> line);
+
+    /// <summary>
+    /// <para>
+    /// Reads lines from the output of a child process (typically <see cref="IChildProcess.StandardOutput"/>) as raw bytes
+    /// without decoding them or allocating an object per line.
+    /// </para>
+    /// <para>
+    /// Lines are terminated by LF or CRLF; the terminator is not included. The last line without a terminator is also read.
+    /// A line longer than the maximum line length is split into chunks of the maximum line length.
+    /// </para>
+    /// </summary>
+    /// <remarks>
+    /// Buffers are rented from <see cref="System.Buffers.ArrayPool{T}.Shared"/>. A line is only valid until the next line is requested.
+    /// Copy it if you need to keep it.
+    /// </remarks>
+    public static class ChildProcessLineReader
+    {
+        /// <summary>
+        /// The default size of the buffer.
+        /// </summary>
+        public const int DefaultBufferSize = 64 * 1024;
+
+        /// <summary>
+        /// The default maximum line length.
+        /// </summary>
+        public const int DefaultMaxLineLength = 1024 * 1024;
+
+        private const int MaxMaxLineLength = 1024 * 1024 * 1024;
+
+        /// <summary>
+        /// Reads all lines from <paramref name="stream"/> until EOF, invoking <paramref name="handler"/> for each line.
+        /// </summary>
+        /// <param name="stream">The stream to read from.</param>
+        /// <param name="handler">The handler invoked for each line.</param>
+        /// <param name="maxLineLength">The maximum line length in bytes.</param>
+        /// <exception cref="ArgumentNullException"><paramref name="stream"/> or <paramref name="handler"/> is null.</exception>
+        /// <exception cref="ArgumentOutOfRangeException"><paramref name="maxLineLength"/> is not positive or greater than 1 GiB.</exception>
+        public static void ReadLines(Stream stream, ChildProcessLineHandler handler, int maxLineLength = DefaultMaxLineLength)
+        {
+            ValidateArguments(stream, handler, maxLineLength);
+
+            using var splitter = new LineSplitter(DefaultBufferSize, maxLineLength);
+            while (!splitter.IsCompleted)
+            {
+                splitter.Advance(stream.Read(splitter.GetReadBuffer().Span));
+                DispatchLines(splitter, handler);
+            }
+        }
+
+        /// <summary>
+        /// Asynchronously reads all lines from <paramref name="stream"/> until EOF, invoking <paramref name="handler"/> for each line.
+        /// </summary>
+        /// <param name="stream">The stream to read from.</param>
+        /// <param name="handler">The handler invoked for each line.</param>
+        /// <param name="maxLineLength">The maximum line length in bytes.</param>
+        /// <param name="cancellationToken">A token to cancel reading.</param>
+        /// <returns>A task that completes when EOF is reached.</returns>
+        /// <exception cref="ArgumentNullException"><paramref name="stream"/> or <paramref name="handler"/> is null.</exception>
+        /// <exception cref="ArgumentOutOfRangeException"><paramref name="maxLineLength"/> is not positive or greater than 1 GiB.</exception>
+        public static Task ReadLinesAsync(
+            Stream stream,
+            ChildProcessLineHandler handler,
+            int maxLineLength = DefaultMaxLineLength,
+            CancellationToken cancellationToken = default)
+        {
+            ValidateArguments(stream, handler, maxLineLength);
+
+            return ReadLinesAsyncCore(stream, handler, maxLineLength, cancellationToken);
+        }
+
+        /// <summary>
+        /// Asynchronously enumerates lines from <paramref name="stream"/> until EOF.
+        /// Each line is valid only until the enumerator is advanced.
+        /// </summary>
+        /// <param name="stream">The stream to read from.</param>
+        /// <param name="maxLineLength">The maximum line length in bytes.</param>
+        /// <param name="cancellationToken">A token to cancel reading.</param>
+        /// <returns>The lines.</returns>
+        /// <exception cref="ArgumentNullException"><paramref name="stream"/> is null.</exception>
+        /// <exception cref="ArgumentOutOfRangeException"><paramref name="maxLineLength"/> is not positive or greater than 1 GiB.</exception>
+        public static IAsyncEnumerable<ReadOnlyMemory<byte>> EnumerateLinesAsync(
+            Stream stream,
+            int maxLineLength = DefaultMaxLineLength,
+            CancellationToken cancellationToken = default)
+        {
+            if (stream is null)
+            {
+                throw new ArgumentNullException(nameof(stream));
+            }
+            if (maxLineLength <= 0 || maxLineLength > MaxMaxLineLength)
+            {
+                throw new ArgumentOutOfRangeException(nameof(maxLineLength), "maxLineLength must be positive and at most 1 GiB.");
+            }
+
+            return EnumerateLinesAsyncCore(stream, maxLineLength, cancellationToken);
+        }
+
+        private static async Task ReadLinesAsyncCore(
+            Stream stream,
+            ChildProcessLineHandler handler,
+            int maxLineLength,
+            CancellationToken cancellationToken)
+        {
+            using var splitter = new LineSplitter(DefaultBufferSize, maxLineLength);
+            while (!splitter.IsCompleted)
+            {
+                splitter.Advance(await stream.ReadAsync(splitter.GetReadBuffer(), cancellationToken).ConfigureAwait(false));
+                DispatchLines(splitter, handler);
+            }
+        }
+
+        private static async IAsyncEnumerable<ReadOnlyMemory<byte>> EnumerateLinesAsyncCore(
+            Stream stream,
+            int maxLineLength,
+            [EnumeratorCancellation] CancellationToken cancellationToken)
+        {
+            using var splitter = new LineSplitter(DefaultBufferSize, maxLineLength);
+            while (!splitter.IsCompleted)
+            {
+                splitter.Advance(await stream.ReadAsync(splitter.GetReadBuffer(), cancellationToken).ConfigureAwait(false));
+                while (splitter.TryReadLine(out var line))
+                {
+                    yield return line;
+                }
+            }
+        }
+
+        private static void DispatchLines(LineSplitter splitter, ChildProcessLineHandler handler)
+        {
+            while (splitter.TryReadLine(out var line))
+            {
+                handler(line.Span);
+            }
+        }
+
+        private static void ValidateArguments(Stream stream, ChildProcessLineHandler handler, int maxLineLength)
+        {
+            if (stream is null)
+            {
+                throw new ArgumentNullException(nameof(stream));
+            }
+            if (handler is null)
+            {
+                throw new ArgumentNullException(nameof(handler));
+            }
+            if (maxLineLength <= 0 || maxLineLength > MaxMaxLineLength)
+            {
+                throw new ArgumentOutOfRangeException(nameof(maxLineLength), "maxLineLength must be positive and at most 1 GiB.");
+            }
+        }
+    }
+}
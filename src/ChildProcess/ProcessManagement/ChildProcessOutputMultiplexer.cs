@@ -0,0 +1,347 @@
+// Copyright (c) @asmichi (https://github.com/asmichi). Licensed under the MIT License. See LICENCE in the project root for details.
+
+using System;
+using System.Buffers;
+using System.ComponentModel;
+using System.IO;
+using System.IO.Pipes;
+using System.Threading;
+using System.Threading.Tasks;
+using Asmichi.PlatformAbstraction;
+
+namespace Asmichi.ProcessManagement
+{
+    /// <summary>
+    /// Identifies the stream that a <see cref="ChildProcessOutputChunk"/> came from.
+    /// </summary>
+    public enum ChildProcessOutputSource
+    {
+        /// <summary>
+        /// The stdout of the child process.
+        /// </summary>
+        StandardOutput = 0,
+
+        /// <summary>
+        /// The stderr of the child process.
+        /// </summary>
+        StandardError = 1,
+    }
+
+    /// <summary>
+    /// A chunk of output captured by <see cref="ChildProcessOutputMultiplexer"/>.
+    /// </summary>
+    public readonly ref struct ChildProcessOutputChunk
+    {
+        internal ChildProcessOutputChunk(long tag, ChildProcessOutputSource source, long timestamp, ReadOnlySpan<byte> data)
+        {
+            Tag = tag;
+            Source = source;
+            Timestamp = timestamp;
+            Data = data;
+        }
+
+        /// <summary>
+        /// The <see cref="ChildProcessStartInfo.OutputTag"/> of the child process.
+        /// </summary>
+        public long Tag { get; }
+
+        /// <summary>
+        /// The stream that the chunk came from.
+        /// </summary>
+        public ChildProcessOutputSource Source { get; }
+
+        /// <summary>
+        /// The raw timestamp (CLOCK_MONOTONIC of the helper process, in nanoseconds) when the chunk was read.
+        /// </summary>
+        public long Timestamp { get; }
+
+        /// <summary>
+        /// The data. Valid only during the call to <see cref="ChildProcessOutputChunkHandler"/>.
+        /// </summary>
+        public ReadOnlySpan<byte> Data { get; }
+
+        /// <summary>
+        /// Indicates that the stream has been closed. <see cref="Data"/> is empty.
+        /// </summary>
+        public bool IsEndOfStream => Data.IsEmpty;
+    }
+
+    /// <summary>
+    /// Handles a chunk read by <see cref="ChildProcessOutputMultiplexer"/>.
+    /// </summary>
+    /// <param name="chunk">The chunk.</param>
+    public delegate void ChildProcessOutputChunkHandler(ChildProcessOutputChunk chunk);
+
+    /// <summary>
+    /// <para>
+    /// (Non-Windows-specific) Captures stdout and stderr of many child processes into a single ordered stream of chunks,
+    /// each tagged with the child process (<see cref="ChildProcessStartInfo.OutputTag"/>), the stream it came from and a timestamp.
+    /// Specify <see cref="OutputRedirection.Multiplexer"/> and <see cref="ChildProcessStartInfo.OutputMultiplexer"/> to capture the output of a child process.
+    /// </para>
+    /// <para>
+    /// All instance members are thread-safe.
+    /// </para>
+    /// </summary>
+    /// <remarks>
+    /// <para>
+    /// The helper process reads the pipes of all the child processes with one thread and writes the chunks, in the order they were read,
+    /// to a single pipe (drained with <see cref="ReadChunksAsync(ChildProcessOutputChunkHandler, CancellationToken)"/>) or a file
+    /// (read later with <see cref="ReadChunks(Stream, ChildProcessOutputChunkHandler)"/>).
+    /// Hence there is no need for two readers per child process.
+    /// </para>
+    /// <para>
+    /// If the chunks are not drained, the child processes eventually block on writing to their stdout/stderr.
+    /// </para>
+    /// <para>
+    /// After <see cref="Complete"/>, the stream of chunks ends once all the captured streams have been closed.
+    /// </para>
+    /// </remarks>
+    public sealed class ChildProcessOutputMultiplexer : IDisposable
+    {
+        // NOTE: Make sure to sync with the helper (OutputFrameHeader, MaxOutputFrameDataLength).
+        private const int FrameHeaderSize = 24;
+        private const int MaxChunkLength = 64 * 1024;
+
+        // Holds multiple frames so that they are read in bulk.
+        private const int ReadBufferSize = 256 * 1024;
+
+        private static long _prevToken;
+
+        private readonly long _token;
+        private readonly Stream? _chunkStream;
+        private int _isCompleted;
+
+        /// <summary>
+        /// Initializes a new instance of the <see cref="ChildProcessOutputMultiplexer"/> class
+        /// whose chunks are read with <see cref="ReadChunksAsync(ChildProcessOutputChunkHandler, CancellationToken)"/>.
+        /// </summary>
+        /// <exception cref="PlatformNotSupportedException">Output multiplexers are not supported on this platform (Windows).</exception>
+        /// <exception cref="Win32Exception">Failed to create the multiplexer.</exception>
+        public ChildProcessOutputMultiplexer()
+        {
+            _token = Interlocked.Increment(ref _prevToken);
+
+            var (chunkStream, sinkPipe) = FilePal.CreatePipePairWithAsyncServerSide(PipeDirection.In);
+            try
+            {
+                using (sinkPipe)
+                {
+                    ChildProcessHelper.Shared.CreateOutputMultiplexer(_token, sinkPipe);
+                }
+            }
+            catch
+            {
+                chunkStream.Dispose();
+                throw;
+            }
+
+            _chunkStream = chunkStream;
+        }
+
+        /// <summary>
+        /// Initializes a new instance of the <see cref="ChildProcessOutputMultiplexer"/> class that writes the chunks to a file.
+        /// The existing content of the file will be truncated.
+        /// Read the file with <see cref="ReadChunks(Stream, ChildProcessOutputChunkHandler)"/>.
+        /// </summary>
+        /// <param name="path">The path to the file.</param>
+        /// <exception cref="ArgumentNullException"><paramref name="path"/> is null.</exception>
+        /// <exception cref="IOException">Failed to open the file.</exception>
+        /// <exception cref="PlatformNotSupportedException">Output multiplexers are not supported on this platform (Windows).</exception>
+        /// <exception cref="Win32Exception">Failed to create the multiplexer.</exception>
+        public ChildProcessOutputMultiplexer(string path)
+        {
+            _ = path ?? throw new ArgumentNullException(nameof(path));
+
+            _token = Interlocked.Increment(ref _prevToken);
+
+            // The helper process keeps its own duplicate of the fd.
+            using var fs = new FileStream(path, FileMode.Create, FileAccess.Write, FileShare.Read);
+            ChildProcessHelper.Shared.CreateOutputMultiplexer(_token, fs.SafeFileHandle);
+        }
+
+        /// <summary>
+        /// (For the helper process) Identifies this multiplexer.
+        /// </summary>
+        internal long Token
+        {
+            get
+            {
+                if (Volatile.Read(ref _isCompleted) != 0)
+                {
+                    throw new InvalidOperationException("The multiplexer has been completed.");
+                }
+                return _token;
+            }
+        }
+
+        /// <summary>
+        /// Completes the multiplexer (if not yet completed) and releases the pipe to read the chunks from.
+        /// </summary>
+        public void Dispose()
+        {
+            Complete();
+            _chunkStream?.Dispose();
+        }
+
+        /// <summary>
+        /// Declares that no more child processes will be started with this multiplexer.
+        /// The stream of chunks ends once all the captured streams have been closed.
+        /// </summary>
+        public void Complete()
+        {
+            if (Interlocked.Exchange(ref _isCompleted, 1) == 0)
+            {
+                ChildProcessHelper.Shared.CloseOutputMultiplexer(_token);
+            }
+        }
+
+        /// <summary>
+        /// Asynchronously reads the chunks until the stream of chunks ends (see <see cref="Complete"/>), invoking <paramref name="handler"/> for each chunk.
+        /// </summary>
+        /// <param name="handler">The handler invoked for each chunk.</param>
+        /// <param name="cancellationToken">A token to cancel reading.</param>
+        /// <returns>A task that completes when the stream of chunks ends.</returns>
+        /// <exception cref="ArgumentNullException"><paramref name="handler"/> is null.</exception>
+        /// <exception cref="InvalidOperationException">The multiplexer writes the chunks to a file.</exception>
+        public Task ReadChunksAsync(ChildProcessOutputChunkHandler handler, CancellationToken cancellationToken = default)
+        {
+            var chunkStream = _chunkStream ?? throw new InvalidOperationException("The multiplexer writes the chunks to a file.");
+            return ReadChunksAsync(chunkStream, handler, cancellationToken);
+        }
+
+        /// <summary>
+        /// Reads the chunks written by a <see cref="ChildProcessOutputMultiplexer"/> from <paramref name="stream"/> until EOF,
+        /// invoking <paramref name="handler"/> for each chunk.
+        /// </summary>
+        /// <param name="stream">The stream to read from (typically the file specified to <see cref="ChildProcessOutputMultiplexer(string)"/>).</param>
+        /// <param name="handler">The handler invoked for each chunk.</param>
+        /// <exception cref="ArgumentNullException"><paramref name="stream"/> or <paramref name="handler"/> is null.</exception>
+        /// <exception cref="InvalidDataException"><paramref name="stream"/> contains a malformed chunk.</exception>
+        public static void ReadChunks(Stream stream, ChildProcessOutputChunkHandler handler)
+        {
+            ValidateArguments(stream, handler);
+
+            var buffer = ArrayPool<byte>.Shared.Rent(ReadBufferSize);
+            try
+            {
+                int length = 0;
+                while (true)
+                {
+                    int bytesRead = stream.Read(buffer, length, buffer.Length - length);
+                    if (!ProcessReadBytes(buffer, ref length, bytesRead, handler))
+                    {
+                        return;
+                    }
+                }
+            }
+            finally
+            {
+                ArrayPool<byte>.Shared.Return(buffer);
+            }
+        }
+
+        /// <summary>
+        /// Asynchronously reads the chunks written by a <see cref="ChildProcessOutputMultiplexer"/> from <paramref name="stream"/> until EOF,
+        /// invoking <paramref name="handler"/> for each chunk.
+        /// </summary>
+        /// <param name="stream">The stream to read from.</param>
+        /// <param name="handler">The handler invoked for each chunk.</param>
+        /// <param name="cancellationToken">A token to cancel reading.</param>
+        /// <returns>A task that completes when EOF is reached.</returns>
+        /// <exception cref="ArgumentNullException"><paramref name="stream"/> or <paramref name="handler"/> is null.</exception>
+        public static Task ReadChunksAsync(Stream stream, ChildProcessOutputChunkHandler handler, CancellationToken cancellationToken = default)
+        {
+            ValidateArguments(stream, handler);
+
+            return ReadChunksAsyncCore(stream, handler, cancellationToken);
+        }
+
+        private static async Task ReadChunksAsyncCore(Stream stream, ChildProcessOutputChunkHandler handler, CancellationToken cancellationToken)
+        {
+            var buffer = ArrayPool<byte>.Shared.Rent(ReadBufferSize);
+            try
+            {
+                int length = 0;
+                while (true)
+                {
+                    int bytesRead = await stream.ReadAsync(buffer.AsMemory(length), cancellationToken).ConfigureAwait(false);
+                    if (!ProcessReadBytes(buffer, ref length, bytesRead, handler))
+                    {
+                        return;
+                    }
+                }
+            }
+            finally
+            {
+                ArrayPool<byte>.Shared.Return(buffer);
+            }
+        }
+
+        // Dispatches the complete frames in buffer[0..(length + bytesRead)) and moves the incomplete one to the front.
+        // Returns false on EOF.
+        private static bool ProcessReadBytes(byte[] buffer, ref int length, int bytesRead, ChildProcessOutputChunkHandler handler)
+        {
+            if (bytesRead == 0)
+            {
+                if (length != 0)
+                {
+                    throw new InvalidDataException("The stream of chunks ended in the middle of a chunk.");
+                }
+                return false;
+            }
+
+            length += bytesRead;
+
+            int consumed = DispatchChunks(buffer.AsSpan(0, length), handler);
+
+            // The rest is shorter than a frame, hence the buffer always has room for the next read.
+            Buffer.BlockCopy(buffer, consumed, buffer, 0, length - consumed);
+            length -= consumed;
+            return true;
+        }
+
+        // NOTE: Make sure to sync with the helper. See Protocol.md.
+        private static int DispatchChunks(ReadOnlySpan<byte> data, ChildProcessOutputChunkHandler handler)
+        {
+            int consumed = 0;
+            while (data.Length - consumed >= FrameHeaderSize)
+            {
+                var header = data.Slice(consumed, FrameHeaderSize);
+                var chunkLength = BitConverter.ToUInt32(header.Slice(16));
+                var source = (ChildProcessOutputSource)BitConverter.ToUInt32(header.Slice(20));
+                if (chunkLength > MaxChunkLength
+                    || (source != ChildProcessOutputSource.StandardOutput && source != ChildProcessOutputSource.StandardError))
+                {
+                    throw new InvalidDataException("Malformed chunk.");
+                }
+
+                if (data.Length - consumed - FrameHeaderSize < chunkLength)
+                {
+                    break;
+                }
+
+                handler(new ChildProcessOutputChunk(
+                    tag: BitConverter.ToInt64(header),
+                    source: source,
+                    timestamp: BitConverter.ToInt64(header.Slice(8)),
+                    data: data.Slice(consumed + FrameHeaderSize, (int)chunkLength)));
+
+                consumed += FrameHeaderSize + (int)chunkLength;
+            }
+
+            return consumed;
+        }
+
+        private static void ValidateArguments(Stream stream, ChildProcessOutputChunkHandler handler)
+        {
+            if (stream is null)
+            {
+                throw new ArgumentNullException(nameof(stream));
+            }
+            if (handler is null)
+            {
+                throw new ArgumentNullException(nameof(handler));
+            }
+        }
+    }
+}
@@ -0,0 +1,186 @@
+// Copyright (c) @asmichi (https://github.com/asmichi). Licensed under the MIT License. See LICENCE in the project root for details.
+
+using System;
+using System.Threading;
+using System.Threading.Channels;
+using System.Threading.Tasks;
+
+namespace Asmichi.ProcessManagement
+{
+    /// <summary>
+    /// <para>
+    /// Delivers child processes in the order they exit.
+    /// Use this instead of <see cref="Task.WhenAny(Task[])"/> over many <see cref="IChildProcess.WaitForExitAsync(CancellationToken)"/> tasks,
+    /// which costs O(n) per round.
+    /// </para>
+    /// <para>
+    /// All members are thread-safe.
+    /// </para>
+    /// </summary>
+    /// <remarks>
+    /// <para>
+    /// Each child process is enqueued directly when its exit is notified; taking the next exited child process costs O(1).
+    /// </para>
+    /// <para>
+    /// The set does not own the child processes. Do not dispose a child process until it has been delivered;
+    /// otherwise it will never be delivered (and <see cref="Exited"/> will never complete).
+    /// </para>
+    /// </remarks>
+    public sealed class ChildProcessSet
+    {
+        private static readonly Action<object?> CachedOnExitedDelegate = OnExited;
+
+        private readonly object _lock = new object();
+        private readonly Channel<IChildProcess> _exited = Channel.CreateUnbounded<IChildProcess>(
+            new UnboundedChannelOptions
+            {
+                SingleReader = false,
+                SingleWriter = false,
+                // Do not run the continuations of readers on the thread processing notifications.
+                AllowSynchronousContinuations = false,
+            });
+        private int _pendingCount;
+        private bool _isCompleted;
+
+        /// <summary>
+        /// The child processes that have exited, in the order they exited.
+        /// The reader completes after <see cref="Complete"/> is called and all the added child processes have been read.
+        /// </summary>
+        public ChannelReader<IChildProcess> Exited => _exited.Reader;
+
+        /// <summary>
+        /// The number of the added child processes that have not exited yet.
+        /// </summary>
+        public int PendingCount
+        {
+            get
+            {
+                lock (_lock)
+                {
+                    return _pendingCount;
+                }
+            }
+        }
+
+        /// <summary>
+        /// Adds a child process. It will be written to <see cref="Exited"/> when it exits (immediately if it already has).
+        /// </summary>
+        /// <param name="process">The child process.</param>
+        /// <exception cref="ArgumentNullException"><paramref name="process"/> is null.</exception>
+        /// <exception cref="InvalidOperationException"><see cref="Complete"/> has been called.</exception>
+        /// <exception cref="ObjectDisposedException"><paramref name="process"/> has been disposed.</exception>
+        public void Add(IChildProcess process)
+        {
+            _ = process ?? throw new ArgumentNullException(nameof(process));
+
+            lock (_lock)
+            {
+                if (_isCompleted)
+                {
+                    throw new InvalidOperationException("The set has been completed.");
+                }
+
+                _pendingCount++;
+            }
+
+            var entry = new Entry(this, process);
+            try
+            {
+                if (process is ChildProcessImpl impl)
+                {
+                    impl.RegisterExitedCallback(CachedOnExitedDelegate, entry);
+                }
+                else
+                {
+                    // Not created by us; fall back to the individual method.
+                    process.WaitForExitAsync().ContinueWith(
+                        (_, s) => OnExited(s), entry, CancellationToken.None, TaskContinuationOptions.ExecuteSynchronously, TaskScheduler.Default);
+                }
+            }
+            catch
+            {
+                Exit(null);
+                throw;
+            }
+        }
+
+        /// <summary>
+        /// Declares that no more child processes will be added.
+        /// <see cref="Exited"/> completes after all the added child processes have been read.
+        /// </summary>
+        public void Complete()
+        {
+            lock (_lock)
+            {
+                _isCompleted = true;
+                if (_pendingCount == 0)
+                {
+                    _exited.Writer.TryComplete();
+                }
+            }
+        }
+
+        /// <summary>
+        /// Asynchronously waits for the next child process to exit and takes it from <see cref="Exited"/>.
+        /// </summary>
+        /// <param name="cancellationToken">A token to cancel waiting.</param>
+        /// <returns>The child process that has exited.</returns>
+        /// <exception cref="ChannelClosedException"><see cref="Complete"/> has been called and all the added child processes have been read.</exception>
+        public ValueTask<IChildProcess> WhenAnyExitedAsync(CancellationToken cancellationToken = default) =>
+            _exited.Reader.ReadAsync(cancellationToken);
+
+        /// <summary>
+        /// Completes the set and asynchronously waits for all the added child processes to exit, discarding them from <see cref="Exited"/>.
+        /// </summary>
+        /// <param name="cancellationToken">A token to cancel waiting.</param>
+        /// <returns>A task that completes when all the added child processes have exited.</returns>
+        public async Task WhenAllExitedAsync(CancellationToken cancellationToken = default)
+        {
+            Complete();
+
+            var reader = _exited.Reader;
+            while (await reader.WaitToReadAsync(cancellationToken).ConfigureAwait(false))
+            {
+                while (reader.TryRead(out _))
+                {
+                }
+            }
+        }
+
+        private static void OnExited(object? state)
+        {
+            var entry = (Entry)state!;
+            entry.Parent.Exit(entry.Process);
+        }
+
+        private void Exit(IChildProcess? process)
+        {
+            lock (_lock)
+            {
+                if (process is not null)
+                {
+                    // Never fails for an unbounded channel not completed yet.
+                    _exited.Writer.TryWrite(process);
+                }
+
+                _pendingCount--;
+                if (_isCompleted && _pendingCount == 0)
+                {
+                    _exited.Writer.TryComplete();
+                }
+            }
+        }
+
+        private sealed class Entry
+        {
+            public Entry(ChildProcessSet parent, IChildProcess process)
+            {
+                Parent = parent;
+                Process = process;
+            }
+
+            public ChildProcessSet Parent { get; }
+            public IChildProcess Process { get; }
+        }
+    }
+}
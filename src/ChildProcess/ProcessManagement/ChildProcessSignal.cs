@@ -0,0 +1,58 @@
+// Copyright (c) @asmichi (https://github.com/asmichi). Licensed under the MIT License. See LICENCE in the project root for details.
+
+namespace Asmichi.ProcessManagement
+{
+    /// <summary>
+    /// Specifies a signal to send to child processes.
+    /// </summary>
+    /// <remarks>
+    /// On Windows, only <see cref="Interrupt"/>, <see cref="Termination"/> and <see cref="Kill"/> are supported.
+    /// </remarks>
+    public enum ChildProcessSignal
+    {
+        /// <summary>
+        /// The interrupt signal. See <see cref="IChildProcess.SignalInterrupt"/>.
+        /// </summary>
+        Interrupt = 0,
+
+        /// <summary>
+        /// The termination signal. See <see cref="IChildProcess.SignalTermination"/>.
+        /// </summary>
+        Termination = 1,
+
+        /// <summary>
+        /// Forcibly kills the process. See <see cref="IChildProcess.Kill"/>.
+        /// </summary>
+        Kill = 2,
+
+        /// <summary>
+        /// (Non-Windows-specific) SIGHUP. Conventionally asks a daemon to reload its configuration.
+        /// </summary>
+        Hangup = 3,
+
+        /// <summary>
+        /// (Non-Windows-specific) SIGUSR1.
+        /// </summary>
+        User1 = 4,
+
+        /// <summary>
+        /// (Non-Windows-specific) SIGUSR2.
+        /// </summary>
+        User2 = 5,
+
+        /// <summary>
+        /// (Non-Windows-specific) SIGSTOP. Suspends the process. See <see cref="IChildProcess.Suspend"/>.
+        /// </summary>
+        Stop = 6,
+
+        /// <summary>
+        /// (Non-Windows-specific) SIGCONT. Resumes the process. See <see cref="IChildProcess.Resume"/>.
+        /// </summary>
+        Continue = 7,
+    }
+
+    internal static class ChildProcessSignalExtensions
+    {
+        public static bool IsValid(this ChildProcessSignal signal) => signal >= ChildProcessSignal.Interrupt && signal <= ChildProcessSignal.Continue;
+    }
+}
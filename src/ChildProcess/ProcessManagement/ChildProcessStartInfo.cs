@@ -126,6 +126,28 @@ namespace Asmichi.ProcessManagement
         /// </para>
         /// </remarks>
         DisableKillOnDispose = 0x0200,
+
+        /// <summary>
+        /// <para>
+        /// (Non-Windows-specific) Specifies that the child process should inherit only stdin, stdout, stderr and
+        /// <see cref="ChildProcessStartInfo.ExtraFileDescriptors"/>. All other file descriptors, including ones leaked
+        /// without FD_CLOEXEC by third-party code, will be closed before the child process executes the program.
+        /// </para>
+        /// <para>
+        /// On Windows, this flag has no effect since child processes only inherit handles explicitly specified.
+        /// </para>
+        /// </summary>
+        /// <remarks>
+        /// Leaked pipe fds delay EOF detection on the pipes. This is implemented with close_range(2) (or an enumeration of
+        /// /proc/self/fd) on Linux and POSIX_SPAWN_CLOEXEC_DEFAULT on macOS, hence cheap even when the fd table is large.
+        /// </remarks>
+        RestrictFileDescriptorInheritance = 0x0400,
+
+        /// <summary>
+        /// (Non-Windows-specific) Records the breakdown of the time taken to create the child process.
+        /// The result is available as <see cref="IChildProcess.StartupTimings"/>.
+        /// </summary>
+        ReportStartupTimings = 0x0800,
     }
 
     /// <summary>
@@ -143,6 +165,8 @@ namespace Asmichi.ProcessManagement
         public static bool HasEnableHandle(this ChildProcessFlags flags) => (flags & ChildProcessFlags.EnableHandle) != 0;
         public static bool HasCreateSuspended(this ChildProcessFlags flags) => (flags & ChildProcessFlags.CreateSuspended) != 0;
         public static bool HasDisableKillOnDispose(this ChildProcessFlags flags) => (flags & ChildProcessFlags.DisableKillOnDispose) != 0;
+        public static bool HasRestrictFileDescriptorInheritance(this ChildProcessFlags flags) => (flags & ChildProcessFlags.RestrictFileDescriptorInheritance) != 0;
+        public static bool HasReportStartupTimings(this ChildProcessFlags flags) => (flags & ChildProcessFlags.ReportStartupTimings) != 0;
     }
 
     /// <summary>
@@ -178,6 +202,18 @@ namespace Asmichi.ProcessManagement
         /// Redirected to the null device: NUL on Windows, /dev/null on *nix.
         /// </summary>
         NullDevice,
+
+        /// <summary>
+        /// <para>
+        /// Redirected to an anonymous read-only file that has the content of <see cref="ChildProcessStartInfo.StdInputBytes"/>.
+        /// The child process reads it as a regular (seekable) file; no pipe needs to be written to.
+        /// </para>
+        /// <para>
+        /// The file is a sealed memfd on Linux and an unlinked temporary file elsewhere.
+        /// The content is copied to the file when the child process is created.
+        /// </para>
+        /// </summary>
+        Bytes,
     }
 
     /// <summary>
@@ -235,6 +271,39 @@ namespace Asmichi.ProcessManagement
         /// Redirected to the null device: NUL on Windows, /dev/null on *nix.
         /// </summary>
         NullDevice,
+
+        /// <summary>
+        /// (Non-Windows-specific) Captured by <see cref="ChildProcessStartInfo.OutputMultiplexer"/>, which must also be set.
+        /// Each chunk of the output is tagged with <see cref="ChildProcessStartInfo.OutputTag"/> and the stream it came from.
+        /// </summary>
+        Multiplexer,
+
+        /// <summary>
+        /// <para>
+        /// (Non-Windows-specific) Captured into an anonymous file backed by memory (a memfd on Linux).
+        /// After the child process has exited, the output can be read without being copied through
+        /// <see cref="IChildProcess.GetCapturedStandardOutput"/> or <see cref="IChildProcess.GetCapturedStandardError"/>.
+        /// </para>
+        /// <para>
+        /// The length of the output can be limited by <see cref="ChildProcessStartInfo.MemoryCaptureMaxLength"/>.
+        /// </para>
+        /// </summary>
+        MemoryCapture,
+
+        /// <summary>
+        /// <para>
+        /// (Non-Windows-specific) Copied by the helper process to the pipe that can be read via <see cref="IChildProcess.StandardOutput"/>
+        /// (for stdout) or <see cref="IChildProcess.StandardError"/> (for stderr) and, at the same time, to each of
+        /// <see cref="ChildProcessStartInfo.StdOutputTeeSinks"/> or <see cref="ChildProcessStartInfo.StdErrorTeeSinks"/>.
+        /// </para>
+        /// <para>
+        /// The pipe is treated as a sink with <see cref="ChildProcessTeeBackpressure.Block"/>; close the stream to stop receiving the output.
+        /// </para>
+        /// </summary>
+        /// <remarks>
+        /// On Linux, the output is duplicated with tee(2) and splice(2) without being copied into the helper process.
+        /// </remarks>
+        Tee,
     }
 
     /// <summary>
@@ -381,6 +450,13 @@ namespace Asmichi.ProcessManagement
         /// </summary>
         public string? StdInputFile { get; set; }
 
+        /// <summary>
+        /// If <see cref="StdInputRedirection"/> is <see cref="InputRedirection.Bytes"/>,
+        /// specifies the content that the child process reads from its stdin.
+        /// Otherwise not used.
+        /// </summary>
+        public ReadOnlyMemory<byte> StdInputBytes { get; set; }
+
         /// <summary>
         /// If <see cref="StdOutputRedirection"/> is <see cref="OutputRedirection.File"/> or <see cref="OutputRedirection.AppendToFile"/>,
         /// specifies the file where the stdout of the child process is redirected.
@@ -416,6 +492,101 @@ namespace Asmichi.ProcessManagement
         /// </summary>
         public SafeHandle? StdErrorHandle { get; set; }
 
+        /// <summary>
+        /// <para>
+        /// (Non-Windows-specific) The list of the file descriptors that the child process should inherit
+        /// in addition to stdin, stdout and stderr. The default value is <see cref="Array.Empty"/>.
+        /// </para>
+        /// <para>
+        /// The handle specified by the value of an entry will be duplicated to the file descriptor number specified by the key of that entry.
+        /// Keys must be unique and greater than 2. At most 64 entries can be specified.
+        /// </para>
+        /// </summary>
+        /// <remarks>
+        /// Useful for passing pre-opened listening sockets or shared memory to the child process.
+        /// </remarks>
+        public IReadOnlyCollection<KeyValuePair<int, SafeHandle>> ExtraFileDescriptors { get; set; } = Array.Empty<KeyValuePair<int, SafeHandle>>();
+
+        /// <summary>
+        /// <para>
+        /// (Non-Windows-specific) The job that the child process should join. The default value is <see langword="null"/>.
+        /// </para>
+        /// <para>
+        /// Cannot be combined with <see cref="ChildProcessFlags.AttachToCurrentConsole"/>.
+        /// </para>
+        /// </summary>
+        /// <remarks>
+        /// The child process joins the process group of the job instead of creating its own one.
+        /// Signals sent to the child process itself still reach only the child process.
+        /// </remarks>
+        public ChildProcessJob? Job { get; set; }
+
+        /// <summary>
+        /// If <see cref="StdOutputRedirection"/> or <see cref="StdErrorRedirection"/> is <see cref="OutputRedirection.Multiplexer"/>,
+        /// specifies the multiplexer that captures the output.
+        /// Otherwise not used.
+        /// </summary>
+        public ChildProcessOutputMultiplexer? OutputMultiplexer { get; set; }
+
+        /// <summary>
+        /// If <see cref="OutputMultiplexer"/> is used, specifies the value that identifies the output of the child process
+        /// (<see cref="ChildProcessOutputChunk.Tag"/>). The default value is 0.
+        /// </summary>
+        public long OutputTag { get; set; }
+
+        /// <summary>
+        /// <para>
+        /// If <see cref="StdOutputRedirection"/> or <see cref="StdErrorRedirection"/> is <see cref="OutputRedirection.MemoryCapture"/>,
+        /// specifies the maximum length of each captured output in bytes. The default value is <see langword="null"/>, which means no limit
+        /// (other than <see cref="int.MaxValue"/>).
+        /// </para>
+        /// <para>
+        /// On Linux, writes beyond the limit fail in the child process (with EPERM). Elsewhere, the output is truncated to the limit.
+        /// </para>
+        /// </summary>
+        public int? MemoryCaptureMaxLength { get; set; }
+
+        /// <summary>
+        /// <para>
+        /// If not <see langword="null"/>, <see cref="IChildProcess.StandardOutput"/> and <see cref="IChildProcess.StandardError"/>
+        /// (<see cref="OutputRedirection.OutputPipe"/>, <see cref="OutputRedirection.ErrorPipe"/> and <see cref="OutputRedirection.Tee"/>)
+        /// are read eagerly so that the child process never blocks on a full pipe even if the consumer is slow.
+        /// The data read is kept in memory up to this number of bytes per stream, then spilled to a temporary file.
+        /// The default value is <see langword="null"/>, which means the pipe is read only when the consumer reads the stream.
+        /// </para>
+        /// <para>
+        /// Memory is allocated in chunks of 64 KiB; 0 means all the data goes through the temporary file.
+        /// </para>
+        /// </summary>
+        public int? OutputBufferMemoryBudget { get; set; }
+
+        /// <summary>
+        /// <para>
+        /// Specifies the buffer capacity in bytes of the pipes created for redirected stdin, stdout and stderr
+        /// (<see cref="InputRedirection.InputPipe"/>, <see cref="OutputRedirection.OutputPipe"/>, <see cref="OutputRedirection.ErrorPipe"/>,
+        /// <see cref="OutputRedirection.Multiplexer"/> and <see cref="OutputRedirection.Tee"/>).
+        /// The default value is <see langword="null"/>, which means the default of the operating system.
+        /// </para>
+        /// <para>
+        /// A larger buffer lets a child process that writes a lot run with fewer context switches.
+        /// The operating system may round or bound the value: on Linux, a pipe is bounded by /proc/sys/fs/pipe-max-size
+        /// and a unix socket (used for the pipes to the current process) by net.core.wmem_max.
+        /// </para>
+        /// </summary>
+        public int? StdioBufferSize { get; set; }
+
+        /// <summary>
+        /// If <see cref="StdOutputRedirection"/> is <see cref="OutputRedirection.Tee"/>, specifies the sinks that the stdout
+        /// of the child process is copied to (at most 7). Otherwise not used.
+        /// </summary>
+        public IReadOnlyList<ChildProcessTeeSink> StdOutputTeeSinks { get; set; } = Array.Empty<ChildProcessTeeSink>();
+
+        /// <summary>
+        /// If <see cref="StdErrorRedirection"/> is <see cref="OutputRedirection.Tee"/>, specifies the sinks that the stderr
+        /// of the child process is copied to (at most 7). Otherwise not used.
+        /// </summary>
+        public IReadOnlyList<ChildProcessTeeSink> StdErrorTeeSinks { get; set; } = Array.Empty<ChildProcessTeeSink>();
+
         /// <summary>
         /// Specifies the context that should be used to create the child process.
         /// </summary>
@@ -24,11 +24,21 @@ namespace Asmichi.ProcessManagement
         public readonly OutputRedirection StdOutputRedirection;
         public readonly OutputRedirection StdErrorRedirection;
         public readonly string? StdInputFile;
+        public readonly ReadOnlyMemory<byte> StdInputBytes;
         public readonly string? StdOutputFile;
         public readonly string? StdErrorFile;
         public readonly SafeHandle? StdInputHandle;
         public readonly SafeHandle? StdOutputHandle;
         public readonly SafeHandle? StdErrorHandle;
+        public readonly IReadOnlyCollection<KeyValuePair<int, SafeHandle>> ExtraFileDescriptors;
+        public readonly ChildProcessJob? Job;
+        public readonly ChildProcessOutputMultiplexer? OutputMultiplexer;
+        public readonly long OutputTag;
+        public readonly int? MemoryCaptureMaxLength;
+        public readonly IReadOnlyList<ChildProcessTeeSink> StdOutputTeeSinks;
+        public readonly IReadOnlyList<ChildProcessTeeSink> StdErrorTeeSinks;
+        public readonly int? OutputBufferMemoryBudget;
+        public readonly int? StdioBufferSize;
 
         /// <summary>
         /// Indicates whether <see cref="EnvironmentVariables"/> should be used.
@@ -41,6 +51,12 @@ namespace Asmichi.ProcessManagement
         /// </summary>
         public ReadOnlyMemory<KeyValuePair<string, string>> EnvironmentVariables;
 
+        /// <summary>
+        /// If <see cref="EnvironmentVariables"/> are the environment variables of a <see cref="ChildProcessCreationContext"/> as is, specifies the context.
+        /// The encoded environment variables can be cached per context.
+        /// </summary>
+        public ChildProcessCreationContext? EnvironmentVariablesContext;
+
         /// <summary>
         /// <para>Indicates whether a new pseudo console or a process group should be created.</para>
         /// <para>(Windows-specific) If the current process is not attached to a console, we automatically create a new pseudo console.</para>
@@ -61,11 +77,21 @@ namespace Asmichi.ProcessManagement
             StdOutputRedirection = startInfo.StdOutputRedirection;
             StdErrorRedirection = startInfo.StdErrorRedirection;
             StdInputFile = startInfo.StdInputFile;
+            StdInputBytes = startInfo.StdInputBytes;
             StdOutputFile = startInfo.StdOutputFile;
             StdErrorFile = startInfo.StdErrorFile;
             StdInputHandle = startInfo.StdInputHandle;
             StdOutputHandle = startInfo.StdOutputHandle;
             StdErrorHandle = startInfo.StdErrorHandle;
+            ExtraFileDescriptors = startInfo.ExtraFileDescriptors;
+            Job = startInfo.Job;
+            OutputMultiplexer = startInfo.OutputMultiplexer;
+            OutputTag = startInfo.OutputTag;
+            MemoryCaptureMaxLength = startInfo.MemoryCaptureMaxLength;
+            StdOutputTeeSinks = startInfo.StdOutputTeeSinks;
+            StdErrorTeeSinks = startInfo.StdErrorTeeSinks;
+            OutputBufferMemoryBudget = startInfo.OutputBufferMemoryBudget;
+            StdioBufferSize = startInfo.StdioBufferSize;
 
             if (!flags.HasDisableEnvironmentVariableInheritance()
                 && startInfo.CreationContext is null
@@ -73,10 +99,12 @@ namespace Asmichi.ProcessManagement
             {
                 UseCustomEnvironmentVariables = false;
                 EnvironmentVariables = default;
+                EnvironmentVariablesContext = null;
             }
             else
             {
                 UseCustomEnvironmentVariables = true;
+                EnvironmentVariablesContext = null;
 
                 if (flags.HasDisableEnvironmentVariableInheritance())
                 {
@@ -89,6 +117,10 @@ namespace Asmichi.ProcessManagement
                 else
                 {
                     EnvironmentVariables = MergeExtraEnvVarsWithContext(startInfo.CreationContext.EnvironmentVariablesInternal, startInfo.ExtraEnvironmentVariables);
+                    if (startInfo.ExtraEnvironmentVariables.Count == 0)
+                    {
+                        EnvironmentVariablesContext = startInfo.CreationContext;
+                    }
                 }
             }
 
@@ -0,0 +1,94 @@
+// Copyright (c) @asmichi (https://github.com/asmichi). Licensed under the MIT License. See LICENCE in the project root for details.
+
+using System;
+
+namespace Asmichi.ProcessManagement
+{
+    /// <summary>
+    /// <para>
+    /// The breakdown of the time taken to create a child process. See <see cref="ChildProcessFlags.ReportStartupTimings"/>.
+    /// </para>
+    /// <para>
+    /// The phases are contiguous: <see cref="Queueing"/> + <see cref="Fork"/> + <see cref="Release"/> + <see cref="Exec"/> = <see cref="Total"/>.
+    /// </para>
+    /// </summary>
+    /// <remarks>
+    /// The child process is considered started when it has performed exec.
+    /// The time taken by the dynamic loader and the initialization of the program itself comes after that and is not included.
+    /// </remarks>
+    public sealed class ChildProcessStartupTimings
+    {
+        internal ChildProcessStartupTimings(
+            TimeSpan total,
+            long requestReceivedTimestamp,
+            long forkReturnedTimestamp,
+            long childReleasedTimestamp,
+            long execConfirmedTimestamp)
+        {
+            RequestReceivedTimestamp = requestReceivedTimestamp;
+            ForkReturnedTimestamp = forkReturnedTimestamp;
+            ChildReleasedTimestamp = childReleasedTimestamp;
+            ExecConfirmedTimestamp = execConfirmedTimestamp;
+
+            Fork = FromNanoseconds(forkReturnedTimestamp - requestReceivedTimestamp);
+            Release = FromNanoseconds(childReleasedTimestamp - forkReturnedTimestamp);
+            Exec = FromNanoseconds(execConfirmedTimestamp - childReleasedTimestamp);
+
+            // The clock of the helper may be coarser than ours; do not let the phases exceed the total.
+            var helperTotal = Fork + Release + Exec;
+            Total = total > helperTotal ? total : helperTotal;
+            Queueing = Total - helperTotal;
+        }
+
+        /// <summary>
+        /// The time from the start of the request to the response from the helper process (that creates child processes).
+        /// </summary>
+        public TimeSpan Total { get; }
+
+        /// <summary>
+        /// The time spent outside the helper process: encoding the request, waiting for a connection to the helper process,
+        /// waiting for the helper process to receive the request and receiving the response.
+        /// </summary>
+        public TimeSpan Queueing { get; }
+
+        /// <summary>
+        /// The time from the helper process receiving the request to fork returning: parsing the request, preparing fds and fork.
+        /// </summary>
+        public TimeSpan Fork { get; }
+
+        /// <summary>
+        /// The time from fork returning to the helper process allowing the child process to perform exec (registering the child process).
+        /// Zero if the helper process uses vfork, where the child process performs exec immediately (the time is included in <see cref="Fork"/>).
+        /// </summary>
+        public TimeSpan Release { get; }
+
+        /// <summary>
+        /// The time from the child process being allowed to perform exec to the helper process confirming the result of exec:
+        /// setting up the child process (redirection, working directory, closing fds) and exec.
+        /// Zero if the helper process uses vfork (the time is included in <see cref="Fork"/>).
+        /// </summary>
+        public TimeSpan Exec { get; }
+
+        /// <summary>
+        /// The raw timestamp (CLOCK_MONOTONIC of the helper process, in nanoseconds) when the helper process received the request.
+        /// </summary>
+        public long RequestReceivedTimestamp { get; }
+
+        /// <summary>
+        /// The raw timestamp (CLOCK_MONOTONIC of the helper process, in nanoseconds) when fork returned.
+        /// </summary>
+        public long ForkReturnedTimestamp { get; }
+
+        /// <summary>
+        /// The raw timestamp (CLOCK_MONOTONIC of the helper process, in nanoseconds) when the child process was allowed to perform exec.
+        /// </summary>
+        public long ChildReleasedTimestamp { get; }
+
+        /// <summary>
+        /// The raw timestamp (CLOCK_MONOTONIC of the helper process, in nanoseconds) when the helper process confirmed the result of exec.
+        /// </summary>
+        public long ExecConfirmedTimestamp { get; }
+
+        private static TimeSpan FromNanoseconds(long nanoseconds) => TimeSpan.FromTicks(nanoseconds / 100);
+    }
+}
@@ -0,0 +1,83 @@
+// Copyright (c) @asmichi (https://github.com/asmichi). Licensed under the MIT License. See LICENCE in the project root for details.
+
+using System;
+using System.Runtime.InteropServices;
+
+namespace Asmichi.ProcessManagement
+{
+    /// <summary>
+    /// Specifies what the helper process does when a <see cref="ChildProcessTeeSink"/> cannot accept the output of a child process immediately.
+    /// </summary>
+    public enum ChildProcessTeeBackpressure
+    {
+        // NOTE: Make sure to sync with the helper.
+
+        /// <summary>
+        /// Waits until the sink accepts the output. While waiting, the output is not delivered to the other sinks either,
+        /// and the child process eventually blocks writing to its stdout/stderr.
+        /// </summary>
+        Block = 0,
+
+        /// <summary>
+        /// Discards the output that the sink cannot accept immediately.
+        /// </summary>
+        Drop = 1,
+
+        /// <summary>
+        /// Writes the output that the sink cannot accept immediately to <see cref="ChildProcessTeeSink.SpillHandle"/> instead.
+        /// </summary>
+        Spill = 2,
+    }
+
+    /// <summary>
+    /// (Non-Windows-specific) A destination that an output of a child process is copied to (<see cref="OutputRedirection.Tee"/>).
+    /// </summary>
+    public sealed class ChildProcessTeeSink
+    {
+        /// <summary>
+        /// Initializes a new instance of the <see cref="ChildProcessTeeSink"/> class.
+        /// </summary>
+        /// <param name="handle">The handle (a file, a pipe or a socket) that the output is written to.</param>
+        /// <param name="backpressure">What to do when <paramref name="handle"/> cannot accept the output immediately.</param>
+        /// <param name="spillHandle">
+        /// The handle that the output <paramref name="handle"/> cannot accept immediately is written to.
+        /// Required if <paramref name="backpressure"/> is <see cref="ChildProcessTeeBackpressure.Spill"/>; otherwise must be <see langword="null"/>.
+        /// </param>
+        /// <exception cref="ArgumentNullException"><paramref name="handle"/> is null.</exception>
+        /// <exception cref="ArgumentException"><paramref name="spillHandle"/> does not match <paramref name="backpressure"/>.</exception>
+        public ChildProcessTeeSink(SafeHandle handle, ChildProcessTeeBackpressure backpressure = ChildProcessTeeBackpressure.Block, SafeHandle? spillHandle = null)
+        {
+            if (backpressure != ChildProcessTeeBackpressure.Block
+                && backpressure != ChildProcessTeeBackpressure.Drop
+                && backpressure != ChildProcessTeeBackpressure.Spill)
+            {
+                throw new ArgumentOutOfRangeException(nameof(backpressure), "Not a valid value for " + nameof(ChildProcessTeeBackpressure) + ".");
+            }
+            if ((backpressure == ChildProcessTeeBackpressure.Spill) != (spillHandle is not null))
+            {
+                throw new ArgumentException(
+                    $"{nameof(spillHandle)} must be specified if and only if {nameof(backpressure)} is {nameof(ChildProcessTeeBackpressure.Spill)}.",
+                    nameof(spillHandle));
+            }
+
+            Handle = handle ?? throw new ArgumentNullException(nameof(handle));
+            Backpressure = backpressure;
+            SpillHandle = spillHandle;
+        }
+
+        /// <summary>
+        /// The handle that the output is written to.
+        /// </summary>
+        public SafeHandle Handle { get; }
+
+        /// <summary>
+        /// What to do when <see cref="Handle"/> cannot accept the output immediately.
+        /// </summary>
+        public ChildProcessTeeBackpressure Backpressure { get; }
+
+        /// <summary>
+        /// The handle that the output <see cref="Handle"/> cannot accept immediately is written to (<see cref="ChildProcessTeeBackpressure.Spill"/>).
+        /// </summary>
+        public SafeHandle? SpillHandle { get; }
+    }
+}
@@ -1,6 +1,7 @@
 // Copyright (c) @asmichi (https://github.com/asmichi). Licensed under the MIT License. See LICENCE in the project root for details.
 
 using System;
+using System.Buffers;
 using System.IO;
 using System.Runtime.InteropServices;
 using System.Threading;
@@ -79,6 +80,38 @@ namespace Asmichi.ProcessManagement
         /// </summary>
         Stream StandardError { get; }
 
+        /// <summary>
+        /// <para>
+        /// (Non-Windows-specific) Gets the stdout of the process captured with <see cref="OutputRedirection.MemoryCapture"/>.
+        /// The returned memory is mapped from the capture file without being copied.
+        /// Each call returns a new owner of the memory. The memory is valid until that owner is disposed, even after this instance has been disposed.
+        /// Dispose the owner when done with the memory; the mapping is released when this instance and all the owners have been disposed.
+        /// </para>
+        /// <para>
+        /// The content is determined on the first call; output written afterwards (for example, by a grandchild process) is not included.
+        /// </para>
+        /// </summary>
+        /// <returns>The owner of the captured output.</returns>
+        /// <exception cref="InvalidOperationException">The stdout was not redirected to <see cref="OutputRedirection.MemoryCapture"/>, or the process has not exited yet.</exception>
+        IMemoryOwner<byte> GetCapturedStandardOutput();
+
+        /// <summary>
+        /// (Non-Windows-specific) Gets the stderr of the process captured with <see cref="OutputRedirection.MemoryCapture"/>.
+        /// See <see cref="GetCapturedStandardOutput"/>.
+        /// </summary>
+        /// <returns>The owner of the captured output.</returns>
+        /// <exception cref="InvalidOperationException">The stderr was not redirected to <see cref="OutputRedirection.MemoryCapture"/>, or the process has not exited yet.</exception>
+        IMemoryOwner<byte> GetCapturedStandardError();
+
+        /// <summary>
+        /// (Non-Windows-specific) Gets the breakdown of the time taken to create the process
+        /// if <see cref="ChildProcessFlags.ReportStartupTimings"/> was specified; otherwise <see langword="null"/>.
+        /// </summary>
+        /// <remarks>
+        /// Always <see langword="null"/> on Windows.
+        /// </remarks>
+        ChildProcessStartupTimings? StartupTimings { get; }
+
         /// <summary>
         /// Gets a value indicating whether <see cref="Handle"/> can be read, that is,
         /// the process was created with <see cref="ChildProcessFlags.EnableHandle"/>.
@@ -183,5 +216,37 @@ namespace Asmichi.ProcessManagement
         /// (A new process group is created if and only if <see cref="ChildProcessFlags.AttachToCurrentConsole"/> is unset).</para>
         /// </summary>
         void Kill();
+
+        /// <summary>
+        /// <para>Sends the specified signal to the process group. Succeeds if the process has already exited.</para>
+        /// <para>
+        /// <see cref="ChildProcessSignal.Interrupt"/>, <see cref="ChildProcessSignal.Termination"/> and <see cref="ChildProcessSignal.Kill"/>
+        /// are equivalent to <see cref="SignalInterrupt"/>, <see cref="SignalTermination"/> and <see cref="Kill"/> respectively.
+        /// </para>
+        /// <para>(Windows-specific) Other signals are not supported.</para>
+        /// </summary>
+        /// <param name="signal">The signal to send.</param>
+        /// <exception cref="ArgumentOutOfRangeException"><paramref name="signal"/> is not a valid value.</exception>
+        /// <exception cref="InvalidOperationException">
+        /// <paramref name="signal"/> is not <see cref="ChildProcessSignal.Kill"/> and this instance does not support sending signals (<see cref="CanSignal"/> is <see langword="false"/>).
+        /// </exception>
+        /// <exception cref="PlatformNotSupportedException"><paramref name="signal"/> is not supported on this platform.</exception>
+        void SendSignal(ChildProcessSignal signal);
+
+        /// <summary>
+        /// (Non-Windows-specific) Suspends the process group by sending SIGSTOP. Succeeds if the process has already exited.
+        /// </summary>
+        /// <exception cref="InvalidOperationException">This instance does not support sending signals (<see cref="CanSignal"/> is <see langword="false"/>).</exception>
+        /// <exception cref="PlatformNotSupportedException">Not supported on this platform.</exception>
+        void Suspend();
+
+        /// <summary>
+        /// (Non-Windows-specific) Resumes the process group by sending SIGCONT. Succeeds if the process has already exited.
+        /// </summary>
+        /// <exception cref="InvalidOperationException">This instance does not support sending signals (<see cref="CanSignal"/> is <see langword="false"/>).</exception>
+        /// <exception cref="PlatformNotSupportedException">Not supported on this platform.</exception>
+#pragma warning disable CA1716 // Identifiers should not match keywords
+        void Resume();
+#pragma warning restore CA1716 // Identifiers should not match keywords
     }
 }
@@ -2,6 +2,7 @@
 
 using System;
 using System.Threading;
+using System.Threading.Tasks;
 using Asmichi.Interop.Windows;
 using Microsoft.Win32.SafeHandles;
 
@@ -30,9 +31,20 @@ namespace Asmichi.ProcessManagement
         WaitHandle ExitedWaitHandle { get; }
         bool HasExitCode { get; }
 
+        // Waits for the process to exit. Does not retrieve the exit code.
+        bool WaitForExit(TimeSpan timeout);
+        // Pre: The process has not exited and cancellationToken has not been canceled (the caller has already tried the synchronous paths).
+        Task<bool> WaitForExitAsync(TimeSpan timeout, CancellationToken cancellationToken);
+        // Invokes callback once when the process exits (synchronously if it already has). Never invoked if the state is disposed before that.
+        // callback must be cheap and must not throw; it may run on the thread processing notifications.
+        void RegisterExitedCallback(Action<object?> callback, object? state);
+
         // Pre: The process has exited
         void DangerousRetrieveExitCode();
 
+        // null unless ChildProcessFlags.ReportStartupTimings is specified (and supported).
+        ChildProcessStartupTimings? StartupTimings { get; }
+
         bool HasHandle { get; }
         SafeProcessHandle ProcessHandle { get; }
         SafeThreadHandle PrimaryThreadHandle { get; }
@@ -41,5 +53,6 @@ namespace Asmichi.ProcessManagement
         void SignalInterrupt();
         void SignalTermination();
         void Kill();
+        void SendSignal(ChildProcessSignal signal);
     }
 }
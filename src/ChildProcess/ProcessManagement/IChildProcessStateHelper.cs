@@ -1,6 +1,8 @@
 // Copyright (c) @asmichi (https://github.com/asmichi). Licensed under the MIT License. See LICENCE in the project root for details.
 
 using System;
+using System.Collections.Generic;
+using System.IO;
 using System.Runtime.InteropServices;
 
 namespace Asmichi.ProcessManagement
@@ -17,11 +19,35 @@ namespace Asmichi.ProcessManagement
         void ValidatePlatformSpecificStartInfo(
             in ChildProcessStartInfoInternal startInfo);
 
+        // Encodes the parts of the spawn request that do not change between spawns. The result is passed to SpawnProcess as preparedRequest.
+        object PrepareSpawnRequest(
+            in ChildProcessStartInfoInternal startInfo,
+            string resolvedPath);
+
+        // preparedRequest: The result of PrepareSpawnRequest for the same startInfo and resolvedPath, or null.
+        // stdOutTeeSinks, stdErrTeeSinks: (Non-Windows-specific) If not null, the helper process copies the output to these sinks (stdOut/stdErr are null).
         IChildProcessStateHolder SpawnProcess(
             ref ChildProcessStartInfoInternal startInfo,
             string resolvedPath,
+            object? preparedRequest,
             SafeHandle stdIn,
-            SafeHandle stdOut,
-            SafeHandle stdErr);
+            SafeHandle? stdOut,
+            SafeHandle? stdErr,
+            IReadOnlyList<ChildProcessTeeSink>? stdOutTeeSinks,
+            IReadOnlyList<ChildProcessTeeSink>? stdErrTeeSinks);
+
+        // Sends the signal to all the processes, even if sending to some of them fails.
+        void SignalAll(IReadOnlyList<IChildProcessState> states, ChildProcessSignal signal);
+
+        void CreateJob(long token, ChildProcessJobFlags flags);
+        void SignalJob(long token, ChildProcessSignal signal);
+        ChildProcessJobStatistics GetJobStatistics(long token);
+        void CloseJob(long token);
+
+        void CreateOutputMultiplexer(long token, SafeHandle sink);
+        void CloseOutputMultiplexer(long token);
+
+        ChildProcessHelperStatistics GetHelperStatistics();
+        void WriteHelperTrace(Stream destination);
     }
 }
@@ -0,0 +1,163 @@
+// Copyright (c) @asmichi (https://github.com/asmichi). Licensed under the MIT License. See LICENCE in the project root for details.
+
+using System;
+using System.Buffers;
+using System.ComponentModel;
+using System.Runtime.InteropServices;
+using System.Threading;
+using Asmichi.Interop.Linux;
+using Microsoft.Win32.SafeHandles;
+
+namespace Asmichi.ProcessManagement
+{
+    /// <summary>
+    /// (Non-Windows-specific) The file that an output of a child process is captured into (<see cref="OutputRedirection.MemoryCapture"/>).
+    /// After the child process has exited, the content is mapped into memory and exposed without being copied.
+    /// </summary>
+    /// <remarks>
+    /// The mapping is reference-counted: this instance and every <see cref="IMemoryOwner{T}"/> returned by <see cref="GetContent"/> hold a reference,
+    /// and the mapping is released when the last of them is disposed. Hence a memory never becomes unmapped while its owner is alive.
+    /// </remarks>
+    internal sealed class MemoryCapturedOutput : IDisposable
+    {
+        private readonly long _maxLength;
+        private CapturedFileMapping? _mapping;
+        private bool _isDisposed;
+
+        private MemoryCapturedOutput(SafeFileHandle fileHandle, long maxLength)
+        {
+            FileHandle = fileHandle;
+            _maxLength = maxLength;
+        }
+
+        /// <summary>
+        /// The handle that the child process should write to.
+        /// </summary>
+        public SafeFileHandle FileHandle { get; }
+
+        /// <summary>
+        /// Creates a file to capture an output into.
+        /// </summary>
+        /// <param name="maxLength">The maximum length of the output. <see langword="null"/> means no limit (other than <see cref="int.MaxValue"/>).</param>
+        /// <returns>The created instance.</returns>
+        public static MemoryCapturedOutput Create(int? maxLength)
+        {
+            var fd = LibChildProcess.CreateCaptureFile(maxLength ?? -1);
+            if (fd.IsInvalid)
+            {
+                throw new Win32Exception();
+            }
+
+            return new MemoryCapturedOutput(fd, maxLength ?? int.MaxValue);
+        }
+
+        public void Dispose()
+        {
+            if (!_isDisposed)
+            {
+                // Unmaps only if no owner is alive.
+                _mapping?.Dispose();
+                FileHandle.Dispose();
+                _isDisposed = true;
+            }
+        }
+
+        /// <summary>
+        /// Maps the content written so far (on the first call) and returns a new owner of it.
+        /// The content is valid until the returned owner is disposed, even after this instance has been disposed.
+        /// </summary>
+        /// <returns>The owner of the content.</returns>
+        public IMemoryOwner<byte> GetContent()
+        {
+            if (_isDisposed)
+            {
+                throw new ObjectDisposedException(nameof(MemoryCapturedOutput));
+            }
+
+            if (_mapping is null)
+            {
+                if (!LibChildProcess.MapCapturedFile(FileHandle, _maxLength, out var addr, out var len))
+                {
+                    throw new Win32Exception();
+                }
+
+                // len <= _maxLength <= int.MaxValue.
+                _mapping = new CapturedFileMapping(addr, (int)len);
+            }
+
+            return new CapturedMemoryOwner(_mapping);
+        }
+
+        /// <summary>
+        /// A mapping of a capture file. The address is null if the file is empty.
+        /// </summary>
+        private sealed class CapturedFileMapping : SafeHandle
+        {
+            public CapturedFileMapping(IntPtr addr, int length)
+                : base(IntPtr.Zero, true)
+            {
+                SetHandle(addr);
+                Length = length;
+            }
+
+            public int Length { get; }
+
+            public override bool IsInvalid => handle == IntPtr.Zero;
+
+            protected override bool ReleaseHandle() => LibChildProcess.UnmapCapturedFile(handle, (nuint)Length);
+        }
+
+        private sealed class CapturedMemoryOwner : MemoryManager<byte>
+        {
+            private readonly CapturedFileMapping _mapping;
+            private int _isDisposed;
+
+            public CapturedMemoryOwner(CapturedFileMapping mapping)
+            {
+                bool refAdded = false;
+                mapping.DangerousAddRef(ref refAdded);
+                _mapping = mapping;
+            }
+
+            public override unsafe Span<byte> GetSpan()
+            {
+                CheckNotDisposed();
+                return new Span<byte>((void*)_mapping.DangerousGetHandle(), _mapping.Length);
+            }
+
+            public override unsafe MemoryHandle Pin(int elementIndex = 0)
+            {
+                CheckNotDisposed();
+                if ((uint)elementIndex > (uint)_mapping.Length)
+                {
+                    throw new ArgumentOutOfRangeException(nameof(elementIndex));
+                }
+
+                // Mapped memory never moves.
+                return new MemoryHandle((byte*)_mapping.DangerousGetHandle() + elementIndex);
+            }
+
+            public override void Unpin()
+            {
+            }
+
+            // NOTE: No finalizer. A Span does not keep this instance alive, so a finalizer could unmap the memory under a Span in use (CA2015).
+            //       An owner that is never disposed keeps the mapping until the process exits.
+            protected override void Dispose(bool disposing)
+            {
+                if (disposing && Interlocked.Exchange(ref _isDisposed, 1) == 0)
+                {
+                    _mapping.DangerousRelease();
+                }
+            }
+
+            private void CheckNotDisposed()
+            {
+                if (Volatile.Read(ref _isDisposed) != 0)
+                {
+                    throw new ObjectDisposedException(nameof(IMemoryOwner<byte>));
+                }
+            }
+        }
+    }
+}
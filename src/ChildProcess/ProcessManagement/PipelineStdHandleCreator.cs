@@ -14,6 +14,9 @@ namespace Asmichi.ProcessManagement
     /// </summary>
     internal sealed class PipelineStdHandleCreator : IDisposable
     {
+        // NOTE: Make sure to sync with the helper (MaxTeeSinkCount). One is used for the pipe to us.
+        private const int MaxTeeSinkCount = 8;
+
         private readonly SafeFileHandle? _inputReadPipe;
         private readonly SafeFileHandle? _outputWritePipe;
         private readonly SafeFileHandle? _errorWritePipe;
@@ -56,6 +59,28 @@ namespace Asmichi.ProcessManagement
             {
                 throw new ArgumentException($"{nameof(ChildProcessStartInfo.StdErrorFile)} must not be null.", nameof(startInfo));
             }
+            if ((stdOutputRedirection == OutputRedirection.Multiplexer || stdErrorRedirection == OutputRedirection.Multiplexer)
+                && startInfo.OutputMultiplexer == null)
+            {
+                throw new ArgumentException($"{nameof(ChildProcessStartInfo.OutputMultiplexer)} must not be null.", nameof(startInfo));
+            }
+            if ((stdOutputRedirection == OutputRedirection.Tee && startInfo.StdOutputTeeSinks.Count >= MaxTeeSinkCount)
+                || (stdErrorRedirection == OutputRedirection.Tee && startInfo.StdErrorTeeSinks.Count >= MaxTeeSinkCount))
+            {
+                throw new ArgumentException($"Too many tee sinks (at most {MaxTeeSinkCount - 1}).", nameof(startInfo));
+            }
+            if (startInfo.StdioBufferSize <= 0)
+            {
+                throw new ArgumentException($"{nameof(ChildProcessStartInfo.StdioBufferSize)} must be positive.", nameof(startInfo));
+            }
+            if (startInfo.OutputBufferMemoryBudget < 0)
+            {
+                throw new ArgumentException($"{nameof(ChildProcessStartInfo.OutputBufferMemoryBudget)} must not be negative.", nameof(startInfo));
+            }
+            if (startInfo.MemoryCaptureMaxLength < 0)
+            {
+                throw new ArgumentException($"{nameof(ChildProcessStartInfo.MemoryCaptureMaxLength)} must not be negative.", nameof(startInfo));
+            }
 
             bool redirectingToSameFile = IsFileRedirection(stdOutputRedirection) && IsFileRedirection(stdErrorRedirection) && stdOutputFile == stdErrorFile;
             if (redirectingToSameFile && stdErrorRedirection != stdOutputRedirection)
@@ -65,28 +90,65 @@ namespace Asmichi.ProcessManagement
                     nameof(startInfo));
             }
 
+            var pipeBufferSize = startInfo.StdioBufferSize ?? 0;
+
             try
             {
                 if (stdInputRedirection == InputRedirection.InputPipe)
                 {
-                    (InputStream, _inputReadPipe) = FilePal.CreatePipePairWithAsyncServerSide(System.IO.Pipes.PipeDirection.Out);
+                    (InputStream, _inputReadPipe) = FilePal.CreatePipePairWithAsyncServerSide(System.IO.Pipes.PipeDirection.Out, pipeBufferSize);
                 }
 
                 if (stdOutputRedirection == OutputRedirection.OutputPipe
-                    || stdErrorRedirection == OutputRedirection.OutputPipe)
+                    || stdErrorRedirection == OutputRedirection.OutputPipe
+                    || stdOutputRedirection == OutputRedirection.Tee)
                 {
-                    (OutputStream, _outputWritePipe) = FilePal.CreatePipePairWithAsyncServerSide(System.IO.Pipes.PipeDirection.In);
+                    (OutputStream, _outputWritePipe) = FilePal.CreatePipePairWithAsyncServerSide(System.IO.Pipes.PipeDirection.In, pipeBufferSize);
                 }
 
                 if (stdOutputRedirection == OutputRedirection.ErrorPipe
-                    || stdErrorRedirection == OutputRedirection.ErrorPipe)
+                    || stdErrorRedirection == OutputRedirection.ErrorPipe
+                    || stdErrorRedirection == OutputRedirection.Tee)
                 {
-                    (ErrorStream, _errorWritePipe) = FilePal.CreatePipePairWithAsyncServerSide(System.IO.Pipes.PipeDirection.In);
+                    (ErrorStream, _errorWritePipe) = FilePal.CreatePipePairWithAsyncServerSide(System.IO.Pipes.PipeDirection.In, pipeBufferSize);
+                }
+
+                if (startInfo.OutputBufferMemoryBudget is int memoryBudget)
+                {
+                    if (OutputStream is not null)
+                    {
+                        OutputStream = new SpillableOutputStream(OutputStream, memoryBudget);
+                    }
+                    if (ErrorStream is not null)
+                    {
+                        ErrorStream = new SpillableOutputStream(ErrorStream, memoryBudget);
+                    }
+                }
+
+                if (stdOutputRedirection == OutputRedirection.MemoryCapture)
+                {
+                    CapturedOutput = MemoryCapturedOutput.Create(startInfo.MemoryCaptureMaxLength);
+                }
+
+                if (stdErrorRedirection == OutputRedirection.MemoryCapture)
+                {
+                    CapturedError = MemoryCapturedOutput.Create(startInfo.MemoryCaptureMaxLength);
+                }
+
+                if (stdOutputRedirection == OutputRedirection.Tee)
+                {
+                    PipelineStdOutTeeSinks = MakeTeeSinks(_outputWritePipe!, startInfo.StdOutputTeeSinks, nameof(startInfo));
+                }
+
+                if (stdErrorRedirection == OutputRedirection.Tee)
+                {
+                    PipelineStdErrTeeSinks = MakeTeeSinks(_errorWritePipe!, startInfo.StdErrorTeeSinks, nameof(startInfo));
                 }
 
                 PipelineStdIn = ChooseInput(
                     stdInputRedirection,
                     stdInputFile,
+                    startInfo.StdInputBytes,
                     stdInputHandle,
                     _inputReadPipe,
                     startInfo.CreateNewConsole);
@@ -97,6 +159,7 @@ namespace Asmichi.ProcessManagement
                     stdOutputHandle,
                     _outputWritePipe,
                     _errorWritePipe,
+                    CapturedOutput,
                     startInfo.CreateNewConsole);
 
                 if (redirectingToSameFile)
@@ -111,6 +174,7 @@ namespace Asmichi.ProcessManagement
                         stdErrorHandle,
                         _outputWritePipe,
                         _errorWritePipe,
+                        CapturedError,
                         startInfo.CreateNewConsole);
                 }
             }
@@ -139,6 +203,8 @@ namespace Asmichi.ProcessManagement
                 InputStream?.Dispose();
                 OutputStream?.Dispose();
                 ErrorStream?.Dispose();
+                CapturedOutput?.Dispose();
+                CapturedError?.Dispose();
                 _isDisposed = true;
             }
         }
@@ -150,13 +216,27 @@ namespace Asmichi.ProcessManagement
 
         /// <summary>
         /// A handle that should be used as the stdout handle of the pipeline.
+        /// <see langword="null"/> if the helper process creates one (<see cref="OutputRedirection.Multiplexer"/> or <see cref="OutputRedirection.Tee"/>).
         /// </summary>
-        public SafeHandle PipelineStdOut { get; }
+        public SafeHandle? PipelineStdOut { get; }
 
         /// <summary>
         /// A handle that should be used as the stderr handle of the pipeline.
+        /// <see langword="null"/> if the helper process creates one (<see cref="OutputRedirection.Multiplexer"/> or <see cref="OutputRedirection.Tee"/>).
+        /// </summary>
+        public SafeHandle? PipelineStdErr { get; }
+
+        /// <summary>
+        /// The sinks that the helper process should copy the stdout of the pipeline to (<see cref="OutputRedirection.Tee"/>), otherwise <see langword="null"/>.
+        /// The first one is the pipe to <see cref="OutputStream"/>.
         /// </summary>
-        public SafeHandle PipelineStdErr { get; }
+        public IReadOnlyList<ChildProcessTeeSink>? PipelineStdOutTeeSinks { get; }
+
+        /// <summary>
+        /// The sinks that the helper process should copy the stderr of the pipeline to (<see cref="OutputRedirection.Tee"/>), otherwise <see langword="null"/>.
+        /// The first one is the pipe to <see cref="ErrorStream"/>.
+        /// </summary>
+        public IReadOnlyList<ChildProcessTeeSink>? PipelineStdErrTeeSinks { get; }
 
         /// <summary>
         /// An asynchronous <see cref="Stream"/> that writes to the pipeline.
@@ -174,7 +254,18 @@ namespace Asmichi.ProcessManagement
         public Stream? ErrorStream { get; private set; }
 
         /// <summary>
-        /// Detaches <see cref="InputStream"/>, <see cref="OutputStream"/> and <see cref="ErrorStream"/> so that they will no be disposed by this instance.
+        /// The file that the standard output of the pipeline is captured into.
+        /// </summary>
+        public MemoryCapturedOutput? CapturedOutput { get; private set; }
+
+        /// <summary>
+        /// The file that the standard error of the pipeline is captured into.
+        /// </summary>
+        public MemoryCapturedOutput? CapturedError { get; private set; }
+
+        /// <summary>
+        /// Detaches <see cref="InputStream"/>, <see cref="OutputStream"/>, <see cref="ErrorStream"/>, <see cref="CapturedOutput"/> and <see cref="CapturedError"/>
+        /// so that they will no be disposed by this instance.
         /// Must be called in order to expose the streams to the caller.
         /// </summary>
         public void DetachStreams()
@@ -182,11 +273,14 @@ namespace Asmichi.ProcessManagement
             InputStream = null;
             OutputStream = null;
             ErrorStream = null;
+            CapturedOutput = null;
+            CapturedError = null;
         }
 
         private SafeHandle ChooseInput(
             InputRedirection redirection,
             string? fileName,
+            ReadOnlyMemory<byte> bytes,
             SafeHandle? handle,
             SafeHandle? inputPipe,
             bool createNewConsole)
@@ -198,16 +292,18 @@ namespace Asmichi.ProcessManagement
                 InputRedirection.File => OpenFile(fileName!, FileMode.Open, FileAccess.Read, FileShare.Read),
                 InputRedirection.Handle => handle!,
                 InputRedirection.NullDevice => OpenNullDevice(FileAccess.Read),
+                InputRedirection.Bytes => CreateReadOnlyFile(bytes.Span),
                 _ => throw new ArgumentOutOfRangeException(nameof(redirection), "Not a valid value for " + nameof(InputRedirection) + "."),
             };
         }
 
-        private SafeHandle ChooseOutput(
+        private SafeHandle? ChooseOutput(
             OutputRedirection redirection,
             string? fileName,
             SafeHandle? handle,
             SafeHandle? outputPipe,
             SafeHandle? errorPipe,
+            MemoryCapturedOutput? capture,
             bool createNewConsole)
         {
             return redirection switch
@@ -220,10 +316,24 @@ namespace Asmichi.ProcessManagement
                 OutputRedirection.AppendToFile => OpenFile(fileName!, FileMode.Append, FileAccess.Write, FileShare.Read),
                 OutputRedirection.Handle => handle!,
                 OutputRedirection.NullDevice => OpenNullDevice(FileAccess.Write),
+                OutputRedirection.Multiplexer => null,
+                OutputRedirection.MemoryCapture => capture!.FileHandle,
+                OutputRedirection.Tee => null,
                 _ => throw new ArgumentOutOfRangeException(nameof(redirection), "Not a valid value for " + nameof(OutputRedirection) + "."),
             };
         }
 
+        private static ChildProcessTeeSink[] MakeTeeSinks(SafeHandle clientPipe, IReadOnlyList<ChildProcessTeeSink> extraSinks, string paramName)
+        {
+            var sinks = new ChildProcessTeeSink[1 + extraSinks.Count];
+            sinks[0] = new ChildProcessTeeSink(clientPipe);
+            for (int i = 0; i < extraSinks.Count; i++)
+            {
+                sinks[1 + i] = extraSinks[i] ?? throw new ArgumentException("A tee sink must not be null.", paramName);
+            }
+            return sinks;
+        }
+
         private SafeFileHandle? CreateStdInputHandleForChild(bool createNewConsole)
         {
             var handle = ConsolePal.CreateStdInputHandleForChild(createNewConsole);
@@ -268,6 +378,13 @@ namespace Asmichi.ProcessManagement
             return fs.SafeFileHandle;
         }
 
+        private SafeFileHandle CreateReadOnlyFile(ReadOnlySpan<byte> content)
+        {
+            var handle = FilePal.CreateReadOnlyFile(content);
+            AddObjectsToDispose(handle);
+            return handle;
+        }
+
         private SafeFileHandle OpenNullDevice(FileAccess access)
         {
             var handle = FilePal.OpenNullDevice(access);
@@ -0,0 +1,33 @@
+// Copyright (c) @asmichi (https://github.com/asmichi). Licensed under the MIT License. See LICENCE in the project root for details.
+
+namespace Asmichi.ProcessManagement
+{
+    /// <summary>
+    /// <para>
+    /// A <see cref="ChildProcessStartInfo"/> validated and encoded by <see cref="ChildProcess.Prepare(ChildProcessStartInfo)"/>.
+    /// Pass this to <see cref="ChildProcess.Start(PreparedChildProcessStartInfo)"/> to start the same command repeatedly.
+    /// </para>
+    /// <para>
+    /// This class is immutable and thread-safe.
+    /// </para>
+    /// </summary>
+    public sealed class PreparedChildProcessStartInfo
+    {
+        internal PreparedChildProcessStartInfo(ChildProcessStartInfoInternal startInfo, string resolvedPath, object preparedRequest)
+        {
+            StartInfo = startInfo;
+            ResolvedPath = resolvedPath;
+            PreparedRequest = preparedRequest;
+        }
+
+        /// <summary>
+        /// The resolved path to the executable.
+        /// </summary>
+        public string ResolvedPath { get; }
+
+        internal ChildProcessStartInfoInternal StartInfo { get; }
+
+        // Platform-specific. See IChildProcessStateHelper.PrepareSpawnRequest.
+        internal object PreparedRequest { get; }
+    }
+}
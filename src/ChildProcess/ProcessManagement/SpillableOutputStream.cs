@@ -0,0 +1,335 @@
+// Copyright (c) @asmichi (https://github.com/asmichi). Licensed under the MIT License. See LICENCE in the project root for details.
+
+using System;
+using System.Buffers;
+using System.Collections.Generic;
+using System.IO;
+using System.Threading;
+using System.Threading.Tasks;
+using Asmichi.PlatformAbstraction;
+
+namespace Asmichi.ProcessManagement
+{
+    /// <summary>
+    /// <para>
+    /// Eagerly reads an output of a child process (<see cref="ChildProcessStartInfo.OutputBufferMemoryBudget"/>)
+    /// so that the child process will never block on a full pipe, and exposes the data read as a sequential stream.
+    /// </para>
+    /// <para>
+    /// Up to the budget, the data is kept in memory. Past the budget, the data is appended to a temporary file
+    /// (the spill file, created on first use), which is read before any newer data is kept in memory again.
+    /// The spill file is truncated whenever it has been read to the end.
+    /// </para>
+    /// </summary>
+    internal sealed class SpillableOutputStream : Stream
+    {
+        private const int ChunkSize = 64 * 1024;
+
+        private readonly Stream _source;
+        private readonly int _memoryBudget;
+        private readonly object _lock = new object();
+        private readonly Queue<Chunk> _chunks = new Queue<Chunk>();
+        private Chunk? _tail;
+        private long _chunkMemory;
+        private FileStream? _spill;
+        private long _spillReadPosition;
+        private long _spillWritePosition;
+        private TaskCompletionSource<bool>? _waiter;
+        private bool _isCompleted;
+        private Exception? _error;
+        private bool _isDisposed;
+
+        /// <summary>
+        /// Initializes a new instance of the <see cref="SpillableOutputStream"/> class and starts reading <paramref name="source"/>.
+        /// </summary>
+        /// <param name="source">The stream to read. Owned by this instance.</param>
+        /// <param name="memoryBudget">The maximum number of bytes kept in memory (allocated in chunks of 64 KiB).</param>
+        public SpillableOutputStream(Stream source, int memoryBudget)
+        {
+            _source = source;
+            _memoryBudget = memoryBudget;
+            _ = Task.Run(PumpAsync);
+        }
+
+        public override bool CanRead => !_isDisposed;
+        public override bool CanSeek => false;
+        public override bool CanWrite => false;
+        public override long Length => throw new NotSupportedException();
+
+        public override long Position
+        {
+            get => throw new NotSupportedException();
+            set => throw new NotSupportedException();
+        }
+
+        public override void Flush()
+        {
+        }
+
+        public override int Read(byte[] buffer, int offset, int count) => Read(new Span<byte>(buffer, offset, count));
+
+        public override int Read(Span<byte> buffer)
+        {
+            while (true)
+            {
+                Task waitTask;
+                lock (_lock)
+                {
+                    var bytesRead = TryReadLocked(buffer);
+                    if (bytesRead >= 0)
+                    {
+                        return bytesRead;
+                    }
+
+                    waitTask = GetWaitTaskLocked();
+                }
+
+                waitTask.GetAwaiter().GetResult();
+            }
+        }
+
+        public override Task<int> ReadAsync(byte[] buffer, int offset, int count, CancellationToken cancellationToken) =>
+            ReadAsync(new Memory<byte>(buffer, offset, count), cancellationToken).AsTask();
+
+        public override async ValueTask<int> ReadAsync(Memory<byte> buffer, CancellationToken cancellationToken = default)
+        {
+            while (true)
+            {
+                cancellationToken.ThrowIfCancellationRequested();
+
+                Task waitTask;
+                lock (_lock)
+                {
+                    var bytesRead = TryReadLocked(buffer.Span);
+                    if (bytesRead >= 0)
+                    {
+                        return bytesRead;
+                    }
+
+                    waitTask = GetWaitTaskLocked();
+                }
+
+                if (!cancellationToken.CanBeCanceled)
+                {
+                    await waitTask.ConfigureAwait(false);
+                    continue;
+                }
+
+                var cancellationTcs = new TaskCompletionSource<bool>(TaskCreationOptions.RunContinuationsAsynchronously);
+                using (cancellationToken.Register(s => ((TaskCompletionSource<bool>)s!).TrySetResult(true), cancellationTcs))
+                {
+                    await Task.WhenAny(waitTask, cancellationTcs.Task).ConfigureAwait(false);
+                }
+            }
+        }
+
+        public override long Seek(long offset, SeekOrigin origin) => throw new NotSupportedException();
+        public override void SetLength(long value) => throw new NotSupportedException();
+        public override void Write(byte[] buffer, int offset, int count) => throw new NotSupportedException();
+
+        protected override void Dispose(bool disposing)
+        {
+            if (disposing)
+            {
+                TaskCompletionSource<bool>? waiter;
+                lock (_lock)
+                {
+                    if (_isDisposed)
+                    {
+                        return;
+                    }
+
+                    _isDisposed = true;
+                    waiter = _waiter;
+                    _waiter = null;
+
+                    while (_chunks.Count > 0)
+                    {
+                        ArrayPool<byte>.Shared.Return(_chunks.Dequeue().Buffer);
+                    }
+                    _tail = null;
+                    _spill?.Dispose();
+                }
+
+                // Aborts the pending read of the pump.
+                _source.Dispose();
+                waiter?.TrySetResult(true);
+            }
+
+            base.Dispose(disposing);
+        }
+
+        private async Task PumpAsync()
+        {
+            byte[]? buffer = null;
+            try
+            {
+                while (true)
+                {
+                    buffer ??= ArrayPool<byte>.Shared.Rent(ChunkSize);
+                    var bytesRead = await _source.ReadAsync(buffer.AsMemory(), CancellationToken.None).ConfigureAwait(false);
+                    if (bytesRead == 0)
+                    {
+                        Complete(null);
+                        return;
+                    }
+
+                    if (Append(buffer, bytesRead))
+                    {
+                        buffer = null;
+                    }
+                }
+            }
+#pragma warning disable CA1031 // Every failure must be delivered to the reader; otherwise it would wait forever.
+            catch (Exception ex)
+#pragma warning restore CA1031
+            {
+                Complete(ex);
+            }
+            finally
+            {
+                if (buffer is not null)
+                {
+                    ArrayPool<byte>.Shared.Return(buffer);
+                }
+            }
+        }
+
+        // Returns true if this instance has taken the ownership of buffer.
+        private bool Append(byte[] buffer, int count)
+        {
+            bool taken = false;
+            TaskCompletionSource<bool>? waiter;
+            lock (_lock)
+            {
+                if (_isDisposed)
+                {
+                    throw new ObjectDisposedException(nameof(SpillableOutputStream));
+                }
+
+                // Once spilling, keep spilling until the spill file has been read to the end; otherwise newer data would overtake.
+                if (_spillWritePosition == _spillReadPosition && _tail is not null && _tail.Buffer.Length - _tail.End >= count)
+                {
+                    // Coalesce small reads into the last chunk.
+                    buffer.AsSpan(0, count).CopyTo(_tail.Buffer.AsSpan(_tail.End));
+                    _tail.End += count;
+                }
+                else if (_spillWritePosition == _spillReadPosition && _chunkMemory + buffer.Length <= _memoryBudget)
+                {
+                    _tail = new Chunk(buffer, count);
+                    _chunks.Enqueue(_tail);
+                    _chunkMemory += buffer.Length;
+                    taken = true;
+                }
+                else
+                {
+                    _spill ??= new FileStream(FilePal.CreateTemporaryFile(), FileAccess.ReadWrite, 1);
+                    _spill.Position = _spillWritePosition;
+                    _spill.Write(buffer, 0, count);
+                    _spillWritePosition += count;
+                }
+
+                waiter = _waiter;
+                _waiter = null;
+            }
+
+            waiter?.TrySetResult(true);
+            return taken;
+        }
+
+        private void Complete(Exception? error)
+        {
+            TaskCompletionSource<bool>? waiter;
+            lock (_lock)
+            {
+                // Errors caused by our own disposal are not interesting.
+                _error = _isDisposed ? null : error;
+                _isCompleted = true;
+                waiter = _waiter;
+                _waiter = null;
+            }
+
+            waiter?.TrySetResult(true);
+        }
+
+        // Returns -1 if no data is available yet.
+        private int TryReadLocked(Span<byte> destination)
+        {
+            if (_isDisposed)
+            {
+                throw new ObjectDisposedException(nameof(SpillableOutputStream));
+            }
+            if (destination.IsEmpty)
+            {
+                return 0;
+            }
+
+            // Chunks in memory are always older than the data in the spill file.
+            if (_chunks.Count > 0)
+            {
+                var chunk = _chunks.Peek();
+                var bytesRead = Math.Min(destination.Length, chunk.End - chunk.Start);
+                chunk.Buffer.AsSpan(chunk.Start, bytesRead).CopyTo(destination);
+                chunk.Start += bytesRead;
+                if (chunk.Start == chunk.End)
+                {
+                    _chunks.Dequeue();
+                    _chunkMemory -= chunk.Buffer.Length;
+                    if (_tail == chunk)
+                    {
+                        _tail = null;
+                    }
+                    ArrayPool<byte>.Shared.Return(chunk.Buffer);
+                }
+                return bytesRead;
+            }
+
+            if (_spillReadPosition < _spillWritePosition)
+            {
+                var spill = _spill!;
+                spill.Position = _spillReadPosition;
+                var bytesRead = spill.Read(destination.Slice(0, (int)Math.Min(destination.Length, _spillWritePosition - _spillReadPosition)));
+                _spillReadPosition += bytesRead;
+                if (_spillReadPosition == _spillWritePosition)
+                {
+                    // Give the disk space back.
+                    spill.SetLength(0);
+                    _spillReadPosition = 0;
+                    _spillWritePosition = 0;
+                }
+                return bytesRead;
+            }
+
+            if (_isCompleted)
+            {
+                if (_error is not null)
+                {
+                    throw new IOException("Failed to read the output of the child process.", _error);
+                }
+
+                return 0;
+            }
+
+            return -1;
+        }
+
+        private Task<bool> GetWaitTaskLocked()
+        {
+            _waiter ??= new TaskCompletionSource<bool>(TaskCreationOptions.RunContinuationsAsynchronously);
+            return _waiter.Task;
+        }
+
+        private sealed class Chunk
+        {
+            public Chunk(byte[] buffer, int end)
+            {
+                Buffer = buffer;
+                End = end;
+            }
+
+            public byte[] Buffer { get; }
+            public int Start { get; set; }
+            public int End { get; set; }
+        }
+    }
+}
@@ -1,11 +1,14 @@
 // Copyright (c) @asmichi (https://github.com/asmichi). Licensed under the MIT License. See LICENCE in the project root for details.
 
 using System;
+using System.Collections.Concurrent;
 using System.Collections.Generic;
 using System.Diagnostics;
 using System.Diagnostics.CodeAnalysis;
 using System.Threading;
+using System.Threading.Tasks;
 using Asmichi.Interop.Windows;
+using Asmichi.Utilities;
 using Microsoft.Win32.SafeHandles;
 
 namespace Asmichi.ProcessManagement
@@ -50,8 +53,8 @@ namespace Asmichi.ProcessManagement
 
     internal sealed class UnixChildProcessState : IChildProcessState, IDisposable
     {
+        // Also signaled (Monitor.PulseAll) when the process exits.
         private readonly object _lock = new object();
-        private readonly ManualResetEvent _exitedEvent = new ManualResetEvent(false);
         private readonly UnixChildProcessStateHelper _helper;
         private readonly long _token;
         private readonly bool _allowSignal;
@@ -59,6 +62,13 @@ namespace Asmichi.ProcessManagement
         private bool _hasExited;
         private int _processId = -1;
         private int _exitCode = -1;
+        private ChildProcessStartupTimings? _startupTimings;
+        // Created on demand. Waiting does not need a kernel object or the wait thread of the thread pool.
+        private ManualResetEvent? _exitedEvent;
+        // Shared by all waits without a timeout or cancellation.
+        private TaskCompletionSource<bool>? _exitedCompletionSource;
+        private List<ExitWaiter>? _exitWaiters;
+        private List<(Action<object?> Callback, object? State)>? _exitedCallbacks;
 
         private UnixChildProcessState(UnixChildProcessStateHelper helper, long token, bool allowSignal)
         {
@@ -71,7 +81,8 @@ namespace Asmichi.ProcessManagement
         public int ExitCode => GetExitCode();
         public bool HasExitCode => GetHasExited();
         public long Token => _token;
-        public WaitHandle ExitedWaitHandle => _exitedEvent;
+        public ChildProcessStartupTimings? StartupTimings => _startupTimings;
+        public WaitHandle ExitedWaitHandle => GetExitedWaitHandle();
         public bool HasHandle => false;
         public SafeProcessHandle ProcessHandle => throw new NotSupportedException();
         public SafeThreadHandle PrimaryThreadHandle => throw new NotSupportedException();
@@ -86,7 +97,7 @@ namespace Asmichi.ProcessManagement
             }
 
             ChildProcessStateCollection.RemoveChildProcessState(this);
-            _exitedEvent.Dispose();
+            _exitedEvent?.Dispose();
         }
 
         /// <summary>
@@ -185,6 +196,91 @@ namespace Asmichi.ProcessManagement
             }
         }
 
+        private WaitHandle GetExitedWaitHandle()
+        {
+            lock (_lock)
+            {
+                return _exitedEvent ??= new ManualResetEvent(_hasExited);
+            }
+        }
+
+        public bool WaitForExit(TimeSpan timeout)
+        {
+            lock (_lock)
+            {
+                if (timeout == Timeout.InfiniteTimeSpan)
+                {
+                    while (!_hasExited)
+                    {
+                        Monitor.Wait(_lock);
+                    }
+
+                    return true;
+                }
+
+                var startTimestamp = Stopwatch.GetTimestamp();
+                while (!_hasExited)
+                {
+                    var remaining = timeout - TimeSpan.FromSeconds((double)(Stopwatch.GetTimestamp() - startTimestamp) / Stopwatch.Frequency);
+                    if (remaining <= TimeSpan.Zero || !Monitor.Wait(_lock, remaining))
+                    {
+                        return _hasExited;
+                    }
+                }
+
+                return true;
+            }
+        }
+
+        public Task<bool> WaitForExitAsync(TimeSpan timeout, CancellationToken cancellationToken)
+        {
+            lock (_lock)
+            {
+                if (_hasExited)
+                {
+                    return CompletedBoolTask.True;
+                }
+
+                if (timeout == Timeout.InfiniteTimeSpan && !cancellationToken.CanBeCanceled)
+                {
+                    // For safety, run continuations outside SetExited so they will not block the thread processing notifications.
+                    _exitedCompletionSource ??= new TaskCompletionSource<bool>(TaskCreationOptions.RunContinuationsAsynchronously);
+                    return _exitedCompletionSource.Task;
+                }
+
+                var waiter = new ExitWaiter(this);
+                _exitWaiters ??= new List<ExitWaiter>();
+                _exitWaiters.Add(waiter);
+
+                // NOTE: The callbacks lock _lock. They may run synchronously on this thread (reentrant) or block until we leave the lock.
+                waiter.Start(timeout, cancellationToken);
+                return waiter.Task;
+            }
+        }
+
+        public void RegisterExitedCallback(Action<object?> callback, object? state)
+        {
+            lock (_lock)
+            {
+                if (!_hasExited)
+                {
+                    _exitedCallbacks ??= new List<(Action<object?>, object?)>();
+                    _exitedCallbacks.Add((callback, state));
+                    return;
+                }
+            }
+
+            callback(state);
+        }
+
+        private bool RemoveExitWaiter(ExitWaiter waiter)
+        {
+            lock (_lock)
+            {
+                return _exitWaiters is not null && _exitWaiters.Remove(waiter);
+            }
+        }
+
         private int GetProcessId()
         {
             Debug.Assert(_processId != -1);
@@ -202,8 +298,20 @@ namespace Asmichi.ProcessManagement
             _processId = processId;
         }
 
+        /// <summary>
+        /// Sets the startup timings reported by the helper. Must be called before returning <see cref="UnixChildProcessState"/> to <see cref="ChildProcessImpl"/>.
+        /// </summary>
+        /// <param name="startupTimings">The startup timings.</param>
+        public void SetStartupTimings(ChildProcessStartupTimings startupTimings)
+        {
+            _startupTimings = startupTimings;
+        }
+
         public void SetExited(int exitCode)
         {
+            TaskCompletionSource<bool>? exitedCompletionSource;
+            List<ExitWaiter>? exitWaiters;
+            List<(Action<object?> Callback, object? State)>? exitedCallbacks;
             lock (_lock)
             {
                 if (_hasExited)
@@ -213,7 +321,32 @@ namespace Asmichi.ProcessManagement
 
                 _hasExited = true;
                 _exitCode = exitCode;
-                _exitedEvent.Set();
+                _exitedEvent?.Set();
+                Monitor.PulseAll(_lock);
+
+                exitedCompletionSource = _exitedCompletionSource;
+                exitWaiters = _exitWaiters;
+                _exitWaiters = null;
+                exitedCallbacks = _exitedCallbacks;
+                _exitedCallbacks = null;
+            }
+
+            exitedCompletionSource?.TrySetResult(true);
+
+            if (exitWaiters is not null)
+            {
+                foreach (var waiter in exitWaiters)
+                {
+                    waiter.Complete(true);
+                }
+            }
+
+            if (exitedCallbacks is not null)
+            {
+                foreach (var (callback, state) in exitedCallbacks)
+                {
+                    callback(state);
+                }
             }
         }
 
@@ -246,41 +379,123 @@ namespace Asmichi.ProcessManagement
             _helper.SendSignal(_token, UnixHelperProcessSignalNumber.Kill);
         }
 
+        public void SendSignal(ChildProcessSignal signal)
+        {
+            Debug.Assert(_allowSignal || signal == ChildProcessSignal.Kill);
+            _helper.SendSignal(_token, ToHelperSignalNumber(signal));
+        }
+
+        public static UnixHelperProcessSignalNumber ToHelperSignalNumber(ChildProcessSignal signal) =>
+            signal switch
+            {
+                ChildProcessSignal.Interrupt => UnixHelperProcessSignalNumber.Interrupt,
+                ChildProcessSignal.Termination => UnixHelperProcessSignalNumber.Termination,
+                ChildProcessSignal.Kill => UnixHelperProcessSignalNumber.Kill,
+                ChildProcessSignal.Hangup => UnixHelperProcessSignalNumber.Hangup,
+                ChildProcessSignal.User1 => UnixHelperProcessSignalNumber.User1,
+                ChildProcessSignal.User2 => UnixHelperProcessSignalNumber.User2,
+                ChildProcessSignal.Stop => UnixHelperProcessSignalNumber.Stop,
+                ChildProcessSignal.Continue => UnixHelperProcessSignalNumber.Continue,
+                _ => throw new AsmichiChildProcessInternalLogicErrorException(),
+            };
+
+        // A wait with a timeout or cancellation. Completed directly by SetExited, the timer or the cancellation.
+#pragma warning disable CA1001 // The timer is disposed on completion.
+        private sealed class ExitWaiter : TaskCompletionSource<bool>
+        {
+            private static readonly TimerCallback CachedTimeoutDelegate = OnTimeout;
+            private static readonly Action<object?> CachedCanceledDelegate = OnCanceled;
+
+            private readonly UnixChildProcessState _parent;
+            private Timer? _timer;
+            private CancellationTokenRegistration _cancellationTokenRegistration;
+            private CancellationToken _cancellationToken;
+
+            public ExitWaiter(UnixChildProcessState parent)
+                : base(TaskCreationOptions.RunContinuationsAsynchronously)
+            {
+                _parent = parent;
+            }
+
+            // Pre: Called within _parent._lock.
+            public void Start(TimeSpan timeout, CancellationToken cancellationToken)
+            {
+                if (timeout != Timeout.InfiniteTimeSpan)
+                {
+                    _timer = new Timer(CachedTimeoutDelegate, this, timeout, Timeout.InfiniteTimeSpan);
+                }
+
+                if (cancellationToken.CanBeCanceled)
+                {
+                    _cancellationToken = cancellationToken;
+                    _cancellationTokenRegistration = cancellationToken.Register(CachedCanceledDelegate, this, useSynchronizationContext: false);
+                }
+            }
+
+            public void Complete(bool exited)
+            {
+                // The timer and the cancellation token registration have been created within _parent._lock,
+                // which the callers have acquired at least once after that.
+                _timer?.Dispose();
+                _cancellationTokenRegistration.Dispose();
+                TrySetResult(exited);
+            }
+
+            // NOTE: This callback is executed on a thread-pool thread.
+            private static void OnTimeout(object? state)
+            {
+                Debug.Assert(state != null);
+
+                var self = (ExitWaiter)state;
+                if (self._parent.RemoveExitWaiter(self))
+                {
+                    self.Complete(false);
+                }
+            }
+
+            // NOTE: This callback is called synchronously from CTS.Cancel().
+            private static void OnCanceled(object? state)
+            {
+                Debug.Assert(state != null);
+
+                var self = (ExitWaiter)state;
+                if (self._parent.RemoveExitWaiter(self))
+                {
+                    self._timer?.Dispose();
+                    self.TrySetCanceled(self._cancellationToken);
+                }
+            }
+        }
+#pragma warning restore CA1001
+
         private static class ChildProcessStateCollection
         {
             // AssemblyLoadContext-global because our signal handler would be process-global anyway if we could move our signal handler into the current process.
-            private static readonly Dictionary<long, UnixChildProcessState> ChildProcessState = new Dictionary<long, UnixChildProcessState>();
+            // Lock-free reads: the thread processing notifications looks up every exited process and must not contend with spawning threads.
+            private static readonly ConcurrentDictionary<long, UnixChildProcessState> ChildProcessState = new ConcurrentDictionary<long, UnixChildProcessState>();
             private static long _prevToken;
 
             public static UnixChildProcessState Create(UnixChildProcessStateHelper helper, bool allowSignal)
             {
                 var token = IssueProcessToken();
                 var state = new UnixChildProcessState(helper, token, allowSignal);
-                lock (ChildProcessState)
+                if (!ChildProcessState.TryAdd(token, state))
                 {
-                    ChildProcessState.Add(token, state);
+                    throw new AsmichiChildProcessInternalLogicErrorException("Duplicate process token.");
                 }
                 return state;
 
                 static long IssueProcessToken() => Interlocked.Increment(ref _prevToken);
             }
 
-            public static bool TryGetChildProcessState(long token, [NotNullWhen(true)] out UnixChildProcessState? state)
-            {
-                lock (ChildProcessState)
-                {
-                    return ChildProcessState.TryGetValue(token, out state);
-                }
-            }
+            public static bool TryGetChildProcessState(long token, [NotNullWhen(true)] out UnixChildProcessState? state) =>
+                ChildProcessState.TryGetValue(token, out state);
 
             public static void RemoveChildProcessState(UnixChildProcessState childProcessState)
             {
                 Debug.Assert(childProcessState._refCount == 0);
 
-                lock (ChildProcessState)
-                {
-                    ChildProcessState.Remove(childProcessState.Token);
-                }
+                ChildProcessState.TryRemove(childProcessState.Token, out _);
             }
         }
     }
@@ -6,6 +6,8 @@ using System.Collections.Generic;
 using System.ComponentModel;
 using System.Diagnostics;
 using System.Globalization;
+using System.IO;
+using System.Runtime.CompilerServices;
 using System.Runtime.InteropServices;
 using System.Threading;
 using System.Threading.Channels;
@@ -22,8 +24,38 @@ namespace Asmichi.ProcessManagement
         private const uint RequestFlagsRedirectStderr = 1U << 2;
         private const uint RequestFlagsCreateNewProcessGroup = 1 << 3;
         private const uint RequestFlagsEnableAutoTermination = 1 << 4;
+        private const uint RequestFlagsRestrictFdInheritance = 1 << 5;
+        private const uint RequestFlagsReportTimings = 1 << 6;
+        private const uint RequestFlagsCaptureStdout = 1 << 7;
+        private const uint RequestFlagsCaptureStderr = 1 << 8;
+        private const uint RequestFlagsTeeStdout = 1 << 9;
+        private const uint RequestFlagsTeeStderr = 1 << 10;
+        private const int SpawnTimingsSize = sizeof(long) * 4;
+
+        // All fds of a request must fit in the request header. See Protocol.md.
+        private const int MaxExtraFileDescriptorCount = 64;
+
+        // (Linux-specific) Makes the helper adopt orphaned descendants of child processes (PR_SET_CHILD_SUBREAPER),
+        // reap them and terminate them when this process exits. See README.md.
+        private const string EnableSubreaperSwitchName = "Asmichi.ChildProcess.EnableSubreaper";
 
         private const int InitialBufferCapacity = 256; // Minimal capacity that every practical request will consume.
+        // token, flags, the fd map and the trailing tokens (unless the inherited environment variables are written).
+        private const int PreparedRequestExtraCapacity = 8 + 4 + 4 + (4 * MaxExtraFileDescriptorCount) + (8 * 3) + ((4 + (4 * 8)) * 2) + 4;
+
+        // NOTE: Make sure to sync with the helper.
+        private const int MaxSignalBulkTokenCount = 64 * 1024;
+        private const int SignalBulkFailureSize = sizeof(uint) + sizeof(int);
+
+        // NOTE: Make sure to sync with the helper.
+        private const uint JobFlagsKillOnClose = 1U << 0;
+        private const int JobStatisticsSize = 32;
+
+        // The encoded environment variables of each ChildProcessCreationContext (the count followed by the entries).
+        private static readonly ConditionalWeakTable<ChildProcessCreationContext, byte[]> EncodedContextEnvironmentVariables =
+            new ConditionalWeakTable<ChildProcessCreationContext, byte[]>();
+        private static readonly ConditionalWeakTable<ChildProcessCreationContext, byte[]>.CreateValueCallback CachedEncodeEnvironmentVariablesDelegate =
+            EncodeEnvironmentVariables;
 
         private readonly CancellationTokenSource _shutdownTokenSource = new CancellationTokenSource();
         private readonly Channel<long> _terminationRequests;
@@ -32,16 +64,16 @@ namespace Asmichi.ProcessManagement
         private readonly Task _processAsyncTerminationTask;
 
         internal UnixChildProcessStateHelper()
-            : this(Environment.ProcessorCount)
+            : this(Environment.ProcessorCount, AppContext.TryGetSwitch(EnableSubreaperSwitchName, out var enableSubreaper) && enableSubreaper)
         {
         }
 
-        public UnixChildProcessStateHelper(int maxSubchannelCount)
+        public UnixChildProcessStateHelper(int maxSubchannelCount, bool enableSubreaper)
         {
             _terminationRequests = Channel.CreateUnbounded<long>();
 
             // Launch the helper.
-            _helperProcess = UnixHelperProcess.Launch(maxSubchannelCount);
+            _helperProcess = UnixHelperProcess.Launch(maxSubchannelCount, enableSubreaper);
 
             // Start communication with the helper.
             _readNotificationsTask = Task.Run(() => ReadNotificationsAsync(_shutdownTokenSource.Token));
@@ -97,18 +129,72 @@ namespace Asmichi.ProcessManagement
                 throw new PlatformNotSupportedException(
                     $"{nameof(ChildProcessFlags)}.{nameof(ChildProcessFlags.DisableKillOnDispose)} is supported only on Windows.");
             }
+
+            var extraFileDescriptors = startInfo.ExtraFileDescriptors;
+            if (extraFileDescriptors.Count > MaxExtraFileDescriptorCount)
+            {
+                throw new ArgumentException(
+                    $"{nameof(ChildProcessStartInfo)}.{nameof(ChildProcessStartInfo.ExtraFileDescriptors)} must not have more than {MaxExtraFileDescriptorCount} entries.", nameof(startInfo));
+            }
+
+            if (extraFileDescriptors.Count != 0)
+            {
+                var targetFds = new HashSet<int>();
+                foreach (var (fd, handle) in extraFileDescriptors)
+                {
+                    if (fd <= 2)
+                    {
+                        throw new ArgumentException(
+                            $"{nameof(ChildProcessStartInfo)}.{nameof(ChildProcessStartInfo.ExtraFileDescriptors)} must not have a key less than 3.", nameof(startInfo));
+                    }
+                    if (!targetFds.Add(fd))
+                    {
+                        throw new ArgumentException(
+                            $"{nameof(ChildProcessStartInfo)}.{nameof(ChildProcessStartInfo.ExtraFileDescriptors)} must not have duplicate keys.", nameof(startInfo));
+                    }
+                    if (handle is null)
+                    {
+                        throw new ArgumentException(
+                            $"{nameof(ChildProcessStartInfo)}.{nameof(ChildProcessStartInfo.ExtraFileDescriptors)} must not have a null value.", nameof(startInfo));
+                    }
+                }
+            }
+        }
+
+        public object PrepareSpawnRequest(in ChildProcessStartInfoInternal startInfo, string resolvedPath)
+        {
+            // The inherited environment variables are read on each spawn; they may change.
+            var bw = new MyBinaryWriter(InitialBufferCapacity);
+            try
+            {
+                WriteCommandLine(ref bw, in startInfo, resolvedPath);
+                if (startInfo.UseCustomEnvironmentVariables)
+                {
+                    WriteEnvironmentVariables(ref bw, in startInfo);
+                }
+
+                return new PreparedSpawnRequest(bw.GetBuffer().ToArray(), startInfo.UseCustomEnvironmentVariables);
+            }
+            finally
+            {
+                bw.Dispose();
+            }
         }
 
         public IChildProcessStateHolder SpawnProcess(
             ref ChildProcessStartInfoInternal startInfo,
             string resolvedPath,
+            object? preparedRequest,
             SafeHandle stdIn,
-            SafeHandle stdOut,
-            SafeHandle stdErr)
+            SafeHandle? stdOut,
+            SafeHandle? stdErr,
+            IReadOnlyList<ChildProcessTeeSink>? stdOutTeeSinks,
+            IReadOnlyList<ChildProcessTeeSink>? stdErrTeeSinks)
         {
-            var arguments = startInfo.Arguments;
-            var environmentVariables = startInfo.EnvironmentVariables;
-            var workingDirectory = startInfo.WorkingDirectory;
+            var extraFileDescriptors = startInfo.ExtraFileDescriptors;
+            var teeHandleCount = CountTeeHandles(stdOutTeeSinks) + CountTeeHandles(stdErrTeeSinks);
+            var shouldReportTimings = startInfo.Flags.HasReportStartupTimings();
+            var startTimestamp = shouldReportTimings ? Stopwatch.GetTimestamp() : 0;
 
             uint flags = 0;
 
@@ -128,14 +214,47 @@ namespace Asmichi.ProcessManagement
                 flags |= RequestFlagsEnableAutoTermination;
             }
 
+            if (startInfo.Flags.HasRestrictFileDescriptorInheritance())
+            {
+                flags |= RequestFlagsRestrictFdInheritance;
+            }
+
+            if (shouldReportTimings)
+            {
+                flags |= RequestFlagsReportTimings;
+            }
+
+            // The helper creates the pipes for captured streams (stdOut/stdErr are null).
+            if (startInfo.StdOutputRedirection == OutputRedirection.Multiplexer)
+            {
+                flags |= RequestFlagsCaptureStdout;
+            }
+            if (startInfo.StdErrorRedirection == OutputRedirection.Multiplexer)
+            {
+                flags |= RequestFlagsCaptureStderr;
+            }
+
+            // The helper creates the pipes for tee'd streams, too.
+            if (stdOutTeeSinks is not null)
+            {
+                flags |= RequestFlagsTeeStdout;
+            }
+            if (stdErrTeeSinks is not null)
+            {
+                flags |= RequestFlagsTeeStderr;
+            }
+
             // These handles may be externally visible (user-supplied); make sure concurrent disposal will not cause dangling handles.
             bool stdInRefAdded = false;
             bool stdOutRefAdded = false;
             bool stdErrRefAdded = false;
+            var extraHandleCount = extraFileDescriptors.Count + teeHandleCount;
+            var extraHandlesRefAdded = extraHandleCount == 0 ? Array.Empty<SafeHandle>() : new SafeHandle[extraHandleCount];
+            int extraHandlesRefAddedCount = 0;
             var stateHolder = UnixChildProcessState.Create(this, startInfo.AllowSignal);
             try
             {
-                Span<int> fds = stackalloc int[3];
+                Span<int> fds = stackalloc int[3 + extraHandleCount];
                 int handleCount = 0;
                 if (stdIn != null)
                 {
@@ -156,93 +275,82 @@ namespace Asmichi.ProcessManagement
                     flags |= RequestFlagsRedirectStderr;
                 }
 
-                using var bw = new MyBinaryWriter(InitialBufferCapacity);
-                bw.Write(stateHolder.State.Token);
-                bw.Write(flags);
-                bw.Write(workingDirectory);
-                bw.Write(resolvedPath);
-
-                bw.Write((uint)(arguments.Count + 1));
-                bw.Write(resolvedPath);
-                foreach (var x in arguments)
+                // NOTE: The source fds must be sent in the same order as the target fds.
+                Span<int> extraTargetFds = stackalloc int[extraFileDescriptors.Count];
+                foreach (var (targetFd, handle) in extraFileDescriptors)
                 {
-                    bw.Write(x);
+                    bool refAdded = false;
+                    handle.DangerousAddRef(ref refAdded);
+                    extraTargetFds[extraHandlesRefAddedCount] = targetFd;
+                    extraHandlesRefAdded[extraHandlesRefAddedCount++] = handle;
+                    fds[handleCount++] = handle.DangerousGetHandle().ToInt32();
                 }
 
-                if (!startInfo.UseCustomEnvironmentVariables)
+                // NOTE: The sink fds (each followed by its spill fd if any) must be sent in the same order as the sinks.
+                for (int i = 0; i < 2; i++)
                 {
-                    // Send the environment variables of this process to the helper process.
-                    //
-                    // NOTE: We cannot cache or detect updates to the environment block; only the runtime can.
-                    //       Concurrently invoking getenv and setenv is a racy operation; therefore the runtime
-                    //       employs a process-global lock.
-                    //
-                    //       Fortunately, the caller can take a snapshot of environment variables theirselves.
-                    var processEnvVars = Environment.GetEnvironmentVariables();
-                    var envVarCount = processEnvVars.Count;
-                    bw.Write((uint)envVarCount);
+                    var sinks = i == 0 ? stdOutTeeSinks : stdErrTeeSinks;
+                    if (sinks is null)
+                    {
+                        continue;
+                    }
 
-                    var sortedEnvVars = ArrayPool<KeyValuePair<string, string>>.Shared.Rent(envVarCount);
-                    try
+                    foreach (var sink in sinks)
                     {
-                        EnvironmentVariableListUtil.ToSortedKeyValuePairs(processEnvVars, sortedEnvVars);
+                        bool refAdded = false;
+                        sink.Handle.DangerousAddRef(ref refAdded);
+                        extraHandlesRefAdded[extraHandlesRefAddedCount++] = sink.Handle;
+                        fds[handleCount++] = sink.Handle.DangerousGetHandle().ToInt32();
 
-                        foreach (var (name, value) in sortedEnvVars.AsSpan<KeyValuePair<string, string>>().Slice(0, envVarCount))
+                        if (sink.SpillHandle is not null)
                         {
-                            bw.WriteEnvironmentVariable(name, value);
+                            refAdded = false;
+                            sink.SpillHandle.DangerousAddRef(ref refAdded);
+                            extraHandlesRefAdded[extraHandlesRefAddedCount++] = sink.SpillHandle;
+                            fds[handleCount++] = sink.SpillHandle.DangerousGetHandle().ToInt32();
                         }
                     }
-                    finally
-                    {
-                        ArrayPool<KeyValuePair<string, string>>.Shared.Return(sortedEnvVars);
-                    }
-                }
-                else
-                {
-                    bw.Write((uint)environmentVariables.Length);
-                    foreach (var (name, value) in environmentVariables.Span)
-                    {
-                        bw.WriteEnvironmentVariable(name, value);
-                    }
                 }
 
-                // Work around https://github.com/microsoft/WSL/issues/6490
-                // On WSL 1, if you call recvmsg multiple times to fully receive data sent with sendmsg,
-                // the fds will be duplicated for each recvmsg call.
-                // Send only fixed length of of data with the fds and receive that much data with one recvmsg call.
-                // That will be safer anyway.
-                Span<byte> header = stackalloc byte[sizeof(uint) * 2];
-                if (!BitConverter.TryWriteBytes(header, (uint)UnixHelperProcessCommand.SpawnProcess)
-                    || !BitConverter.TryWriteBytes(header.Slice(sizeof(uint)), bw.Length))
-                {
-                    Debug.Fail("Should never fail.");
-                }
-
-                var subchannel = _helperProcess.RentSubchannelAsync(default).AsTask().GetAwaiter().GetResult();
-
+                var prepared = preparedRequest as PreparedSpawnRequest;
+                var bw = new MyBinaryWriter(prepared is null ? InitialBufferCapacity : prepared.Encoded.Length + PreparedRequestExtraCapacity);
                 try
                 {
-                    subchannel.SendExactBytesAndFds(header, fds.Slice(0, handleCount));
-                    subchannel.SendExactBytes(bw.GetBuffer());
+                    bw.Write(stateHolder.State.Token);
+                    bw.Write(flags);
 
-                    var (error, processId) = subchannel.ReceiveCommonResponse();
-                    if (error > 0)
+                    if (prepared is null)
+                    {
+                        WriteCommandLine(ref bw, in startInfo, resolvedPath);
+                        WriteEnvironmentVariables(ref bw, in startInfo);
+                    }
+                    else
                     {
-                        throw new Win32Exception(error);
+                        bw.Write(prepared.Encoded);
+                        if (!prepared.HasEnvironmentVariables)
+                        {
+                            WriteEnvironmentVariables(ref bw, in startInfo);
+                        }
                     }
-                    else if (error < 0)
+
+                    bw.Write((uint)extraTargetFds.Length);
+                    foreach (var targetFd in extraTargetFds)
                     {
-                        throw new AsmichiChildProcessInternalLogicErrorException(
-                            string.Format(CultureInfo.InvariantCulture, "Internal logic error: Bad request {0}.", error));
+                        bw.Write((uint)targetFd);
                     }
 
-                    stateHolder.State.SetProcessId(processId);
+                    bw.Write(startInfo.Job?.Token ?? 0);
+                    bw.Write((flags & (RequestFlagsCaptureStdout | RequestFlagsCaptureStderr)) != 0 ? startInfo.OutputMultiplexer!.Token : 0);
+                    bw.Write(startInfo.OutputTag);
+                    WriteTeeSinks(ref bw, stdOutTeeSinks);
+                    WriteTeeSinks(ref bw, stdErrTeeSinks);
+                    bw.Write((uint)(startInfo.StdioBufferSize ?? 0));
 
-                    return stateHolder;
+                    return SendSpawnRequest(stateHolder, bw.GetBuffer(), fds.Slice(0, handleCount), shouldReportTimings, startTimestamp);
                 }
                 finally
                 {
-                    _helperProcess.ReturnSubchannel(subchannel);
+                    bw.Dispose();
                 }
             }
             catch
@@ -258,12 +366,179 @@ namespace Asmichi.ProcessManagement
                 }
                 if (stdOutRefAdded)
                 {
-                    stdOut.DangerousRelease();
+                    stdOut!.DangerousRelease();
                 }
                 if (stdErrRefAdded)
                 {
-                    stdErr.DangerousRelease();
+                    stdErr!.DangerousRelease();
+                }
+                for (int i = 0; i < extraHandlesRefAddedCount; i++)
+                {
+                    extraHandlesRefAdded[i].DangerousRelease();
+                }
+            }
+        }
+
+        private static int CountTeeHandles(IReadOnlyList<ChildProcessTeeSink>? sinks)
+        {
+            int count = 0;
+            if (sinks is not null)
+            {
+                foreach (var sink in sinks)
+                {
+                    count += sink.SpillHandle is null ? 1 : 2;
+                }
+            }
+            return count;
+        }
+
+        private static void WriteTeeSinks(ref MyBinaryWriter bw, IReadOnlyList<ChildProcessTeeSink>? sinks)
+        {
+            if (sinks is null)
+            {
+                bw.Write(0U);
+                return;
+            }
+
+            bw.Write((uint)sinks.Count);
+            foreach (var sink in sinks)
+            {
+                bw.Write((uint)sink.Backpressure);
+            }
+        }
+
+        // Writes the working directory, the file and argv.
+        private static void WriteCommandLine(ref MyBinaryWriter bw, in ChildProcessStartInfoInternal startInfo, string resolvedPath)
+        {
+            var arguments = startInfo.Arguments;
+
+            bw.Write(startInfo.WorkingDirectory);
+            bw.Write(resolvedPath);
+
+            bw.Write((uint)(arguments.Count + 1));
+            bw.Write(resolvedPath);
+            foreach (var x in arguments)
+            {
+                bw.Write(x);
+            }
+        }
+
+        private static void WriteEnvironmentVariables(ref MyBinaryWriter bw, in ChildProcessStartInfoInternal startInfo)
+        {
+            if (!startInfo.UseCustomEnvironmentVariables)
+            {
+                // Send the environment variables of this process to the helper process.
+                //
+                // NOTE: We cannot cache or detect updates to the environment block; only the runtime can.
+                //       Concurrently invoking getenv and setenv is a racy operation; therefore the runtime
+                //       employs a process-global lock.
+                //
+                //       Fortunately, the caller can take a snapshot of environment variables theirselves.
+                var processEnvVars = Environment.GetEnvironmentVariables();
+                var envVarCount = processEnvVars.Count;
+                bw.Write((uint)envVarCount);
+
+                var sortedEnvVars = ArrayPool<KeyValuePair<string, string>>.Shared.Rent(envVarCount);
+                try
+                {
+                    EnvironmentVariableListUtil.ToSortedKeyValuePairs(processEnvVars, sortedEnvVars);
+
+                    foreach (var (name, value) in sortedEnvVars.AsSpan<KeyValuePair<string, string>>().Slice(0, envVarCount))
+                    {
+                        bw.WriteEnvironmentVariable(name, value);
+                    }
                 }
+                finally
+                {
+                    ArrayPool<KeyValuePair<string, string>>.Shared.Return(sortedEnvVars);
+                }
+            }
+            else if (startInfo.EnvironmentVariablesContext is { } context)
+            {
+                bw.Write(EncodedContextEnvironmentVariables.GetValue(context, CachedEncodeEnvironmentVariablesDelegate));
+            }
+            else
+            {
+                WriteEnvironmentVariables(ref bw, startInfo.EnvironmentVariables.Span);
+            }
+        }
+
+        private static void WriteEnvironmentVariables(ref MyBinaryWriter bw, ReadOnlySpan<KeyValuePair<string, string>> environmentVariables)
+        {
+            bw.Write((uint)environmentVariables.Length);
+            foreach (var (name, value) in environmentVariables)
+            {
+                bw.WriteEnvironmentVariable(name, value);
+            }
+        }
+
+        private static byte[] EncodeEnvironmentVariables(ChildProcessCreationContext context)
+        {
+            var bw = new MyBinaryWriter(InitialBufferCapacity);
+            try
+            {
+                WriteEnvironmentVariables(ref bw, context.EnvironmentVariablesInternal.Span);
+                return bw.GetBuffer().ToArray();
+            }
+            finally
+            {
+                bw.Dispose();
+            }
+        }
+
+        private UnixChildProcessStateHolder SendSpawnRequest(
+            UnixChildProcessStateHolder stateHolder,
+            ReadOnlySpan<byte> body,
+            ReadOnlySpan<int> fds,
+            bool shouldReportTimings,
+            long startTimestamp)
+        {
+            // If the request fits in 16 KiB, the header, the body and the fds are sent with one sendmsg call (directly from the buffer of the writer)
+            // and the helper receives them with one recvmsg call. Otherwise the header and the fds are sent first, followed by the body.
+            // (If there are more fds than one sendmsg call can carry, they are sent in batches, each attached to a distinct byte of the header.)
+            //
+            // NOTE: On WSL 1, if you call recvmsg multiple times to fully receive data sent with sendmsg,
+            //       the fds will be duplicated for each recvmsg call (https://github.com/microsoft/WSL/issues/6490).
+            //       Hence the bytes carrying fds must always be received with one recvmsg call; see SubchannelSendRequest.
+            Span<byte> header = stackalloc byte[sizeof(uint) * 2];
+            if (!BitConverter.TryWriteBytes(header, (uint)UnixHelperProcessCommand.SpawnProcess)
+                || !BitConverter.TryWriteBytes(header.Slice(sizeof(uint)), body.Length))
+            {
+                Debug.Fail("Should never fail.");
+            }
+
+            var subchannel = _helperProcess.RentSubchannelAsync(default).AsTask().GetAwaiter().GetResult();
+
+            try
+            {
+                subchannel.SendRequest(header, body, fds);
+
+                var (error, processId) = subchannel.ReceiveCommonResponse();
+                if (error > 0)
+                {
+                    throw new Win32Exception(error);
+                }
+                else if (error < 0)
+                {
+                    throw new AsmichiChildProcessInternalLogicErrorException(
+                        string.Format(CultureInfo.InvariantCulture, "Internal logic error: Bad request {0}.", error));
+                }
+
+                stateHolder.State.SetProcessId(processId);
+
+                if (shouldReportTimings)
+                {
+                    Span<byte> timings = stackalloc byte[SpawnTimingsSize];
+                    subchannel.ReceiveExactBytes(timings);
+                    var elapsed = TimeSpan.FromTicks((long)((Stopwatch.GetTimestamp() - startTimestamp) * ((double)TimeSpan.TicksPerSecond / Stopwatch.Frequency)));
+                    stateHolder.State.SetStartupTimings(ParseStartupTimings(elapsed, timings));
+                }
+
+                return stateHolder;
+            }
+            finally
+            {
+                _helperProcess.ReturnSubchannel(subchannel);
             }
         }
 
@@ -300,6 +575,389 @@ namespace Asmichi.ProcessManagement
             }
         }
 
+        public void SignalAll(IReadOnlyList<IChildProcessState> states, ChildProcessSignal signal)
+        {
+            var signalNumber = UnixChildProcessState.ToHelperSignalNumber(signal);
+
+            int firstError = 0;
+            var tokens = ArrayPool<long>.Shared.Rent(Math.Min(states.Count, MaxSignalBulkTokenCount));
+            try
+            {
+                for (int start = 0; start < states.Count; start += MaxSignalBulkTokenCount)
+                {
+                    int count = Math.Min(states.Count - start, MaxSignalBulkTokenCount);
+                    for (int i = 0; i < count; i++)
+                    {
+                        tokens[i] = ((UnixChildProcessState)states[start + i]).Token;
+                    }
+
+                    int err = SendSignalBulk(tokens.AsSpan(0, count), signalNumber);
+                    if (firstError == 0)
+                    {
+                        firstError = err;
+                    }
+                }
+            }
+            finally
+            {
+                ArrayPool<long>.Shared.Return(tokens);
+            }
+
+            if (firstError != 0)
+            {
+                throw new Win32Exception(firstError);
+            }
+        }
+
+        // Returns the first error (or 0 if all succeeded).
+        private int SendSignalBulk(ReadOnlySpan<long> tokens, UnixHelperProcessSignalNumber signalNumber)
+        {
+            using var bw = new MyBinaryWriter(sizeof(uint) * 2 + sizeof(long) * tokens.Length);
+            bw.Write((uint)signalNumber);
+            bw.Write((uint)tokens.Length);
+            foreach (var token in tokens)
+            {
+                bw.Write(token);
+            }
+
+            Span<byte> header = stackalloc byte[sizeof(uint) * 2];
+            if (!BitConverter.TryWriteBytes(header, (uint)UnixHelperProcessCommand.SignalProcessBulk)
+                || !BitConverter.TryWriteBytes(header.Slice(sizeof(uint)), bw.Length))
+            {
+                Debug.Fail("Should never fail.");
+            }
+
+            var subchannel = _helperProcess.RentSubchannelAsync(default).AsTask().GetAwaiter().GetResult();
+            try
+            {
+                subchannel.SendRequest(header, bw.GetBuffer(), default);
+
+                var (error, failureCount) = subchannel.ReceiveCommonResponse();
+                if (error > 0)
+                {
+                    throw new Win32Exception(error);
+                }
+                else if (error < 0)
+                {
+                    throw new AsmichiChildProcessInternalLogicErrorException(
+                        string.Format(CultureInfo.InvariantCulture, "Internal logic error: Bad request {0}.", error));
+                }
+
+                if (failureCount == 0)
+                {
+                    return 0;
+                }
+
+                // Receive all failures to keep the subchannel in sync, but report only the first one.
+                var failuresLength = failureCount * SignalBulkFailureSize;
+                var failures = ArrayPool<byte>.Shared.Rent(failuresLength);
+                try
+                {
+                    subchannel.ReceiveExactBytes(failures.AsSpan(0, failuresLength));
+                    return BitConverter.ToInt32(failures, sizeof(uint));
+                }
+                finally
+                {
+                    ArrayPool<byte>.Shared.Return(failures);
+                }
+            }
+            finally
+            {
+                _helperProcess.ReturnSubchannel(subchannel);
+            }
+        }
+
+        public void CreateJob(long token, ChildProcessJobFlags flags)
+        {
+            Span<byte> body = stackalloc byte[sizeof(long) + sizeof(uint)];
+            if (!BitConverter.TryWriteBytes(body, token)
+                || !BitConverter.TryWriteBytes(body.Slice(sizeof(long)), (flags & ChildProcessJobFlags.KillOnClose) != 0 ? JobFlagsKillOnClose : 0U))
+            {
+                Debug.Fail("Should never fail.");
+            }
+
+            SendSimpleRequest(UnixHelperProcessCommand.CreateJob, body, default);
+        }
+
+        public void SignalJob(long token, ChildProcessSignal signal)
+        {
+            Span<byte> body = stackalloc byte[sizeof(long) + sizeof(uint)];
+            if (!BitConverter.TryWriteBytes(body, token)
+                || !BitConverter.TryWriteBytes(body.Slice(sizeof(long)), (uint)UnixChildProcessState.ToHelperSignalNumber(signal)))
+            {
+                Debug.Fail("Should never fail.");
+            }
+
+            SendSimpleRequest(UnixHelperProcessCommand.SignalJob, body, default);
+        }
+
+        public ChildProcessJobStatistics GetJobStatistics(long token)
+        {
+            Span<byte> body = stackalloc byte[sizeof(long)];
+            if (!BitConverter.TryWriteBytes(body, token))
+            {
+                Debug.Fail("Should never fail.");
+            }
+
+            // NOTE: Make sure to sync with the helper (JobStatistics).
+            Span<byte> response = stackalloc byte[JobStatisticsSize];
+            SendSimpleRequest(UnixHelperProcessCommand.GetJobStatistics, body, response);
+
+            return new ChildProcessJobStatistics(
+                activeProcessCount: (int)BitConverter.ToUInt32(response),
+                totalProcessCount: (int)BitConverter.ToUInt32(response.Slice(4)),
+                totalUserProcessorTime: TimeSpan.FromTicks(BitConverter.ToInt64(response.Slice(8)) * 10),
+                totalPrivilegedProcessorTime: TimeSpan.FromTicks(BitConverter.ToInt64(response.Slice(16)) * 10),
+                peakResidentSetSize: BitConverter.ToInt64(response.Slice(24)));
+        }
+
+        public void CloseJob(long token)
+        {
+            Span<byte> body = stackalloc byte[sizeof(long)];
+            if (!BitConverter.TryWriteBytes(body, token))
+            {
+                Debug.Fail("Should never fail.");
+            }
+
+            SendSimpleRequest(UnixHelperProcessCommand.CloseJob, body, default);
+        }
+
+        public void CreateOutputMultiplexer(long token, SafeHandle sink)
+        {
+            Span<byte> body = stackalloc byte[sizeof(long)];
+            if (!BitConverter.TryWriteBytes(body, token))
+            {
+                Debug.Fail("Should never fail.");
+            }
+
+            bool refAdded = false;
+            try
+            {
+                sink.DangerousAddRef(ref refAdded);
+                Span<int> fds = stackalloc int[1] { sink.DangerousGetHandle().ToInt32() };
+                SendSimpleRequest(UnixHelperProcessCommand.CreateOutputMultiplexer, body, default, fds);
+            }
+            finally
+            {
+                if (refAdded)
+                {
+                    sink.DangerousRelease();
+                }
+            }
+        }
+
+        public void CloseOutputMultiplexer(long token)
+        {
+            Span<byte> body = stackalloc byte[sizeof(long)];
+            if (!BitConverter.TryWriteBytes(body, token))
+            {
+                Debug.Fail("Should never fail.");
+            }
+
+            SendSimpleRequest(UnixHelperProcessCommand.CloseOutputMultiplexer, body, default);
+        }
+
+        // Sends a request without fds and receives the common response followed by `response.Length` bytes (on success).
+        private void SendSimpleRequest(UnixHelperProcessCommand command, ReadOnlySpan<byte> body, Span<byte> response) =>
+            SendSimpleRequest(command, body, response, default);
+
+        // Same as above, with fds attached to the request.
+        private void SendSimpleRequest(UnixHelperProcessCommand command, ReadOnlySpan<byte> body, Span<byte> response, ReadOnlySpan<int> fds)
+        {
+            Span<byte> header = stackalloc byte[sizeof(uint) * 2];
+            if (!BitConverter.TryWriteBytes(header, (uint)command)
+                || !BitConverter.TryWriteBytes(header.Slice(sizeof(uint)), body.Length))
+            {
+                Debug.Fail("Should never fail.");
+            }
+
+            var subchannel = _helperProcess.RentSubchannelAsync(default).AsTask().GetAwaiter().GetResult();
+            try
+            {
+                subchannel.SendRequest(header, body, fds);
+
+                var (error, _) = subchannel.ReceiveCommonResponse();
+                if (error > 0)
+                {
+                    throw new Win32Exception(error);
+                }
+                else if (error < 0)
+                {
+                    throw new AsmichiChildProcessInternalLogicErrorException(
+                        string.Format(CultureInfo.InvariantCulture, "Internal logic error: Bad request {0}.", error));
+                }
+
+                if (response.Length != 0)
+                {
+                    subchannel.ReceiveExactBytes(response);
+                }
+            }
+            finally
+            {
+                _helperProcess.ReturnSubchannel(subchannel);
+            }
+        }
+
+        public ChildProcessHelperStatistics GetHelperStatistics()
+        {
+            Span<byte> header = stackalloc byte[sizeof(uint) * 2];
+            if (!BitConverter.TryWriteBytes(header, (uint)UnixHelperProcessCommand.GetStatistics)
+                || !BitConverter.TryWriteBytes(header.Slice(sizeof(uint)), 0U))
+            {
+                Debug.Fail("Should never fail.");
+            }
+
+            byte[]? buf = null;
+            var subchannel = _helperProcess.RentSubchannelAsync(default).AsTask().GetAwaiter().GetResult();
+            try
+            {
+                subchannel.SendRequest(header, default, default);
+
+                var (error, length) = subchannel.ReceiveCommonResponse();
+                if (error > 0)
+                {
+                    throw new Win32Exception(error);
+                }
+                else if (error < 0)
+                {
+                    throw new AsmichiChildProcessInternalLogicErrorException(
+                        string.Format(CultureInfo.InvariantCulture, "Internal logic error: Bad request {0}.", error));
+                }
+
+                buf = ArrayPool<byte>.Shared.Rent(length);
+                subchannel.ReceiveExactBytes(buf.AsSpan(0, length));
+                return ParseHelperStatistics(buf.AsSpan(0, length));
+            }
+            finally
+            {
+                _helperProcess.ReturnSubchannel(subchannel);
+                if (buf is not null)
+                {
+                    ArrayPool<byte>.Shared.Return(buf);
+                }
+            }
+        }
+
+        public void WriteHelperTrace(Stream destination)
+        {
+            Span<byte> header = stackalloc byte[sizeof(uint) * 2];
+            if (!BitConverter.TryWriteBytes(header, (uint)UnixHelperProcessCommand.DumpTrace)
+                || !BitConverter.TryWriteBytes(header.Slice(sizeof(uint)), 0U))
+            {
+                Debug.Fail("Should never fail.");
+            }
+
+            byte[]? buf = null;
+            UnixSubchannel? subchannel = _helperProcess.RentSubchannelAsync(default).AsTask().GetAwaiter().GetResult();
+            try
+            {
+                subchannel.SendRequest(header, default, default);
+
+                var (error, length) = subchannel.ReceiveCommonResponse();
+                if (error > 0)
+                {
+                    throw new Win32Exception(error);
+                }
+                else if (error < 0)
+                {
+                    throw new AsmichiChildProcessInternalLogicErrorException(
+                        string.Format(CultureInfo.InvariantCulture, "Internal logic error: Bad request {0}.", error));
+                }
+
+                // Receive the whole trace before writing to the destination so that a failing destination does not leave the subchannel broken.
+                buf = ArrayPool<byte>.Shared.Rent(length);
+                subchannel.ReceiveExactBytes(buf.AsSpan(0, length));
+                _helperProcess.ReturnSubchannel(subchannel);
+                subchannel = null;
+
+                destination.Write(buf, 0, length);
+            }
+            finally
+            {
+                if (subchannel is not null)
+                {
+                    _helperProcess.ReturnSubchannel(subchannel);
+                }
+                if (buf is not null)
+                {
+                    ArrayPool<byte>.Shared.Return(buf);
+                }
+            }
+        }
+
+        // NOTE: Make sure to sync with the helper. See Protocol.md.
+        private static ChildProcessStartupTimings ParseStartupTimings(TimeSpan total, ReadOnlySpan<byte> data)
+        {
+            return new ChildProcessStartupTimings(
+                total,
+                requestReceivedTimestamp: BitConverter.ToInt64(data),
+                forkReturnedTimestamp: BitConverter.ToInt64(data.Slice(sizeof(long))),
+                childReleasedTimestamp: BitConverter.ToInt64(data.Slice(sizeof(long) * 2)),
+                execConfirmedTimestamp: BitConverter.ToInt64(data.Slice(sizeof(long) * 3)));
+        }
+
+        // NOTE: Make sure to sync with the helper. See Protocol.md.
+        private static ChildProcessHelperStatistics ParseHelperStatistics(ReadOnlySpan<byte> data)
+        {
+            var spawnCount = ReadInt64(ref data);
+            var spawnFailureCount = ReadInt64(ref data);
+            var liveChildCount = ReadInt64(ref data);
+            var subchannelCount = ReadInt64(ref data);
+            var pendingNotificationBytes = ReadInt64(ref data);
+            var notificationQueueDepth = ReadInt64(ref data);
+            var maxNotificationBatchSize = ReadInt64(ref data);
+            var reapCount = ReadInt64(ref data);
+            var orphanReapCount = ReadInt64(ref data);
+            var spawnLatencyHistogram = ReadHistogram(ref data);
+            var reapBatchSizeHistogram = ReadHistogram(ref data);
+
+            var errnoCount = ReadInt32(ref data);
+            var spawnFailuresByErrorCode = new Dictionary<int, long>(errnoCount);
+            for (int i = 0; i < errnoCount; i++)
+            {
+                var errno = ReadInt32(ref data);
+                spawnFailuresByErrorCode[errno] = ReadInt64(ref data);
+            }
+
+            return new ChildProcessHelperStatistics(
+                spawnCount,
+                spawnFailureCount,
+                liveChildCount,
+                subchannelCount,
+                pendingNotificationBytes,
+                notificationQueueDepth,
+                maxNotificationBatchSize,
+                reapCount,
+                orphanReapCount,
+                spawnLatencyHistogram,
+                reapBatchSizeHistogram,
+                spawnFailuresByErrorCode);
+
+            static long[] ReadHistogram(ref ReadOnlySpan<byte> data)
+            {
+                var histogram = new long[ReadInt32(ref data)];
+                for (int i = 0; i < histogram.Length; i++)
+                {
+                    histogram[i] = ReadInt64(ref data);
+                }
+                return histogram;
+            }
+
+            static int ReadInt32(ref ReadOnlySpan<byte> data)
+            {
+                var value = BitConverter.ToInt32(data);
+                data = data.Slice(sizeof(int));
+                return value;
+            }
+
+            static long ReadInt64(ref ReadOnlySpan<byte> data)
+            {
+                var value = BitConverter.ToInt64(data);
+                data = data.Slice(sizeof(long));
+                return value;
+            }
+        }
+
         public void RequestAsyncTermination(long token)
         {
             // Succeeds unless _terminationRequests has been completed.
@@ -384,5 +1042,18 @@ namespace Asmichi.ProcessManagement
             public int ProcessID;
             public int Status;
         }
+
+        // The command line and (if custom) the environment variables of a spawn request, encoded once.
+        private sealed class PreparedSpawnRequest
+        {
+            public PreparedSpawnRequest(byte[] encoded, bool hasEnvironmentVariables)
+            {
+                Encoded = encoded;
+                HasEnvironmentVariables = hasEnvironmentVariables;
+            }
+
+            public byte[] Encoded { get; }
+            public bool HasEnvironmentVariables { get; }
+        }
     }
 }
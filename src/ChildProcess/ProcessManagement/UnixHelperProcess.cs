@@ -21,6 +21,15 @@ namespace Asmichi.ProcessManagement
     {
         SpawnProcess = 0,
         SignalProcess = 1,
+        SignalProcessBulk = 2,
+        CreateJob = 3,
+        SignalJob = 4,
+        GetJobStatistics = 5,
+        CloseJob = 6,
+        GetStatistics = 7,
+        DumpTrace = 8,
+        CreateOutputMultiplexer = 9,
+        CloseOutputMultiplexer = 10,
     }
 
     // NOTE: Make sure to sync with the helper.
@@ -31,11 +40,17 @@ namespace Asmichi.ProcessManagement
     }
 
     // NOTE: Make sure to sync with the helper.
+    // NOTE: Values are the signal numbers on Linux x86_64 regardless of the platform; the helper translates them.
     internal enum UnixHelperProcessSignalNumber : uint
     {
+        Hangup = 1,
         Interrupt = 2,
         Kill = 9,
+        User1 = 10,
+        User2 = 12,
         Termination = 15,
+        Continue = 18,
+        Stop = 19,
     }
 
     internal sealed class UnixHelperProcess : IDisposable
@@ -162,7 +177,7 @@ namespace Asmichi.ProcessManagement
             }
         }
 
-        public static UnixHelperProcess Launch(int maxSubchannelCount)
+        public static UnixHelperProcess Launch(int maxSubchannelCount, bool enableSubreaper)
         {
             if (maxSubchannelCount < 1)
             {
@@ -172,7 +187,8 @@ namespace Asmichi.ProcessManagement
             var pipePath = UnixFilePal.CreateUniqueSocketPath();
 
             using var listeningSocket = UnixFilePal.CreateListeningDomainSocket(pipePath, 1);
-            var psi = new ProcessStartInfo(HelperPath, Invariant($"\"{pipePath}\""))
+            var arguments = Invariant($"\"{pipePath}\"") + (enableSubreaper ? " --subreaper" : "");
+            var psi = new ProcessStartInfo(HelperPath, arguments)
             {
                 RedirectStandardInput = true,
                 RedirectStandardError = false,
@@ -35,6 +35,14 @@ namespace Asmichi.ProcessManagement
             }
         }
 
+        public unsafe void ReceiveExactBytes(Span<byte> buffer)
+        {
+            fixed (byte* pBuffer = buffer)
+            {
+                RecvExactBytes(pBuffer, (uint)buffer.Length);
+            }
+        }
+
         public unsafe void SendExactBytes(ReadOnlySpan<byte> buffer)
         {
             CheckNotDisposed();
@@ -50,19 +58,22 @@ namespace Asmichi.ProcessManagement
             }
         }
 
-        public unsafe void SendExactBytesAndFds(ReadOnlySpan<byte> buffer, ReadOnlySpan<int> fds)
+        public unsafe void SendRequest(ReadOnlySpan<byte> header, ReadOnlySpan<byte> body, ReadOnlySpan<int> fds)
         {
             CheckNotDisposed();
 
-            fixed (byte* pBuffer = buffer)
+            fixed (byte* pHeader = header)
             {
-                fixed (int* pFds = fds)
+                fixed (byte* pBody = body)
                 {
-                    if (!LibChildProcess.SubchannelSendExactBytesAndFds(
-                        _handle, pBuffer, (uint)buffer.Length, pFds, (uint)fds.Length))
+                    fixed (int* pFds = fds)
                     {
-                        var err = Marshal.GetLastWin32Error();
-                        ThrowFatalCommnicationError(err);
+                        if (!LibChildProcess.SubchannelSendRequest(
+                            _handle, pHeader, (uint)header.Length, pBody, (uint)body.Length, pFds, (uint)fds.Length))
+                        {
+                            var err = Marshal.GetLastWin32Error();
+                            ThrowFatalCommnicationError(err);
+                        }
                     }
                 }
             }
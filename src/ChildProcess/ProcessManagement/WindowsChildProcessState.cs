@@ -4,6 +4,7 @@ using System;
 using System.ComponentModel;
 using System.Diagnostics;
 using System.Threading;
+using System.Threading.Tasks;
 using Asmichi.Interop.Windows;
 using Microsoft.Win32.SafeHandles;
 
@@ -84,6 +85,16 @@ namespace Asmichi.ProcessManagement
         public int ExitCode => GetExitCode();
         public WaitHandle ExitedWaitHandle => _exitedWaitHandle;
         public bool HasExitCode => _hasExitCode;
+        public ChildProcessStartupTimings? StartupTimings => null;
+
+        public bool WaitForExit(TimeSpan timeout) => _exitedWaitHandle.WaitOne(timeout);
+
+        public Task<bool> WaitForExitAsync(TimeSpan timeout, CancellationToken cancellationToken) =>
+            WaitAsyncOperation.Start(_exitedWaitHandle, timeout, cancellationToken).Completion;
+
+        public void RegisterExitedCallback(Action<object?> callback, object? state) =>
+            WaitAsyncOperation.Start(_exitedWaitHandle, Timeout.InfiniteTimeSpan, default).Completion.ContinueWith(
+                (_, s) => callback(s), state, CancellationToken.None, TaskContinuationOptions.ExecuteSynchronously, TaskScheduler.Default);
 
         // Pre: The process has exited. Otherwise we will end up getting STILL_ACTIVE (259).
         public void DangerousRetrieveExitCode()
@@ -181,5 +192,23 @@ namespace Asmichi.ProcessManagement
                 throw new Win32Exception();
             }
         }
+
+        public void SendSignal(ChildProcessSignal signal)
+        {
+            switch (signal)
+            {
+                case ChildProcessSignal.Interrupt:
+                    SignalInterrupt();
+                    break;
+                case ChildProcessSignal.Termination:
+                    SignalTermination();
+                    break;
+                case ChildProcessSignal.Kill:
+                    Kill();
+                    break;
+                default:
+                    throw new PlatformNotSupportedException($"{signal} is not supported on Windows.");
+            }
+        }
     }
 }
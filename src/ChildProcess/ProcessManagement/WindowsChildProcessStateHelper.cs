@@ -1,10 +1,13 @@
 // Copyright (c) @asmichi (https://github.com/asmichi). Licensed under the MIT License. See LICENCE in the project root for details.
 
 using System;
+using System.Collections.Generic;
 using System.ComponentModel;
 using System.Diagnostics;
 using System.Globalization;
 using System.IO;
+using System.Runtime.CompilerServices;
+using System.Runtime.ExceptionServices;
 using System.Runtime.InteropServices;
 using System.Text;
 using System.Threading;
@@ -25,23 +28,60 @@ namespace Asmichi.ProcessManagement
             Environment.GetFolderPath(Environment.SpecialFolder.System, Environment.SpecialFolderOption.DoNotVerify),
             "chcp.com");
 
+        // The environment block of each ChildProcessCreationContext. CreateProcess does not modify the environment block.
+        private static readonly ConditionalWeakTable<ChildProcessCreationContext, char[]> ContextEnvironmentBlocks =
+            new ConditionalWeakTable<ChildProcessCreationContext, char[]>();
+        private static readonly ConditionalWeakTable<ChildProcessCreationContext, char[]>.CreateValueCallback CachedMakeEnvironmentBlockDelegate =
+            context => WindowsEnvironmentBlockUtil.MakeEnvironmentBlock(context.EnvironmentVariablesInternal.Span);
+
         public void Dispose()
         {
         }
 
         public void ValidatePlatformSpecificStartInfo(in ChildProcessStartInfoInternal startInfo)
         {
+            if (startInfo.ExtraFileDescriptors.Count != 0)
+            {
+                throw new PlatformNotSupportedException(
+                    $"{nameof(ChildProcessStartInfo)}.{nameof(ChildProcessStartInfo.ExtraFileDescriptors)} is not supported on Windows.");
+            }
+            if (startInfo.Job is not null)
+            {
+                throw new PlatformNotSupportedException(
+                    $"{nameof(ChildProcessStartInfo)}.{nameof(ChildProcessStartInfo.Job)} is not supported on Windows.");
+            }
+            if (startInfo.StdOutputRedirection == OutputRedirection.Multiplexer || startInfo.StdErrorRedirection == OutputRedirection.Multiplexer)
+            {
+                throw new PlatformNotSupportedException(
+                    $"{nameof(OutputRedirection)}.{nameof(OutputRedirection.Multiplexer)} is not supported on Windows.");
+            }
+            if (startInfo.StdOutputRedirection == OutputRedirection.MemoryCapture || startInfo.StdErrorRedirection == OutputRedirection.MemoryCapture)
+            {
+                throw new PlatformNotSupportedException(
+                    $"{nameof(OutputRedirection)}.{nameof(OutputRedirection.MemoryCapture)} is not supported on Windows.");
+            }
+            if (startInfo.StdOutputRedirection == OutputRedirection.Tee || startInfo.StdErrorRedirection == OutputRedirection.Tee)
+            {
+                throw new PlatformNotSupportedException(
+                    $"{nameof(OutputRedirection)}.{nameof(OutputRedirection.Tee)} is not supported on Windows.");
+            }
         }
 
+        public object PrepareSpawnRequest(in ChildProcessStartInfoInternal startInfo, string resolvedPath) =>
+            new PreparedSpawnRequest(
+                MakeCommandLine(in startInfo, resolvedPath).ToString(),
+                MakeEnvironmentBlock(in startInfo));
+
         public unsafe IChildProcessStateHolder SpawnProcess(
             ref ChildProcessStartInfoInternal startInfo,
             string resolvedPath,
+            object? preparedRequest,
             SafeHandle stdIn,
-            SafeHandle stdOut,
-            SafeHandle stdErr)
+            SafeHandle? stdOut,
+            SafeHandle? stdErr,
+            IReadOnlyList<ChildProcessTeeSink>? stdOutTeeSinks,
+            IReadOnlyList<ChildProcessTeeSink>? stdErrTeeSinks)
         {
-            var arguments = startInfo.Arguments;
-            var environmentVariables = startInfo.EnvironmentVariables;
             var workingDirectory = startInfo.WorkingDirectory;
             var flags = startInfo.Flags;
 
@@ -58,8 +98,19 @@ namespace Asmichi.ProcessManagement
                 throw new ChildProcessStartingBlockedException("Execution of 'cmd.exe' without DisableArgumentQuoting was blocked. See the description of ChildProcessStartingBlockedException.");
             }
 
-            var commandLine = WindowsCommandLineUtil.MakeCommandLine(resolvedPath, arguments ?? Array.Empty<string>(), !flags.HasDisableArgumentQuoting());
-            var environmentBlock = startInfo.UseCustomEnvironmentVariables ? WindowsEnvironmentBlockUtil.MakeEnvironmentBlock(environmentVariables.Span) : null;
+            StringBuilder commandLine;
+            char[]? environmentBlock;
+            if (preparedRequest is PreparedSpawnRequest prepared)
+            {
+                // CreateProcess may modify the command line; give it a fresh copy. The environment block is read-only.
+                commandLine = new StringBuilder(prepared.CommandLine);
+                environmentBlock = prepared.EnvironmentBlock;
+            }
+            else
+            {
+                commandLine = MakeCommandLine(in startInfo, resolvedPath);
+                environmentBlock = MakeEnvironmentBlock(in startInfo);
+            }
 
             // Objects that need to be disposed on error
             InputWriterOnlyPseudoConsole? pseudoConsole = null;
@@ -159,6 +210,71 @@ namespace Asmichi.ProcessManagement
             }
         }
 
+        // Sends a signal to each process; the first failure is rethrown after all the processes have been signaled.
+        public void SignalAll(IReadOnlyList<IChildProcessState> states, ChildProcessSignal signal)
+        {
+            // Windows has no bulk operation; signal one by one.
+            ExceptionDispatchInfo? firstError = null;
+            foreach (var state in states)
+            {
+                try
+                {
+                    state.SendSignal(signal);
+                }
+                catch (Win32Exception ex)
+                {
+                    firstError ??= ExceptionDispatchInfo.Capture(ex);
+                }
+            }
+
+            firstError?.Throw();
+        }
+
+        // ChildProcessJob is a process-group-based concept. Windows job objects are used internally (one per process)
+        // for kill-on-close and do not nest on older versions of Windows.
+        public void CreateJob(long token, ChildProcessJobFlags flags) =>
+            throw new PlatformNotSupportedException($"{nameof(ChildProcessJob)} is not supported on Windows.");
+
+        public void SignalJob(long token, ChildProcessSignal signal) =>
+            throw new AsmichiChildProcessInternalLogicErrorException();
+
+        public ChildProcessJobStatistics GetJobStatistics(long token) =>
+            throw new AsmichiChildProcessInternalLogicErrorException();
+
+        public void CloseJob(long token) =>
+            throw new AsmichiChildProcessInternalLogicErrorException();
+
+        public void CreateOutputMultiplexer(long token, SafeHandle sink) =>
+            throw new PlatformNotSupportedException($"{nameof(ChildProcessOutputMultiplexer)} is not supported on Windows.");
+
+        public void CloseOutputMultiplexer(long token) =>
+            throw new AsmichiChildProcessInternalLogicErrorException();
+
+        public ChildProcessHelperStatistics GetHelperStatistics() =>
+            throw new PlatformNotSupportedException("There is no helper process on Windows.");
+
+        public void WriteHelperTrace(Stream destination) =>
+            throw new PlatformNotSupportedException("There is no helper process on Windows.");
+
+        private static StringBuilder MakeCommandLine(in ChildProcessStartInfoInternal startInfo, string resolvedPath) =>
+            WindowsCommandLineUtil.MakeCommandLine(resolvedPath, startInfo.Arguments ?? Array.Empty<string>(), !startInfo.Flags.HasDisableArgumentQuoting());
+
+        private static char[]? MakeEnvironmentBlock(in ChildProcessStartInfoInternal startInfo)
+        {
+            if (!startInfo.UseCustomEnvironmentVariables)
+            {
+                return null;
+            }
+            else if (startInfo.EnvironmentVariablesContext is { } context)
+            {
+                return ContextEnvironmentBlocks.GetValue(context, CachedMakeEnvironmentBlockDelegate);
+            }
+            else
+            {
+                return WindowsEnvironmentBlockUtil.MakeEnvironmentBlock(startInfo.EnvironmentVariables.Span);
+            }
+        }
+
         // Change the code page of the specified pseudo console by invoking chcp.com on it.
         private static unsafe void ChangeCodePage(
             InputWriterOnlyPseudoConsole pseudoConsole,
@@ -323,5 +439,17 @@ namespace Asmichi.ProcessManagement
                 throw new AsmichiChildProcessInternalLogicErrorException();
             }
         }
+
+        private sealed class PreparedSpawnRequest
+        {
+            public PreparedSpawnRequest(string commandLine, char[]? environmentBlock)
+            {
+                CommandLine = commandLine;
+                EnvironmentBlock = environmentBlock;
+            }
+
+            public string CommandLine { get; }
+            public char[]? EnvironmentBlock { get; }
+        }
     }
 }
@@ -0,0 +1,156 @@
+// Copyright (c) @asmichi (https://github.com/asmichi). Licensed under the MIT License. See LICENCE in the project root for details.
+
+using System;
+using System.Buffers;
+using System.Diagnostics;
+
+namespace Asmichi.Utilities
+{
+    /// <summary>
+    /// <para>
+    /// Splits a byte stream into lines terminated by LF or CRLF, without decoding or copying each line.
+    /// </para>
+    /// <para>
+    /// Usage: Fill <see cref="GetReadBuffer"/> and call <see cref="Advance"/> (0 for EOF), then drain lines with <see cref="TryReadLine"/>.
+    /// A line is valid until the next <see cref="GetReadBuffer"/> call.
+    /// </para>
+    /// </summary>
+    internal sealed class LineSplitter : IDisposable
+    {
+        private readonly int _maxLineLength;
+        // Enough to tell whether a line fits in _maxLineLength: the content, CR and LF.
+        private readonly int _maxScanLength;
+        private byte[] _buffer;
+        // Data not consumed yet is [_start, _end).
+        private int _start;
+        private int _end;
+        // [_start, _start + _scanned) is known to contain no LF. At most _maxScanLength.
+        private int _scanned;
+        private bool _isCompleted;
+
+        public LineSplitter(int initialBufferSize, int maxLineLength)
+        {
+            Debug.Assert(initialBufferSize > 0);
+            Debug.Assert(maxLineLength > 0 && maxLineLength <= int.MaxValue - 2);
+
+            _maxLineLength = maxLineLength;
+            _maxScanLength = maxLineLength + 2;
+            _buffer = ArrayPool<byte>.Shared.Rent(Math.Min(initialBufferSize, _maxScanLength));
+        }
+
+        public void Dispose()
+        {
+            if (_buffer != null)
+            {
+                ArrayPool<byte>.Shared.Return(_buffer);
+                _buffer = null!;
+            }
+        }
+
+        /// <summary>
+        /// Gets whether EOF has been reported and all lines have been read.
+        /// </summary>
+        public bool IsCompleted => _isCompleted && _start == _end;
+
+        /// <summary>
+        /// Returns the free space to read data into, compacting or growing the buffer if necessary.
+        /// Invalidates the lines previously returned.
+        /// </summary>
+        /// <returns>The free space to read data into.</returns>
+        public Memory<byte> GetReadBuffer()
+        {
+            Debug.Assert(!_isCompleted);
+
+            if (_end == _buffer.Length)
+            {
+                var length = _end - _start;
+                if (length * 2 > _buffer.Length && _buffer.Length < _maxScanLength)
+                {
+                    // More than a half of the buffer is occupied by an incomplete line. Grow it.
+                    var newBuffer = ArrayPool<byte>.Shared.Rent((int)Math.Min(_buffer.Length * 2L, _maxScanLength));
+                    _buffer.AsSpan(_start, length).CopyTo(newBuffer);
+                    ArrayPool<byte>.Shared.Return(_buffer);
+                    _buffer = newBuffer;
+                }
+                else
+                {
+                    _buffer.AsSpan(_start, length).CopyTo(_buffer);
+                }
+
+                _start = 0;
+                _end = length;
+            }
+
+            return _buffer.AsMemory(_end);
+        }
+
+        /// <summary>
+        /// Reports the number of bytes read into the buffer returned by <see cref="GetReadBuffer"/>.
+        /// </summary>
+        /// <param name="count">The number of bytes read. 0 indicates EOF.</param>
+        public void Advance(int count)
+        {
+            Debug.Assert(count >= 0 && count <= _buffer.Length - _end);
+
+            if (count == 0)
+            {
+                _isCompleted = true;
+            }
+
+            _end += count;
+        }
+
+        /// <summary>
+        /// Reads the next line (excluding the line terminator) if available.
+        /// A line longer than the maximum line length is split into chunks of the maximum line length.
+        /// After EOF, the last line without a terminator is also returned.
+        /// </summary>
+        /// <param name="line">The line.</param>
+        /// <returns><see langword="true"/> if a line is returned; <see langword="false"/> if more data is needed (or <see cref="IsCompleted"/>).</returns>
+        public bool TryReadLine(out ReadOnlyMemory<byte> line)
+        {
+            var pending = _buffer.AsSpan(_start, _end - _start);
+            var scanned = pending.Slice(0, Math.Min(pending.Length, _maxScanLength));
+
+            // Vectorized by the runtime.
+            var lfIndex = scanned.Slice(_scanned).IndexOf((byte)'\n');
+            if (lfIndex >= 0)
+            {
+                var lineLength = _scanned + lfIndex;
+                var contentLength = lineLength > 0 && pending[lineLength - 1] == (byte)'\r' ? lineLength - 1 : lineLength;
+                if (contentLength <= _maxLineLength)
+                {
+                    line = _buffer.AsMemory(_start, contentLength);
+                    Consume(lineLength + 1);
+                    return true;
+                }
+            }
+            else if (pending.Length == 0 || (!_isCompleted && scanned.Length < _maxScanLength))
+            {
+                // Need more data to tell the end of the line.
+                _scanned = scanned.Length;
+                line = default;
+                return false;
+            }
+
+            // The line is too long, or the last line without a terminator.
+            var chunkLength = Math.Min(pending.Length, _maxLineLength);
+            line = _buffer.AsMemory(_start, chunkLength);
+            Consume(chunkLength);
+            return true;
+        }
+
+        private void Consume(int count)
+        {
+            _start += count;
+            _scanned = 0;
+
+            if (_start == _end)
+            {
+                // Avoid compaction when possible.
+                _start = 0;
+                _end = 0;
+            }
+        }
+    }
+}
@@ -49,6 +49,13 @@ namespace Asmichi.Utilities
             _pos += size;
         }
 
+        // Write raw bytes (typically encoded by another MyBinaryWriter).
+        public void Write(ReadOnlySpan<byte> value)
+        {
+            value.CopyTo(EnsureBufferFor(value.Length));
+            _pos += value.Length;
+        }
+
         // Write a length-prefixed NUL-terminated sequence of UTF-8 code units.
         public void Write(string? value)
         {